@@ -130,6 +130,27 @@ def get_option(env_varname, config_option, default=None, required=False):
     return opt or default
 
 
+def get_cache_dir(env_varname, config_option, name):
+    """Return the directory of an on-disk cache, or None if it is disabled.
+
+    The directory is taken from the environment variable, then from
+    piglit.conf, and defaults to $XDG_CACHE_HOME/piglit/<name>. Unlike
+    get_option an empty value is not replaced by the default, setting either
+    one to an empty value disables the cache.
+
+    """
+    directory = os.environ.get(env_varname)
+    if directory is None:
+        directory = PIGLIT_CONFIG.safe_get(*config_option)
+    if directory is None:
+        directory = os.path.join(
+            os.environ.get('XDG_CACHE_HOME') or os.path.expanduser('~/.cache'),
+            'piglit', name)
+    if not directory:
+        return None
+    return os.path.expanduser(directory)
+
+
 def check_dir(dirname, failifexists=False, handler=None):
     """Check for the existence of a directory and create it if possible.
 
@@ -28,6 +28,7 @@ that you have a group of tests you want to run, here are the names of those
 tests, and the Test instance.
 """
 
+import array
 import ast
 import collections
 import contextlib
@@ -35,10 +36,13 @@ import copy
 import gzip
 import importlib
 import itertools
+import mmap
 import multiprocessing
 import multiprocessing.dummy
 import os
 import re
+import struct
+import sys
 import xml.etree.ElementTree as et
 
 from framework import grouptools, exceptions, status
@@ -298,23 +302,8 @@ class Filters(collections.abc.MutableSequence):
                 yield k, v
 
 
-def make_test(element):
-    """Rebuild a test instance from xml."""
-    def process(elem, opt):
-        k = elem.attrib['name']
-        v = elem.attrib['value']
-        try:
-            opt[k] = ast.literal_eval(v)
-        except ValueError:
-            opt[k] = v
-
-    type_ = element.attrib['type']
-    options = {}
-    for e in element.findall('./option'):
-        process(e, options)
-    options['env'] = {e.attrib['name']: e.attrib['value']
-                      for e in element.findall('./environment/env')}
-
+def _make_test(type_, options):
+    """Rebuild a test instance from its serialized type and options."""
     if type_ == 'gl':
         return PiglitGLTest(**options)
     if type_ == 'gl_builtin':
@@ -332,11 +321,6 @@ def make_test(element):
     if type_ == 'vkrunner':
         return VkRunnerTest(**options)
     if type_ == 'multi_shader':
-        options['skips'] = []
-        for e in element.findall('./Skips/Skip/option'):
-            skips = {}
-            process(e, skips)
-            options['skips'].append(skips)
         return MultiShaderTest(**options)
     if type_ == 'xts':
         return XTSTest(**options)
@@ -345,6 +329,32 @@ def make_test(element):
     raise Exception('Unreachable')
 
 
+def make_test(element):
+    """Rebuild a test instance from xml."""
+    def process(elem, opt):
+        k = elem.attrib['name']
+        v = elem.attrib['value']
+        try:
+            opt[k] = ast.literal_eval(v)
+        except ValueError:
+            opt[k] = v
+
+    type_ = element.attrib['type']
+    options = {}
+    for e in element.findall('./option'):
+        process(e, options)
+    options['env'] = {e.attrib['name']: e.attrib['value']
+                      for e in element.findall('./environment/env')}
+
+    if type_ == 'multi_shader':
+        options['skips'] = []
+        for e in element.findall('./Skips/Skip/option'):
+            skips = {}
+            process(e, skips)
+            options['skips'].append(skips)
+    return _make_test(type_, options)
+
+
 class XMLProfile(object):
 
     def __init__(self, filename):
@@ -403,6 +413,204 @@ class XMLProfile(object):
             return iter(self._itertests())
 
 
+#: Magic and version at the start of an indexed profile (.pidx) file
+INDEX_MAGIC = b'PIGLTIDX'
+INDEX_VERSION = 1
+
+#: magic, version, test count, string count, offset of the string offsets
+#: table, offset of the name index, offset of the first test record and id
+#: of the profile name string
+INDEX_HEADER = struct.Struct('<8sIIIIIII')
+
+_U32 = struct.Struct('<I')
+_U32x2 = struct.Struct('<II')
+_I64 = struct.Struct('<q')
+_F64 = struct.Struct('<d')
+
+#: Tags of the values in test records
+_TAG_STR = ord('s')
+_TAG_TRUE = ord('T')
+_TAG_FALSE = ord('F')
+_TAG_NONE = ord('N')
+_TAG_INT = ord('i')
+_TAG_FLOAT = ord('f')
+_TAG_DICT = ord('d')
+_TAG_LIST = ord('l')
+_TAG_TUPLE = ord('t')
+_TAG_SET = ord('e')
+
+
+class IndexedProfile(object):
+
+    """A profile serialized by tests/serializer.py in the indexed format.
+
+    The file is made of a table of interned UTF-8 strings, a name index
+    sorted by the name's bytes and one record per test, in profile order.
+    Each record holds the name and type string ids, followed by the test's
+    options already decoded into tagged values, so rebuilding a test doesn't
+    need any parsing. The file is mapped, and only the parts that are used
+    are read: picking a few tests from a large profile is a handful of
+    binary searches.
+    """
+
+    def __init__(self, filename):
+        self.filename = filename
+        self.forced_test_list = []
+        self.filters = Filters()
+        self.options = {
+            'dmesg': get_dmesg(False),
+            'monitor': Monitoring(False),
+            'ignore_missing': False,
+        }
+
+        with open(filename, 'rb') as f:
+            self._data = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+        (magic, version, self._count, nstrings, strtab, index, records,
+         _) = INDEX_HEADER.unpack_from(self._data, 0)
+        if magic != INDEX_MAGIC or version != INDEX_VERSION:
+            raise exceptions.PiglitFatalError(
+                '{} is not an indexed profile this version of piglit can '
+                'read, regenerate it.'.format(filename))
+
+        # One extra entry, the end of the last string.
+        self._str_offsets = self._read_u32_array(strtab, nstrings + 1)
+        self._index = self._read_u32_array(index, self._count * 2)
+        self._records = records
+        self._strings = {}
+
+    def _read_u32_array(self, offset, count):
+        values = array.array('I')
+        assert values.itemsize == 4
+        values.frombytes(self._data[offset:offset + count * 4])
+        if sys.byteorder != 'little':
+            values.byteswap()
+        return values
+
+    def _raw_string(self, i):
+        return self._data[self._str_offsets[i]:self._str_offsets[i + 1]]
+
+    def _string(self, i):
+        try:
+            return self._strings[i]
+        except KeyError:
+            value = self._strings[i] = self._raw_string(i).decode('utf-8')
+            return value
+
+    def _decode(self, offset):
+        """Decode the tagged value at offset.
+
+        Returns the value and the offset just past it.
+        """
+        data = self._data
+        tag = data[offset]
+        offset += 1
+        if tag == _TAG_STR:
+            return self._string(_U32.unpack_from(data, offset)[0]), offset + 4
+        if tag == _TAG_TRUE:
+            return True, offset
+        if tag == _TAG_FALSE:
+            return False, offset
+        if tag == _TAG_NONE:
+            return None, offset
+        if tag == _TAG_INT:
+            return _I64.unpack_from(data, offset)[0], offset + 8
+        if tag == _TAG_FLOAT:
+            return _F64.unpack_from(data, offset)[0], offset + 8
+
+        count = _U32.unpack_from(data, offset)[0]
+        offset += 4
+        if tag == _TAG_DICT:
+            value = {}
+            for _ in range(count):
+                k, offset = self._decode(offset)
+                value[k], offset = self._decode(offset)
+            return value, offset
+
+        items = []
+        for _ in range(count):
+            v, offset = self._decode(offset)
+            items.append(v)
+        if tag == _TAG_LIST:
+            return items, offset
+        if tag == _TAG_TUPLE:
+            return tuple(items), offset
+        if tag == _TAG_SET:
+            return set(items), offset
+        raise exceptions.PiglitInternalError(
+            'Unknown value tag {!r} in {}'.format(chr(tag), self.filename))
+
+    def _read_record(self, offset):
+        """Return the name, the test and the offset of the next record."""
+        name, type_ = _U32x2.unpack_from(self._data, offset)
+        options, offset = self._decode(offset + 8)
+        return self._string(name), _make_test(self._string(type_), options), \
+            offset
+
+    def _find(self, name):
+        """Return the record offset of the test called name, or None."""
+        key = name.encode('utf-8')
+        lo, hi = 0, self._count
+        while lo < hi:
+            mid = (lo + hi) // 2
+            if self._raw_string(self._index[mid * 2]) < key:
+                lo = mid + 1
+            else:
+                hi = mid
+        if lo < self._count and self._raw_string(self._index[lo * 2]) == key:
+            return self._index[lo * 2 + 1]
+        return None
+
+    def __len__(self):
+        if not (self.filters or self.forced_test_list):
+            return self._count
+        return sum(1 for _ in self.itertests())
+
+    def setup(self):
+        pass
+
+    def teardown(self):
+        pass
+
+    def _itertests(self):
+        """Always iterates tests instead of using the forced test_list."""
+        def _iter():
+            offset = self._records
+            for _ in range(self._count):
+                name, test, offset = self._read_record(offset)
+                yield name, test
+
+        for k, v in self.filters.run(_iter()):
+            yield k, v
+
+    def get_tests(self, names):
+        """Return a dict of the tests called names that pass the filters.
+
+        Names that are not in the profile are left out.
+        """
+        def _iter():
+            for n in names:
+                offset = self._find(n)
+                if offset is not None:
+                    name, test, _ = self._read_record(offset)
+                    yield name, test
+
+        return dict(self.filters.run(_iter()))
+
+    def itertests(self):
+        if self.forced_test_list:
+            alltests = self.get_tests(self.forced_test_list)
+            opts = collections.OrderedDict()
+            for n in self.forced_test_list:
+                if self.options['ignore_missing'] and n not in alltests:
+                    opts[n] = DummyTest(n, status.NOTRUN)
+                else:
+                    opts[n] = alltests[n]
+            return opts.items()
+        else:
+            return iter(self._itertests())
+
+
 class MetaProfile(object):
 
     """Holds multiple profiles but acts like one.
@@ -450,7 +658,16 @@ class MetaProfile(object):
 
     def itertests(self):
         if self.forced_test_list:
-            alltests = dict(self._itertests())
+            if all(hasattr(p, 'get_tests') for p in self._profiles):
+                # Look the tests up instead of loading every profile.
+                found = {}
+                for p in self._profiles:
+                    found.update(p.get_tests(self.forced_test_list))
+                alltests = dict(self.filters.run(
+                    (n, found[n]) for n in self.forced_test_list
+                    if n in found))
+            else:
+                alltests = dict(self._itertests())
             opts = collections.OrderedDict()
             for n in self.forced_test_list:
                 if self.options['ignore_missing'] and n not in alltests:
@@ -560,9 +777,10 @@ def load_test_profile(filename, python=None):
     filename -- the name of a python module to get a 'profile' from
 
     Keyword Arguments:
-    python -- If this is None (the default) XML is tried, and then a python
-              module. If True, then only python is tried, if False then only
-              XML is tried.
+    python -- If this is None (the default) a serialized (indexed or XML)
+              profile is tried, and then a python module. If True, then only
+              python is tried, if False then only serialized profiles are
+              tried.
     """
     name, ext = os.path.splitext(os.path.basename(filename))
     if ext == '.no_isolation':
@@ -583,6 +801,8 @@ def load_test_profile(filename, python=None):
         if os.path.isabs(filename):
             if '.meta' in filename:
                 return MetaProfile(filename)
+            if filename.endswith('.pidx'):
+                return IndexedProfile(filename)
             if '.xml' in filename:
                 return XMLProfile(filename)
 
@@ -591,13 +811,18 @@ def load_test_profile(filename, python=None):
             return MetaProfile(meta)
 
 
+        index = os.path.join(ROOT_DIR, 'tests', name + '.pidx')
+        if os.path.exists(index):
+            return IndexedProfile(index)
+
         xml = os.path.join(ROOT_DIR, 'tests', name + '.xml.gz')
         if os.path.exists(xml):
             return XMLProfile(xml)
 
     if python is False:
         raise exceptions.PiglitFatalError(
-            'Cannot open "tests/{0}.xml.gz" or "tests/{0}.meta.xml"'.format(name))
+            'Cannot open "tests/{0}.pidx", "tests/{0}.xml.gz" or '
+            '"tests/{0}.meta.xml"'.format(name))
 
     try:
         mod = importlib.import_module('tests.{0}'.format(name))
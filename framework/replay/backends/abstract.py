@@ -39,6 +39,7 @@ from os import path
 
 from framework import core
 from framework.replay.options import OPTIONS
+from framework.replay.trace_index import TraceIndex
 
 
 class DumpBackend(metaclass=abc.ABCMeta):
@@ -110,6 +111,35 @@ class DumpBackend(metaclass=abc.ABCMeta):
         """Get the number of the last frame call from the trace"""
 
 
+    def _get_frame_info(self):
+        """Scan the trace for the metadata stored in its TraceIndex
+
+        The returned dict must contain 'last_frame_call', backends that learn
+        more about the frames in the same pass should add it too.
+
+        """
+        return {'last_frame_call': self._get_last_frame_call()}
+
+
+    def _indexed_last_frame_call(self):
+        """Get the number of the last frame call, using the trace index
+
+        The trace is only scanned if its index doesn't have the answer yet.
+        Failed scans aren't stored.
+
+        """
+        index = TraceIndex.for_trace(self._trace_path)
+        if index is not None:
+            call = index.get('last_frame_call')
+            if call is not None:
+                return call
+
+        info = self._get_frame_info()
+        if index is not None and info['last_frame_call'] >= 0:
+            index.update(info)
+        return info['last_frame_call']
+
+
     @abc.abstractmethod
     def dump(self):
         """ Dump the calls to images from the trace
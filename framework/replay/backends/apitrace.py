@@ -120,7 +120,7 @@ class APITraceBackend(DumpBackend):
                 'by the APITraceBackend.\n'.format(self._trace_path))
 
 
-    def _get_last_frame_call(self):
+    def _get_frame_calls(self):
         cmd_wrapper = self._retrace_cmd[:-1]
         if cmd_wrapper:
             apitrace_bin = core.get_option(
@@ -137,18 +137,28 @@ class APITraceBackend(DumpBackend):
         logoutput = '[dump_trace_images] Running: {}\n'.format(
             ' '.join(cmd)) + ret.stdout.decode(errors='replace')
         print(logoutput)
-        for l in reversed(ret.stdout.decode(errors='replace').splitlines()):
+        frames = []
+        for l in ret.stdout.decode(errors='replace').splitlines():
             s = l.split(None, 1)
             if s and s[0].isnumeric():
-                return int(s[0])
-        return -1
+                frames.append(int(s[0]))
+        return frames
+
+    def _get_frame_info(self):
+        frames = self._get_frame_calls()
+        return {'last_frame_call': frames[-1] if frames else -1,
+                'frames': frames,
+                'frame_count': len(frames)}
+
+    def _get_last_frame_call(self):
+        return self._get_frame_info()['last_frame_call']
 
     @dump_handler
     def dump(self):
         outputprefix = '{}-'.format(path.join(self._output_dir,
                                               path.basename(self._trace_path)))
         if not self._calls:
-            self._calls = [str(self._get_last_frame_call())]
+            self._calls = [str(self._indexed_last_frame_call())]
         cmd = self._retrace_cmd + ['--headless',
                                    '--snapshot=' + ','.join(self._calls),
                                    '--snapshot-prefix=' + outputprefix,
@@ -89,6 +89,11 @@ class GFXReconstructBackend(DumpBackend):
         except:
             return -1
 
+    def _get_frame_info(self):
+        last_frame = self._get_last_frame_call()
+        return {'last_frame_call': last_frame,
+                'frame_count': max(last_frame, 0)}
+
     def _check_version(self, gfxrecon_replay_bin):
         cmd = [gfxrecon_replay_bin, '--version']
         ret = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=sys.stderr)
@@ -118,7 +123,7 @@ class GFXReconstructBackend(DumpBackend):
             default='gfxrecon-replay')
         self._check_version(gfxrecon_replay_bin)
         if not self._calls:
-            self._calls = [str(self._get_last_frame_call())]
+            self._calls = [str(self._indexed_last_frame_call())]
         gfxrecon_replay_extra_args = core.get_option(
             'PIGLIT_REPLAY_GFXRECON_REPLAY_EXTRA_ARGS',
             ('replay', 'gfxrecon-replay_extra_args'),
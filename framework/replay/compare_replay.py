@@ -39,6 +39,7 @@ from framework import exceptions
 from framework import status
 from framework.replay import backends
 from framework.replay import query_traces_yaml as qty
+from framework.replay import scheduler
 from framework.replay.download_utils import ensure_file
 from framework.replay.image_checksum import hexdigest_from_image
 from framework.replay.options import OPTIONS
@@ -72,9 +73,7 @@ def _replay(trace_path, results_path):
         return hexdigest_from_image(image_file), image_file
 
 
-def _check_trace(trace_path, expected_checksum):
-    ensure_file(trace_path)
-
+def _compare_trace(trace_path, expected_checksum):
     json_result = {}
 
     trace_dir = path.dirname(trace_path)
@@ -119,6 +118,24 @@ def _check_trace(trace_path, expected_checksum):
     return result, json_result
 
 
+def _check_trace(trace_path, expected_checksum):
+    ensure_file(trace_path)
+
+    return _compare_trace(trace_path, expected_checksum)
+
+
+def _replay_cost(t):
+    return scheduler.file_cost(path.join(OPTIONS.db_path, t['path']))
+
+
+def _replay_key(t):
+    # gfxrecon-replay names its screenshots after the frame number only, so
+    # two .gfxr traces sharing a results directory can't replay at once.
+    if t['path'].endswith('.gfxr'):
+        return path.dirname(t['path'])
+    return None
+
+
 def _print_result(result, trace_path, json_result):
     output = 'PIGLIT: '
     json_result['result'] = str(result)
@@ -136,8 +153,15 @@ def from_yaml(yaml_file):
     # TODO: print in subtest format
     # json_results = {}
     t_list = qty.traces(y, device_name=OPTIONS.device_name, checksum=True)
-    for t in t_list:
-        result, json_result = _check_trace(t['path'], t['checksum'])
+    results = scheduler.run(
+        t_list,
+        lambda t: ensure_file(t['path']),
+        lambda t: _compare_trace(t['path'], t['checksum']),
+        jobs=OPTIONS.jobs or scheduler.default_jobs(),
+        memory_budget=scheduler.default_memory_budget(),
+        cost=_replay_cost,
+        key=_replay_key)
+    for result, json_result in results:
         if result is not status.PASS and global_result is not status.CRASH:
             global_result = result
         # json_results.update(json_result)
@@ -26,7 +26,11 @@
 import base64
 import hashlib
 import hmac
+import json
+import os
+import re
 import requests
+import tempfile
 import xml.etree.ElementTree as ET
 
 from os import path
@@ -35,6 +39,7 @@ from email.utils import formatdate
 from requests.utils import requote_uri
 
 from framework import core, exceptions
+from framework.replay import trace_cache
 from framework.replay.options import OPTIONS
 
 
@@ -101,6 +106,85 @@ def get_authorization_headers(url, resource):
                'x-amz-security-token': minio_token}
     return headers
 
+def _read_meta(meta_file):
+    try:
+        with open(meta_file, 'r') as f:
+            return json.load(f)
+    except (IOError, OSError, ValueError):
+        return {}
+
+
+def _download(url, headers, part_file, resume=True):
+    """Download url into part_file.
+
+    When resume is True and part_file already holds the start of the same
+    content, as recorded by its ETag or Last-Modified in a side file, only
+    the rest is requested. Returns the ETag of the content, if any.
+
+    """
+    meta_file = part_file + '.json'
+    request_headers = dict(headers or {})
+    # The length, ETag and ranges all refer to the bytes as stored, so ask
+    # for those and don't let requests decode a Content-Encoding.
+    request_headers['Accept-Encoding'] = 'identity'
+    offset = 0
+    if resume and path.exists(part_file):
+        meta = _read_meta(meta_file)
+        validator = meta.get('etag') or meta.get('last_modified')
+        if validator:
+            offset = path.getsize(part_file)
+            request_headers['Range'] = 'bytes={}-'.format(offset)
+            request_headers['If-Range'] = validator
+
+    with requests.get(url, allow_redirects=True, stream=True,
+                      headers=request_headers) as r:
+        if r.status_code == 416:
+            # The partial file doesn't match the content anymore.
+            os.unlink(part_file)
+            return _download(url, headers, part_file, resume=False)
+        if r.status_code >= 400:
+            print(r.text)
+        r.raise_for_status()
+        if r.status_code != 206:
+            offset = 0
+
+        with open(meta_file, 'w') as f:
+            json.dump({'etag': r.headers.get('ETag'),
+                       'last_modified': r.headers.get('Last-Modified')}, f)
+
+        with open(part_file, 'ab' if offset else 'wb') as file:
+            for chunk in r.raw.stream(1 << 20, decode_content=False):
+                if chunk:
+                    file.write(chunk)
+
+        length = r.headers.get('Content-Length')
+        if length is not None and path.getsize(part_file) != offset + int(length):
+            raise exceptions.PiglitFatalError(
+                'Incomplete download of {}'.format(url))
+        etag = r.headers.get('ETag')
+
+    os.unlink(meta_file)
+    return etag
+
+
+def _verify(url, part_file, etag):
+    """Check the download against its ETag, return its sha256.
+
+    S3 and MinIO use the md5 of the content as the ETag of objects uploaded
+    in a single part, which lets us catch corrupted downloads.
+
+    """
+    sha256, md5 = trace_cache.file_digests(part_file)
+    if etag:
+        etag = etag.strip('"')
+        if re.match(r'^[0-9a-f]{32}$', etag) and etag != md5:
+            os.unlink(part_file)
+            raise exceptions.PiglitFatalError(
+                'Corrupted download of {}: md5 {} but ETag {}'.format(
+                    url, md5, etag))
+    return sha256
+
+
 def ensure_file(file_path):
     destination_file_path = path.join(OPTIONS.db_path, file_path)
     if OPTIONS.download['url'] is None:
@@ -119,6 +203,11 @@ def ensure_file(file_path):
     if not OPTIONS.download['force'] and path.exists(destination_file_path):
         return
 
+    cache = trace_cache.TraceCache.from_options()
+    if (cache is not None and not OPTIONS.download['force'] and
+            cache.install(url + file_path, destination_file_path)):
+        return
+
     print('[check_image] Downloading file {}'.format(
         file_path), end=' ', flush=True)
 
@@ -131,14 +220,33 @@ def ensure_file(file_path):
         headers = None
 
     download_time = time()
-    with open(destination_file_path, 'wb') as file:
-        with requests.get(url + file_path,
-                          allow_redirects=True, stream=True,
-                          headers=headers) as r:
-            if r.status_code >= 400:
-                print(r.text)
-            r.raise_for_status()
-            for chunk in r.iter_content(chunk_size=8194):
-                if chunk:
-                    file.write(chunk)
+    if cache is None:
+        fd, part_file = tempfile.mkstemp(
+            dir=path.dirname(destination_file_path), suffix='.part')
+        os.close(fd)
+        try:
+            etag = _download(url + file_path, headers, part_file,
+                             resume=False)
+            _verify(url + file_path, part_file, etag)
+            os.replace(part_file, destination_file_path)
+        finally:
+            for f in (part_file, part_file + '.json'):
+                if path.exists(f):
+                    os.unlink(f)
+    else:
+        with cache.lock(url + file_path):
+            # Another job may have downloaded it while we waited.
+            if (OPTIONS.download['force'] or
+                    not cache.install(url + file_path,
+                                      destination_file_path)):
+                part_file = cache.partial_file(url + file_path)
+                etag = _download(url + file_path, headers, part_file,
+                                 resume=not OPTIONS.download['force'])
+                sha256 = _verify(url + file_path, part_file, etag)
+                cache.add(url + file_path, part_file, sha256)
+                if not cache.install(url + file_path,
+                                     destination_file_path):
+                    raise exceptions.PiglitFatalError(
+                        'Cannot install {} from the trace cache'.format(
+                            file_path))
     print('took %ds.' % (time() - download_time), flush=True)
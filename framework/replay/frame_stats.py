@@ -0,0 +1,245 @@
+# coding=utf-8
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+# OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+# ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+# OTHER DEALINGS IN THE SOFTWARE.
+#
+# SPDX-License-Identifier: MIT
+
+"""Frame time statistics and regression checks for the replay profiler.
+
+The frame times reported by `replayer.py profile` are the GPU durations of
+the last frame of a trace replayed in a loop. The first iterations are
+usually slower while caches, shader compilers and clocks warm up, so they
+are dropped before computing the statistics.
+
+A baseline file stores the statistics of a known good run for each device
+and trace. A new run is compared against it on the median frame time: it
+is a warning when the median grows by more than the warn threshold, and a
+failure when it grows by more than the fail threshold. Both thresholds are
+relative to the baseline median but never tighter than a few times the
+measured noise, estimated from the median absolute deviation of both runs,
+so noisy traces don't flip between pass and fail. A growth of the p99 frame
+time beyond the fail threshold while the median holds is reported as a
+warning, as it means more stutter.
+
+The following options can be set in the [replay] section of piglit.conf or
+with their environment equivalents:
+warmup_frames -- frames dropped at the start, 10% of them by default
+                 (PIGLIT_REPLAY_WARMUP_FRAMES).
+warn_threshold -- percentage of median growth to warn about, 5 by default
+                  (PIGLIT_REPLAY_WARN_THRESHOLD).
+fail_threshold -- percentage of median growth to fail on, 10 by default
+                  (PIGLIT_REPLAY_FAIL_THRESHOLD).
+
+"""
+
+import json
+import math
+import os
+import tempfile
+
+try:
+    import fcntl
+except ImportError:
+    fcntl = None
+
+from framework import core
+from framework import exceptions
+from framework import status
+
+__all__ = [
+    'Baseline',
+    'compare',
+    'format_stats',
+    'summarize',
+    'trim_warmup',
+]
+
+_VERSION = 1
+
+# A frame taking this many times the median is counted as a stutter.
+_STUTTER_FACTOR = 2.0
+
+# Scale factor from the median absolute deviation to the standard
+# deviation of a normal distribution.
+_MAD_TO_SIGMA = 1.4826
+
+_WARN_SIGMAS = 2.0
+_FAIL_SIGMAS = 4.0
+
+
+def _float_option(env, key, default):
+    value = core.get_option(env, ('replay', key), default=None)
+    if value is None or value == '':
+        return default
+    try:
+        return float(value)
+    except ValueError:
+        raise exceptions.PiglitFatalError(
+            'Invalid value for [replay]:{}: "{}"'.format(key, value))
+
+
+def _percentile(values, p):
+    """Linearly interpolated percentile p (0-100) of sorted values."""
+    rank = (len(values) - 1) * p / 100.0
+    low = int(math.floor(rank))
+    high = min(low + 1, len(values) - 1)
+    return values[low] + (values[high] - values[low]) * (rank - low)
+
+
+def trim_warmup(frame_times, warmup=None):
+    """Return frame_times without the warmup frames at the start.
+
+    Without an explicit warmup count, the configured one is used, or 10% of
+    the frames. At least one frame is always kept.
+
+    """
+    if warmup is None:
+        warmup = _float_option('PIGLIT_REPLAY_WARMUP_FRAMES',
+                               'warmup_frames', None)
+    if warmup is None:
+        warmup = len(frame_times) // 10
+    warmup = min(max(int(warmup), 0), max(len(frame_times) - 1, 0))
+    return frame_times[warmup:]
+
+
+def summarize(frame_times):
+    """Return a dict with the statistics of frame_times, None if empty.
+
+    Times keep the unit of the input, apitrace reports nanoseconds.
+
+    """
+    if not frame_times:
+        return None
+
+    values = sorted(frame_times)
+    median = _percentile(values, 50)
+    mad = _percentile(sorted(abs(v - median) for v in values), 50)
+    stutter = sum(1 for v in values if v > median * _STUTTER_FACTOR)
+
+    return {
+        'frames': len(values),
+        'mean': sum(values) / len(values),
+        'median': median,
+        'p95': _percentile(values, 95),
+        'p99': _percentile(values, 99),
+        'max': values[-1],
+        'mad': mad,
+        'stutter_frames': stutter,
+        'stutter_ratio': stutter / len(values),
+    }
+
+
+def format_stats(stats):
+    """Return a one line description of stats, with times in ms."""
+    return ('median: {:.3f} ms, p95: {:.3f} ms, p99: {:.3f} ms, '
+            'max: {:.3f} ms, stutter: {}/{} frames'.format(
+                stats['median'] / 1e6, stats['p95'] / 1e6,
+                stats['p99'] / 1e6, stats['max'] / 1e6,
+                stats['stutter_frames'], stats['frames']))
+
+
+def compare(stats, reference, warn_threshold=None, fail_threshold=None):
+    """Compare stats against the reference ones of a baseline.
+
+    Returns a tuple of the status (PASS, WARN or FAIL) and a message
+    describing the change.
+
+    """
+    if warn_threshold is None:
+        warn_threshold = _float_option('PIGLIT_REPLAY_WARN_THRESHOLD',
+                                       'warn_threshold', 5.0)
+    if fail_threshold is None:
+        fail_threshold = _float_option('PIGLIT_REPLAY_FAIL_THRESHOLD',
+                                       'fail_threshold', 10.0)
+
+    noise = _MAD_TO_SIGMA * math.hypot(stats['mad'], reference['mad'])
+    base = reference['median']
+    delta = stats['median'] - base
+    change = 100.0 * delta / base if base else 0.0
+
+    message = 'median {:+.1f}% ({:.3f} ms -> {:.3f} ms, noise {:.3f} ms)'.format(
+        change, base / 1e6, stats['median'] / 1e6, noise / 1e6)
+
+    if delta > max(base * fail_threshold / 100.0, _FAIL_SIGMAS * noise):
+        return status.FAIL, 'Regression: ' + message
+    if delta > max(base * warn_threshold / 100.0, _WARN_SIGMAS * noise):
+        return status.WARN, 'Possible regression: ' + message
+
+    tail = stats['p99'] - reference['p99']
+    if tail > max(reference['p99'] * fail_threshold / 100.0,
+                  _FAIL_SIGMAS * noise):
+        return status.WARN, (
+            'More stutter: p99 {:.3f} ms -> {:.3f} ms, {}'.format(
+                reference['p99'] / 1e6, stats['p99'] / 1e6, message))
+
+    return status.PASS, 'No regression: ' + message
+
+
+class Baseline(object):
+    """Reference frame time statistics, per device and trace.
+
+    The file is json of the form:
+    {"version": 1, "devices": {device: {trace_path: stats}}}
+
+    """
+
+    def __init__(self, filename):
+        self.filename = filename
+        self._devices = self._load()
+
+    def _load(self):
+        try:
+            with open(self.filename, 'r') as f:
+                data = json.load(f)
+        except FileNotFoundError:
+            return {}
+        except (IOError, OSError, ValueError) as e:
+            raise exceptions.PiglitFatalError(
+                'Cannot read the frame times baseline "{}": {}'.format(
+                    self.filename, e))
+        if not isinstance(data, dict) or data.get('version') != _VERSION:
+            raise exceptions.PiglitFatalError(
+                'Unsupported frame times baseline "{}"'.format(
+                    self.filename))
+        return data.get('devices', {})
+
+    def get(self, device_name, trace_path):
+        """Return the reference stats of a trace, or None."""
+        return self._devices.get(device_name, {}).get(trace_path)
+
+    def update(self, device_name, values):
+        """Store the stats of several traces of a device in the file.
+
+        values maps trace paths to their stats. The file is re-read under a
+        lock before writing, so concurrent updates of different traces
+        don't lose each other's entries.
+
+        """
+        directory = os.path.dirname(os.path.abspath(self.filename))
+        core.check_dir(directory)
+        with open(self.filename + '.lock', 'w') as lock:
+            if fcntl is not None:
+                fcntl.flock(lock, fcntl.LOCK_EX)
+            self._devices = self._load()
+            self._devices.setdefault(device_name, {}).update(values)
+            fd, tmp = tempfile.mkstemp(dir=directory, suffix='.tmp')
+            with os.fdopen(fd, 'w') as f:
+                json.dump({'version': _VERSION, 'devices': self._devices},
+                          f, indent=2, sort_keys=True)
+            os.replace(tmp, self.filename)
@@ -34,9 +34,11 @@ from os import path
 
 from framework import core
 from framework import status
+from framework.replay import frame_stats
 from framework.replay import backends
 from framework.replay.backends.apitrace import APITraceBackend
 from framework.replay import query_traces_yaml as qty
+from framework.replay import scheduler
 from framework.replay.download_utils import ensure_file
 from framework.replay.options import OPTIONS
 
@@ -62,9 +64,19 @@ def _replay(trace_path):
         return frame_times
 
 
-def _run_trace(trace_path):
-    ensure_file(trace_path)
+def _device_name():
+    return OPTIONS.device_name or 'default'
+
+
+def _baseline():
+    baseline_path = OPTIONS.baseline_path or core.get_option(
+        'PIGLIT_REPLAY_BASELINE', ('replay', 'baseline'), default=None)
+    if not baseline_path:
+        return None
+    return frame_stats.Baseline(baseline_path)
+
 
+def _profile_trace(trace_path, baseline=None):
     json_result = {}
 
     frame_times = _replay(path.join(OPTIONS.db_path, trace_path))
@@ -80,7 +92,42 @@ def _run_trace(trace_path):
     if frame_times is None:
         return status.CRASH, json_result
 
-    return status.PASS, json_result
+    stats = frame_stats.summarize(frame_stats.trim_warmup(frame_times))
+    if stats is None:
+        return status.PASS, json_result
+
+    print('[frame_times] {}'.format(frame_stats.format_stats(stats)))
+    json_result['images'][0]['frame_time_stats'] = stats
+
+    reference = None
+    if baseline is not None:
+        reference = baseline.get(_device_name(), trace_path)
+    if reference is None:
+        return status.PASS, json_result
+
+    result, message = frame_stats.compare(stats, reference)
+    print('[frame_times] {}'.format(message))
+    json_result['images'][0]['frame_time_baseline'] = reference
+
+    return result, json_result
+
+
+def _update_baseline(baseline, json_results):
+    values = {}
+    for json_result in json_results:
+        image = json_result['images'][0]
+        if 'frame_time_stats' in image:
+            values[image['image_desc']] = image['frame_time_stats']
+    if values:
+        baseline.update(_device_name(), values)
+        print('[frame_times] Updated the baseline at {}'.format(
+            baseline.filename))
+
+
+def _run_trace(trace_path, baseline=None):
+    ensure_file(trace_path)
+
+    return _profile_trace(trace_path, baseline)
 
 
 def _print_result(result, trace_path, json_result):
@@ -91,27 +138,45 @@ def _print_result(result, trace_path, json_result):
     print(output)
 
 
+def _print_subtest(result, trace_path):
+    print('PIGLIT: ' + json.dumps({'subtest': {trace_path: str(result)}}))
+
+
 def from_yaml(yaml_file):
     y = qty.load_yaml(yaml_file)
 
     OPTIONS.set_download_url(qty.download_url(y))
 
+    baseline = _baseline()
     global_result = status.PASS
-    # TODO: print in subtest format
-    # json_results = {}
-    t_list = qty.traces(y, trace_extensions=".trace", device_name=OPTIONS.device_name)
-    for t in t_list:
-        result, json_result = _run_trace(t['path'])
-        if result is not status.PASS and global_result is not status.CRASH:
-            global_result = result
-        # json_results.update(json_result)
-        # _print_result(result, t['path'], json_result)
+    t_list = list(qty.traces(y, trace_extensions=".trace",
+                             device_name=OPTIONS.device_name))
+    # Concurrent replays skew each other's frame times, so unless configured
+    # otherwise only the downloads overlap with the profiling.
+    results = scheduler.run(
+        t_list,
+        lambda t: ensure_file(t['path']),
+        lambda t: _profile_trace(t['path'], baseline),
+        jobs=OPTIONS.jobs or scheduler.default_jobs(1),
+        memory_budget=scheduler.default_memory_budget(),
+        cost=lambda t: scheduler.file_cost(
+            path.join(OPTIONS.db_path, t['path'])))
+    for t, (result, json_result) in zip(t_list, results):
+        global_result = max(global_result, result)
+        _print_subtest(result, t['path'])
+
+    if baseline is not None and OPTIONS.update_baseline:
+        _update_baseline(baseline, [r[1] for r in results])
 
     return global_result
 
 
 def trace(trace_path):
-    result, json_result = _run_trace(trace_path)
+    baseline = _baseline()
+    result, json_result = _run_trace(trace_path, baseline)
     _print_result(result, trace_path, json_result)
 
+    if baseline is not None and OPTIONS.update_baseline:
+        _update_baseline(baseline, [json_result])
+
     return result
@@ -60,6 +60,11 @@ class _Options(object):  # pylint: disable=too-many-instance-attributes
     keep_image -- Whether to always keep the dumped images or not.
     db_path -- The path to the objects db or where it will be created.
     results_path -- The path in which to place the results.
+    jobs -- The maximum number of traces to replay concurrently. None for
+            the default of each command.
+    baseline_path -- The frame times baseline file to compare against.
+    update_baseline -- Whether to store the profiled frame times in the
+                       baseline file.
     download.url -- The URL from which to download the files.
     download.caching_proxy_url -- The URL of the caching proxy acting as
                                   a prefix for download.url
@@ -76,6 +81,9 @@ class _Options(object):  # pylint: disable=too-many-instance-attributes
         self.keep_image = False
         self.db_path = None
         self.results_path = None
+        self.jobs = None
+        self.baseline_path = None
+        self.update_baseline = False
         self.download = {'url': None,
                          'caching_proxy_url': None,
                          'force': False,
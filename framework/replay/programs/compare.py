@@ -45,6 +45,7 @@ def _from_yaml(args):
     options.OPTIONS.download['jwt'] = args.download_jwt
     options.OPTIONS.db_path = args.db_path
     options.OPTIONS.results_path = args.output
+    options.OPTIONS.jobs = args.jobs
 
     return compare_replay.from_yaml(args.yaml_file)
 
@@ -118,6 +119,7 @@ def compare(input_):
                  parsers.DOWNLOAD_ROLE_SESSION_NAME,
                  parsers.DOWNLOAD_JWT,
                  parsers.DB_PATH,
+                 parsers.JOBS,
                  parsers.RESULTS_PATH],
         help=('Compares from a traces description file listing traces '
               'and their checksums for a given device.'))
@@ -140,6 +140,30 @@ DB_PATH.add_argument(
     help=('the path to the objects db or where it will be created. '
           'Defaults to "./replayer-db/".'))
 
+JOBS = argparse.ArgumentParser(add_help=False)
+JOBS.add_argument(
+    '--jobs',
+    dest='jobs',
+    type=int,
+    required=False,
+    default=None,
+    help=('the maximum number of traces to replay concurrently. '
+          'Can also be set with PIGLIT_REPLAY_JOBS or [replay]:jobs.'))
+
+BASELINE = argparse.ArgumentParser(add_help=False)
+BASELINE.add_argument(
+    '--baseline',
+    dest='baseline',
+    required=False,
+    default=None,
+    help=('the frame times baseline file to check for regressions against. '
+          'Can also be set with PIGLIT_REPLAY_BASELINE or [replay]:baseline.'))
+BASELINE.add_argument(
+    '--update-baseline',
+    dest='update_baseline',
+    action='store_true',
+    help=('stores the profiled frame times in the baseline file.'))
+
 RESULTS_PATH = argparse.ArgumentParser(add_help=False)
 RESULTS_PATH.add_argument(
     '-o', '--output',
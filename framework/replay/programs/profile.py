@@ -44,6 +44,9 @@ def _from_yaml(args):
     options.OPTIONS.download['jwt'] = args.download_jwt
     options.OPTIONS.db_path = args.db_path
     options.OPTIONS.results_path = args.output
+    options.OPTIONS.baseline_path = args.baseline
+    options.OPTIONS.update_baseline = args.update_baseline
+    options.OPTIONS.jobs = args.jobs
 
     return frame_times.from_yaml(args.yaml_file)
 
@@ -59,6 +62,8 @@ def _trace(args):
     options.OPTIONS.download['jwt'] = args.download_jwt
     options.OPTIONS.db_path = args.db_path
     options.OPTIONS.results_path = args.output
+    options.OPTIONS.baseline_path = args.baseline
+    options.OPTIONS.update_baseline = args.update_baseline
 
     return frame_times.trace(args.file_path)
 
@@ -90,6 +95,7 @@ def profile(input_):
                  parsers.DOWNLOAD_ROLE_SESSION_NAME,
                  parsers.DOWNLOAD_JWT,
                  parsers.DB_PATH,
+                 parsers.BASELINE,
                  parsers.RESULTS_PATH],
         help=('Profiles specific trace given a device.'))
     parser_trace.add_argument(
@@ -110,6 +116,8 @@ def profile(input_):
                  parsers.DOWNLOAD_ROLE_SESSION_NAME,
                  parsers.DOWNLOAD_JWT,
                  parsers.DB_PATH,
+                 parsers.JOBS,
+                 parsers.BASELINE,
                  parsers.RESULTS_PATH],
         help=('Profiles from a traces description file listing traces.'))
     parser_yaml.set_defaults(func=_from_yaml)
@@ -0,0 +1,252 @@
+# coding=utf-8
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+# OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+# ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+# OTHER DEALINGS IN THE SOFTWARE.
+#
+# SPDX-License-Identifier: MIT
+
+"""Parallel scheduler for replaying the traces of a YAML description.
+
+Traces are fetched by a small pool of download workers while the traces
+already present are being replayed, and up to `jobs` replays run at the same
+time. The replays are also bounded by a memory budget: each trace is charged
+with the size of its file, as a rough estimate of what its retrace needs, and
+a replay only starts if the charges of the running ones still fit. A trace
+bigger than the whole budget is replayed alone.
+
+Whatever the order in which the replays finish, their output is printed and
+their results are returned in the order of the input list, so a parallel run
+reads the same as a serial one.
+
+The defaults can be set with PIGLIT_REPLAY_JOBS or [replay]:jobs, and
+PIGLIT_REPLAY_MEMORY_BUDGET or [replay]:memory_budget (in MiB).
+
+"""
+
+import collections
+import concurrent.futures
+import io
+import os
+import sys
+import threading
+
+from framework import core
+
+__all__ = [
+    'default_jobs',
+    'default_memory_budget',
+    'file_cost',
+    'run',
+]
+
+_FETCH_JOBS = 2
+
+_Job = collections.namedtuple('_Job', ['log', 'cost', 'key'])
+
+
+def default_jobs(fallback=None):
+    """Return the number of concurrent replays to use by default.
+
+    Without a configured value this is fallback, or the number of CPUs.
+
+    """
+    jobs = core.get_option('PIGLIT_REPLAY_JOBS', ('replay', 'jobs'),
+                           default=None)
+    if jobs:
+        return max(int(jobs), 1)
+    return fallback or os.cpu_count() or 1
+
+
+def default_memory_budget():
+    """Return the memory budget for concurrent replays, in bytes.
+
+    By default this is half of the physical memory, or no budget at all when
+    that can't be queried.
+
+    """
+    budget = core.get_option('PIGLIT_REPLAY_MEMORY_BUDGET',
+                             ('replay', 'memory_budget'), default=None)
+    if budget:
+        return int(budget) << 20
+    try:
+        return (os.sysconf('SC_PHYS_PAGES') *
+                os.sysconf('SC_PAGE_SIZE')) // 2
+    except (AttributeError, ValueError, OSError):
+        return None
+
+
+class _ThreadStdout(object):
+    """Stand-in for sys.stdout which buffers the writes of each worker.
+
+    Writes from a thread which has a buffer set go there, anything else goes
+    to the wrapped stream.
+
+    """
+
+    def __init__(self, stream):
+        self._stream = stream
+        self._local = threading.local()
+
+    def capture(self, log):
+        self._local.log = log
+
+    def _target(self):
+        return getattr(self._local, 'log', None) or self._stream
+
+    def write(self, text):
+        return self._target().write(text)
+
+    def flush(self):
+        self._target().flush()
+
+    def __getattr__(self, name):
+        return getattr(self._stream, name)
+
+
+def _captured(stdout, log, func, *args):
+    stdout.capture(log)
+    try:
+        return func(*args)
+    finally:
+        stdout.capture(None)
+
+
+def file_cost(path):
+    """Return the size of the file at path as its replay cost."""
+    try:
+        return os.path.getsize(path)
+    except OSError:
+        return 0
+
+
+def run(items, fetch, replay, jobs=None, memory_budget=None, cost=None,
+        key=None):
+    """Fetch and replay every item, returning the replay results in order.
+
+    Arguments:
+    items -- the list of items to process.
+    fetch -- called with each item to make it available, e.g. downloading
+             it. Runs concurrently with the replay of earlier items.
+    replay -- called with each item once fetched, its return value is the
+              result of the item.
+    jobs -- maximum number of concurrent replays, default_jobs() if None.
+    memory_budget -- maximum summed cost of the running replays, in bytes.
+                     None means no budget.
+    cost -- called with each fetched item to estimate the memory its replay
+            needs, in bytes. Without it every item costs nothing.
+    key -- called with each item, two items with the same key which isn't
+           None never replay at the same time.
+
+    Exceptions raised by fetch or replay are re-raised once every running
+    replay has finished.
+
+    """
+    items = list(items)
+    if not items:
+        return []
+    if jobs is None:
+        jobs = default_jobs()
+    jobs = max(jobs, 1)
+
+    results = [None] * len(items)
+    logs = [io.StringIO() for _ in items]
+    stdout = _ThreadStdout(sys.stdout)
+    stream = sys.stdout
+
+    fetched = {}
+    pending = []
+    running = {}
+    used = 0
+    busy_keys = set()
+    printed = 0
+    done = set()
+    error = None
+
+    sys.stdout = stdout
+    try:
+        with concurrent.futures.ThreadPoolExecutor(
+                min(_FETCH_JOBS, len(items))) as fetchers, \
+             concurrent.futures.ThreadPoolExecutor(jobs) as replayers:
+            fetching = {
+                fetchers.submit(_captured, stdout, logs[i], fetch, item): i
+                for i, item in enumerate(items)}
+
+            while fetching or pending or running:
+                # Start as many fetched items as the limits allow, in order,
+                # but let smaller items through when a big one has to wait.
+                if error is None:
+                    for i in sorted(pending):
+                        job = fetched[i]
+                        if len(running) >= jobs:
+                            break
+                        if job.key is not None and job.key in busy_keys:
+                            continue
+                        if (running and memory_budget is not None and
+                                used + job.cost > memory_budget):
+                            continue
+                        pending.remove(i)
+                        used += job.cost
+                        if job.key is not None:
+                            busy_keys.add(job.key)
+                        running[replayers.submit(
+                            _captured, stdout, job.log, replay,
+                            items[i])] = i
+                elif not running:
+                    break
+
+                finished, _ = concurrent.futures.wait(
+                    list(fetching) + list(running),
+                    return_when=concurrent.futures.FIRST_COMPLETED)
+                for future in finished:
+                    if future in fetching:
+                        i = fetching.pop(future)
+                        if future.exception() is not None:
+                            error = error or future.exception()
+                            continue
+                        fetched[i] = _Job(
+                            logs[i],
+                            cost(items[i]) if cost is not None else 0,
+                            key(items[i]) if key is not None else None)
+                        pending.append(i)
+                    else:
+                        i = running.pop(future)
+                        job = fetched[i]
+                        used -= job.cost
+                        busy_keys.discard(job.key)
+                        if future.exception() is not None:
+                            error = error or future.exception()
+                            continue
+                        results[i] = future.result()
+                        done.add(i)
+
+                # Print the logs of the items done so far, in order.
+                while printed in done:
+                    stream.write(logs[printed].getvalue())
+                    printed += 1
+
+            for future in fetching:
+                future.cancel()
+    finally:
+        sys.stdout = stream
+
+    if error is not None:
+        for log in logs[printed:]:
+            stream.write(log.getvalue())
+        raise error
+
+    return results
@@ -0,0 +1,251 @@
+# coding=utf-8
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+# OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+# ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+# OTHER DEALINGS IN THE SOFTWARE.
+#
+# SPDX-License-Identifier: MIT
+
+"""Content addressed cache for downloaded traces.
+
+Downloaded traces are stored once in the cache directory, named after the
+sha256 of their content, and hard linked (or copied, across file systems)
+into the db path of each run. A small json file per URL records which blob
+holds its content, so a trace is downloaded once per runner whatever the
+db path or the number of jobs asking for it.
+
+blobs/<sha256[:2]>/<sha256> -- the trace contents.
+refs/<sha1(url)>.json -- the blob for a URL.
+partial/<sha1(url)>.part -- an interrupted download, resumed next time.
+locks/ -- lock files serializing the downloads of a URL across processes.
+
+Blobs are touched each time they are used, and when the cache grows over
+its size budget the least recently used ones are removed.
+
+The cache directory can be set with PIGLIT_REPLAY_CACHE_DIR or
+[replay]:cache_dir, setting it to an empty value disables the cache. The
+size budget, in MiB, can be set with PIGLIT_REPLAY_CACHE_SIZE or
+[replay]:cache_size, it defaults to 20 GiB and 0 removes the limit.
+
+"""
+
+import contextlib
+import hashlib
+import json
+import os
+import shutil
+import tempfile
+
+try:
+    import fcntl
+except ImportError:
+    fcntl = None
+
+from framework import core
+
+__all__ = [
+    'TraceCache',
+    'file_digests',
+]
+
+_VERSION = 1
+_CHUNK_SIZE = 1 << 20
+_DEFAULT_SIZE = 20480
+
+
+def _cache_dir():
+    return core.get_cache_dir('PIGLIT_REPLAY_CACHE_DIR',
+                              ('replay', 'cache_dir'), 'replay-cache')
+
+
+def _cache_size():
+    size = int(core.get_option('PIGLIT_REPLAY_CACHE_SIZE',
+                               ('replay', 'cache_size'),
+                               default=_DEFAULT_SIZE) or 0)
+    if not size:
+        return None
+    return size << 20
+
+
+def file_digests(filename):
+    """Return the sha256 and md5 hex digests of a file, in one pass."""
+    sha256 = hashlib.sha256()
+    md5 = hashlib.md5()
+    with open(filename, 'rb') as f:
+        for chunk in iter(lambda: f.read(_CHUNK_SIZE), b''):
+            sha256.update(chunk)
+            md5.update(chunk)
+    return sha256.hexdigest(), md5.hexdigest()
+
+
+@contextlib.contextmanager
+def _locked(filename):
+    core.check_dir(os.path.dirname(filename))
+    with open(filename, 'a') as f:
+        if fcntl is not None:
+            fcntl.flock(f, fcntl.LOCK_EX)
+        try:
+            yield
+        finally:
+            if fcntl is not None:
+                fcntl.flock(f, fcntl.LOCK_UN)
+
+
+def _place(source, destination):
+    """Atomically make destination a hard link to, or copy of, source."""
+    directory = os.path.dirname(destination)
+    fd, tmp = tempfile.mkstemp(dir=directory, suffix='.tmp')
+    os.close(fd)
+    try:
+        os.unlink(tmp)
+        try:
+            os.link(source, tmp)
+        except OSError:
+            shutil.copyfile(source, tmp)
+        os.replace(tmp, destination)
+    except BaseException:
+        if os.path.exists(tmp):
+            os.unlink(tmp)
+        raise
+
+
+class TraceCache(object):
+    """A content addressed store of downloaded traces."""
+
+    def __init__(self, directory, max_size=None):
+        self.directory = directory
+        self.max_size = max_size
+
+    @classmethod
+    def from_options(cls):
+        """Return the configured cache, or None if it is disabled."""
+        directory = _cache_dir()
+        if directory is None:
+            return None
+        return cls(directory, _cache_size())
+
+    @staticmethod
+    def _key(url):
+        return hashlib.sha1(url.encode('utf-8')).hexdigest()
+
+    def _ref_file(self, url):
+        return os.path.join(self.directory, 'refs', self._key(url) + '.json')
+
+    def blob_path(self, sha256):
+        """Return the path of the blob holding the content of sha256."""
+        return os.path.join(self.directory, 'blobs', sha256[:2], sha256)
+
+    def partial_file(self, url):
+        """Return the path to download url into, which may be partial."""
+        directory = os.path.join(self.directory, 'partial')
+        core.check_dir(directory)
+        return os.path.join(directory, self._key(url) + '.part')
+
+    def lock(self, url):
+        """Return a context manager holding the download lock of url."""
+        return _locked(os.path.join(self.directory, 'locks',
+                                    self._key(url) + '.lock'))
+
+    def _lookup(self, url):
+        try:
+            with open(self._ref_file(url), 'r') as f:
+                ref = json.load(f)
+        except (IOError, OSError, ValueError):
+            return None
+        if not isinstance(ref, dict) or ref.get('version') != _VERSION:
+            return None
+
+        blob = self.blob_path(ref['sha256'])
+        try:
+            if os.path.getsize(blob) != ref['size']:
+                return None
+        except OSError:
+            return None
+        return blob
+
+    def install(self, url, destination):
+        """Place the cached content of url at destination.
+
+        Returns False if url isn't cached.
+
+        """
+        blob = self._lookup(url)
+        if blob is None:
+            return False
+        try:
+            _place(blob, destination)
+            # Mark the blob as recently used for the eviction.
+            os.utime(blob)
+        except FileNotFoundError:
+            # Evicted in the meantime.
+            return False
+        return True
+
+    def add(self, url, filename, sha256):
+        """Move the downloaded filename into the cache as the content of url.
+
+        Returns the path of the blob.
+
+        """
+        blob = self.blob_path(sha256)
+        core.check_dir(os.path.dirname(blob))
+        os.replace(filename, blob)
+
+        ref = {'version': _VERSION,
+               'url': url,
+               'sha256': sha256,
+               'size': os.path.getsize(blob)}
+        ref_file = self._ref_file(url)
+        core.check_dir(os.path.dirname(ref_file))
+        fd, tmp = tempfile.mkstemp(dir=os.path.dirname(ref_file),
+                                   suffix='.tmp')
+        with os.fdopen(fd, 'w') as f:
+            json.dump(ref, f)
+        os.replace(tmp, ref_file)
+
+        self.evict(keep=blob)
+        return blob
+
+    def evict(self, keep=None):
+        """Remove the least recently used blobs until the budget is met."""
+        if self.max_size is None:
+            return
+
+        with _locked(os.path.join(self.directory, 'locks', 'evict.lock')):
+            blobs = []
+            total = 0
+            for root, _, files in os.walk(os.path.join(self.directory,
+                                                       'blobs')):
+                for name in files:
+                    filename = os.path.join(root, name)
+                    try:
+                        st = os.stat(filename)
+                    except OSError:
+                        continue
+                    blobs.append((st.st_mtime, st.st_size, filename))
+                    total += st.st_size
+
+            for _, size, filename in sorted(blobs):
+                if total <= self.max_size:
+                    break
+                if filename == keep:
+                    continue
+                try:
+                    os.unlink(filename)
+                except OSError:
+                    continue
+                total -= size
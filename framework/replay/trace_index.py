@@ -0,0 +1,169 @@
+# coding=utf-8
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+# OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+# ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+# OTHER DEALINGS IN THE SOFTWARE.
+#
+# SPDX-License-Identifier: MIT
+
+"""Persistent per-trace metadata index.
+
+Finding the last frame of a trace requires running `apitrace dump` or
+gfxrecon-info over the whole file, which for big traces takes about as long
+as the replay itself. The results of that pass are stored in a json file
+named after the sha256 of the trace content, so it is done once per trace
+whatever its path or name.
+
+Hashing a multi-GB trace isn't free either, so the hash is remembered
+together with the size and mtime of the path it was computed for, and only
+recomputed when those change.
+
+The index directory can be set with PIGLIT_REPLAY_INDEX_DIR or
+[replay]:index_dir, setting it to an empty value disables the index.
+
+"""
+
+import hashlib
+import json
+import os
+import tempfile
+
+from framework import core
+
+__all__ = [
+    'TraceIndex',
+    'content_hash',
+]
+
+_VERSION = 1
+_CHUNK_SIZE = 1 << 20
+
+
+def _index_dir():
+    return core.get_cache_dir('PIGLIT_REPLAY_INDEX_DIR',
+                              ('replay', 'index_dir'), 'replay-index')
+
+
+def _read_json(filename):
+    try:
+        with open(filename, 'r') as f:
+            data = json.load(f)
+    except (IOError, OSError, ValueError):
+        return None
+    if not isinstance(data, dict) or data.get('version') != _VERSION:
+        return None
+    return data
+
+
+def _write_json(filename, data):
+    """Write data to filename atomically.
+
+    The index is an optimization, so failing to write it is ignored.
+
+    """
+    data = dict(data, version=_VERSION)
+    try:
+        core.check_dir(os.path.dirname(filename))
+        fd, tmp = tempfile.mkstemp(dir=os.path.dirname(filename),
+                                   suffix='.tmp')
+        with os.fdopen(fd, 'w') as f:
+            json.dump(data, f)
+        os.replace(tmp, filename)
+    except (IOError, OSError):
+        pass
+
+
+def _hash_file(trace_path):
+    sha = hashlib.sha256()
+    with open(trace_path, 'rb') as f:
+        for chunk in iter(lambda: f.read(_CHUNK_SIZE), b''):
+            sha.update(chunk)
+    return sha.hexdigest()
+
+
+def content_hash(trace_path, directory=None):
+    """Return the sha256 of the trace content, or None if it can't be read.
+
+    When directory is given, the hash is remembered there for the path, size
+    and mtime of the trace.
+
+    """
+    try:
+        st = os.stat(trace_path)
+    except OSError:
+        return None
+
+    stamp_file = None
+    if directory:
+        key = hashlib.sha1(
+            os.path.realpath(trace_path).encode('utf-8')).hexdigest()
+        stamp_file = os.path.join(directory, 'stat', key + '.json')
+        stamp = _read_json(stamp_file)
+        if (stamp is not None and stamp.get('size') == st.st_size and
+                stamp.get('mtime_ns') == st.st_mtime_ns):
+            return stamp['sha256']
+
+    try:
+        sha256 = _hash_file(trace_path)
+    except (IOError, OSError):
+        return None
+
+    if stamp_file:
+        _write_json(stamp_file, {'size': st.st_size,
+                                 'mtime_ns': st.st_mtime_ns,
+                                 'sha256': sha256})
+    return sha256
+
+
+class TraceIndex(object):
+    """Metadata stored for a single trace.
+
+    The known keys are:
+    last_frame_call -- the call, or frame for gfxreconstruct, to dump when
+                       no calls are given
+    frames -- the number of the last call of every frame, when known
+    frame_count -- the number of frames in the trace
+
+    """
+
+    def __init__(self, filename):
+        self.filename = filename
+        self.__data = _read_json(filename) or {}
+
+    @classmethod
+    def for_trace(cls, trace_path):
+        """Return the TraceIndex of a trace, or None.
+
+        None is returned if the index is disabled or the trace can't be
+        read.
+
+        """
+        directory = _index_dir()
+        if not directory:
+            return None
+        sha256 = content_hash(trace_path, directory)
+        if sha256 is None:
+            return None
+        return cls(os.path.join(directory, sha256[:2], sha256 + '.json'))
+
+    def get(self, key, default=None):
+        return self.__data.get(key, default)
+
+    def update(self, values):
+        """Merge values into the index and write it back to disk."""
+        self.__data.update(values)
+        _write_json(self.filename, self.__data)
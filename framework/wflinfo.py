@@ -20,12 +20,17 @@
 # SOFTWARE.
 
 import errno
+import fnmatch
+import hashlib
+import json
 import os
 import subprocess
 import sys
+import sysconfig
+import tempfile
 import threading
 
-from framework import exceptions
+from framework import core, exceptions
 from framework.core import lazy_property
 from framework.options import OPTIONS
 # from framework.test import piglit_test
@@ -47,6 +52,118 @@ class ProfileInfo(object):
         self.extensions = extensions
 
 
+class ProfileCache(object):
+    """On-disk cache of ProfileInfo values for a single driver.
+
+    Running wflinfo for every profile at the start of each run is expensive on
+    slow or emulated drivers. This stores the parsed results in a json file
+    named after a hash of the driver identity: the platform, the
+    vendor/renderer/version strings, the mtime of the driver libraries and
+    the driver environment overrides. If any of those change a new file is
+    used, so stale entries are never read.
+
+    """
+    _VERSION = 1
+
+    def __init__(self, directory, identity):
+        self.__lock = threading.Lock()
+        key = hashlib.sha1(
+            json.dumps(identity, sort_keys=True).encode('utf-8')).hexdigest()
+        self.filename = os.path.join(directory, '{}.json'.format(key))
+        self.__data = {}
+
+        try:
+            with open(self.filename, 'r') as f:
+                data = json.load(f)
+        except (IOError, OSError, ValueError):
+            return
+        if data.get('version') == self._VERSION:
+            self.__data = data.get('profiles', {})
+
+    def get(self, profile):
+        """Return the cached ProfileInfo for profile, or None."""
+        with self.__lock:
+            raw = self.__data.get(profile)
+        if raw is None:
+            return None
+        return ProfileInfo(raw['shader_version'], raw['api_version'],
+                           set(raw['extensions']))
+
+    def put(self, profile, info):
+        """Store info for profile and write the cache back to disk.
+
+        The file is written to a temporary name and renamed into place, so
+        concurrent piglit runs never see a partially written cache.
+
+        """
+        with self.__lock:
+            self.__data[profile] = {
+                'shader_version': info.shader_version,
+                'api_version': info.api_version,
+                'extensions': sorted(info.extensions),
+            }
+            try:
+                core.check_dir(os.path.dirname(self.filename))
+                fd, tmp = tempfile.mkstemp(
+                    dir=os.path.dirname(self.filename), suffix='.tmp')
+                with os.fdopen(fd, 'w') as f:
+                    json.dump({'version': self._VERSION,
+                               'profiles': self.__data}, f)
+                os.replace(tmp, self.filename)
+            except (IOError, OSError):
+                # The cache is an optimization, failing to write it must not
+                # stop the run.
+                pass
+
+
+# Environment variables that can change what the driver reports without
+# changing its identity strings, e.g. MESA_EXTENSION_OVERRIDE or
+# MESA_GLSL_VERSION_OVERRIDE.
+_DRIVER_ENV_PREFIXES = ('MESA_', 'LIBGL_', 'GALLIUM_', '__GL_')
+
+
+def _driver_environment():
+    """Return the driver override variables that are set, as a dict."""
+    return {k: v for k, v in os.environ.items()
+            if k.startswith(_DRIVER_ENV_PREFIXES) or k.endswith('_DEBUG')}
+
+
+def _driver_stamp():
+    """Return the newest mtime of the GL driver libraries that can be found.
+
+    This looks in the directories named by the variables mesa and the loader
+    use to locate drivers, and falls back to the usual system library
+    directories.
+
+    """
+    dirs = []
+    for var in ['LIBGL_DRIVERS_PATH', 'GBM_BACKENDS_PATH', 'LD_LIBRARY_PATH']:
+        dirs.extend(d for d in os.environ.get(var, '').split(os.pathsep) if d)
+
+    libdirs = ['/usr/lib', '/usr/lib64', '/usr/local/lib']
+    multiarch = sysconfig.get_config_var('MULTIARCH')
+    if multiarch:
+        libdirs.append(os.path.join('/usr/lib', multiarch))
+    for d in libdirs:
+        dirs.extend([d, os.path.join(d, 'dri')])
+
+    patterns = ['*_dri.so', 'libgallium*.so*', 'libGL.so*', 'libEGL.so*',
+                'libGLX_*.so*', 'libEGL_*.so*']
+    stamp = 0
+    for d in dirs:
+        try:
+            names = os.listdir(d)
+        except OSError:
+            continue
+        for name in names:
+            if any(fnmatch.fnmatch(name, p) for p in patterns):
+                try:
+                    stamp = max(stamp, os.stat(os.path.join(d, name)).st_mtime)
+                except OSError:
+                    pass
+    return stamp
+
+
 class WflInfo(object):
     """Class representing platform information as provided by wflinfo.
 
@@ -71,6 +188,8 @@ class WflInfo(object):
     __es1_lock = threading.Lock()
     __es2_init = False
     __es2_lock = threading.Lock()
+    __cache_init = False
+    __cache_lock = threading.Lock()
 
     def __new__(cls, *args, **kwargs):
         # Implement the borg pattern:
@@ -136,80 +255,61 @@ class WflInfo(object):
                 return line
         raise Exception('Unreachable')
 
-    def __get_shader_version(self, profile):
+    @staticmethod
+    def __profile_args(profile):
+        if profile in ['core', 'compat', 'none']:
+            return ['--verbose', '--api', 'gl', '--profile', profile]
+        return ['--verbose', '--api', profile]
+
+    def __get_shader_version(self, profile, raw):
         """Calculate the maximum OpenGL Shader Language version."""
         ret = 0.0
         if profile in ['core', 'compat', 'none']:
             try:
-                raw = self.__call_wflinfo(
-                    ['--verbose', '--api', 'gl', '--profile', profile])
-            except StopWflinfo as e:
-                if e.reason not in ['Called', 'OSError']:
-                    raise
-            else:
-                try:
-                    # GLSL versions are M.mm formatted
-                    line = self.__getline(raw.split('\n'), 'OpenGL shading language')
-                    ret = float(line.split(":")[1][:5])
-                except (IndexError, ValueError):
-                    # This is caused by wflinfo returning an error
-                    pass
+                # GLSL versions are M.mm formatted
+                line = self.__getline(raw.split('\n'), 'OpenGL shading language')
+                ret = float(line.split(":")[1][:5])
+            except (IndexError, ValueError):
+                # This is caused by wflinfo returning an error
+                pass
         elif profile in ['gles2', 'gles3']:
             try:
-                raw = self.__call_wflinfo(['--verbose', '--api', profile])
-            except StopWflinfo as e:
-                if e.reason not in ['Called', 'OSError']:
-                    raise
-            else:
-                try:
-                    # GLSL ES version numbering is insane.
-                    # For version >= 3 the numbers are 3.00, 3.10, etc.
-                    # For version 2, they are 1.0.xx
-                    ret = float(self.__getline(
-                        raw.split('\n'),
-                        'OpenGL shading language').split()[-1][:3])
-                except (IndexError, ValueError):
-                    # Handle wflinfo internal errors
-                    pass
+                # GLSL ES version numbering is insane.
+                # For version >= 3 the numbers are 3.00, 3.10, etc.
+                # For version 2, they are 1.0.xx
+                ret = float(self.__getline(
+                    raw.split('\n'),
+                    'OpenGL shading language').split()[-1][:3])
+            except (IndexError, ValueError):
+                # Handle wflinfo internal errors
+                pass
         return ret
 
-    def __get_language_version(self, profile):
+    def __get_language_version(self, profile, raw):
         ret = 0.0
         if profile in ['core', 'compat', 'none']:
             try:
-                raw = self.__call_wflinfo(['--api', 'gl', '--profile', profile])
-            except StopWflinfo as e:
-                if e.reason not in ['Called', 'OSError']:
-                    raise
-            else:
-                try:
-                    # Grab the GL version string, trim any release_number values
-                    ret = float(self.__getline(
-                        raw.split('\n'),
-                        'OpenGL version string').split()[3][:3])
-                except (IndexError, ValueError):
-                    # This is caused by wlfinfo returning an error
-                    pass
+                # Grab the GL version string, trim any release_number values
+                ret = float(self.__getline(
+                    raw.split('\n'),
+                    'OpenGL version string').split()[3][:3])
+            except (IndexError, ValueError):
+                # This is caused by wlfinfo returning an error
+                pass
         else:
             try:
-                raw = self.__call_wflinfo(['--api', profile])
-            except StopWflinfo as e:
-                if e.reason not in ['Called', 'OSError']:
-                    raise
-            else:
-                try:
-                    # Yes, search for "OpenGL version string" in GLES
-                    # GLES doesn't support patch versions.
-                    ret = float(self.__getline(
-                        raw.split('\n'),
-                        'OpenGL version string').split()[5])
-                except (IndexError, ValueError):
-                    # This is caused by wlfinfo returning an error
-                    pass
+                # Yes, search for "OpenGL version string" in GLES
+                # GLES doesn't support patch versions.
+                ret = float(self.__getline(
+                    raw.split('\n'),
+                    'OpenGL version string').split()[5])
+            except (IndexError, ValueError):
+                # This is caused by wlfinfo returning an error
+                pass
         return ret
 
-    def __get_extensions(self, profile):
-        """Call wflinfo to get opengl extensions.
+    def __get_extensions(self, raw):
+        """Parse the opengl extensions out of the wflinfo output.
 
         This provides a very conservative set of extensions, it provides every
         extension from gles1, 2 and 3 and from GL both core and compat profile
@@ -219,27 +319,8 @@ class WflInfo(object):
 
         """
         _trim = len('OpenGL extensions: ')
-        all_ = set()
-
-        def helper(args):
-            """Helper function to reduce code duplication."""
-            # This is a pretty fragile function but it really does help with
-            # duplication
-            ret = self.__call_wflinfo(args)
-            all_.update(set(self.__getline(
-                ret.split('\n'), 'OpenGL extensions')[_trim:].split()))
-
-        try:
-            if profile in ['core', 'compat', 'none']:
-                helper(['--verbose', '--api', 'gl', '--profile', profile])
-            else:
-                helper(['--verbose', '--api', profile])
-        except StopWflinfo as e:
-            # Handle wflinfo not being installed by returning an empty set. This
-            # will essentially make FastSkipMixin a no-op.
-            if e.reason in ['OSError', 'Called']:
-                return set()
-            raise
+        all_ = set(self.__getline(
+            raw.split('\n'), 'OpenGL extensions')[_trim:].split())
 
         # Don't return a set with only WFLINFO_GL_ERROR.
         ret = {e.strip() for e in all_}
@@ -247,12 +328,84 @@ class WflInfo(object):
             return set()
         return ret
 
+    def __get_cache(self):
+        """Return the ProfileCache for the current driver, or None.
+
+        The driver identity is established with a single non-verbose wflinfo
+        call, which is much cheaper than the verbose per-profile probes it
+        replaces on a cache hit.
+
+        The cache directory can be set with PIGLIT_WFLINFO_CACHE_DIR or
+        [wflinfo]:cache_dir, setting it to an empty value disables caching.
+
+        """
+        with self.__cache_lock:
+            if self.__cache_init:
+                return self.__cache
+            self.__cache_init = True
+            self.__cache = None
+
+            directory = core.get_cache_dir(
+                'PIGLIT_WFLINFO_CACHE_DIR', ('wflinfo', 'cache_dir'),
+                'wflinfo')
+            if directory is None:
+                return None
+
+            for args in [['--api', 'gl'], ['--api', 'gles2']]:
+                try:
+                    raw = self.__call_wflinfo(args)
+                except StopWflinfo as e:
+                    if e.reason == 'OSError':
+                        return None
+                    if e.reason != 'Called':
+                        raise
+                    continue
+
+                lines = raw.split('\n')
+                identity = {'platform': OPTIONS.env['PIGLIT_PLATFORM'],
+                            'driver': _driver_stamp(),
+                            'environment': _driver_environment()}
+                for name in ['vendor', 'renderer', 'version']:
+                    line = 'OpenGL {} string'.format(name)
+                    try:
+                        identity[name] = self.__getline(lines, line)
+                    except Exception:  # pylint: disable=broad-except
+                        identity[name] = None
+                if identity['renderer'] is None or any(
+                        'WFLINFO_GL_ERROR' in (identity[n] or '')
+                        for n in ['vendor', 'renderer', 'version']):
+                    continue
+
+                self.__cache = ProfileCache(directory, identity)
+                break
+            return self.__cache
+
     def __build_info(self, profile):
-        return ProfileInfo(
-            self.__get_shader_version(profile),
-            self.__get_language_version(profile),
-            self.__get_extensions(profile)
-        )
+        cache = self.__get_cache()
+        if cache is not None:
+            info = cache.get(profile)
+            if info is not None:
+                return info
+
+        try:
+            raw = self.__call_wflinfo(self.__profile_args(profile))
+        except StopWflinfo as e:
+            # Handle wflinfo not being installed by returning an empty set.
+            # This will essentially make FastSkipMixin a no-op.
+            if e.reason not in ['Called', 'OSError']:
+                raise
+            if e.reason == 'OSError':
+                return ProfileInfo(0.0, 0.0, set())
+            info = ProfileInfo(0.0, 0.0, set())
+        else:
+            info = ProfileInfo(
+                self.__get_shader_version(profile, raw),
+                self.__get_language_version(profile, raw),
+                self.__get_extensions(raw)
+            )
+        if cache is not None:
+            cache.put(profile, info)
+        return info
 
     @lazy_property
     def core(self):
@@ -233,10 +233,27 @@ TestVector = collections.namedtuple(
     'TestVector', ('arguments', 'result', 'tolerance'))
 
 
+def _type_key(value):
+    """Return a hashable key which determines glsl_type_of(value)."""
+    return type(value), getattr(value, 'dtype', None), \
+        getattr(value, 'shape', ())
+
+
+# Cache of glsl_type_of() results, indexed by _type_key().
+_glsl_types = {}
+
+
 def glsl_type_of(value):
     """Return the GLSL type corresponding to the given native numpy
     value, as a GlslBuiltinType.
     """
+    key = _type_key(value)
+    if key not in _glsl_types:
+        _glsl_types[key] = _glsl_type_of(value)
+    return _glsl_types[key]
+
+
+def _glsl_type_of(value):
     if isinstance(value, FLOATING_TYPES):
         return glsl_float
     elif isinstance(value, (bool, np.bool_)):
@@ -465,18 +482,25 @@ def _not_equal(x, y):
     return not _equal(x, y)
 
 
+# _arctan2() through _smoothstep() are evaluated by _simulate_batch(),
+# so they operate elementwise on arrays holding every value of each
+# argument, and mark undefined results with _undefined_where() rather
+# than returning None.
+def _undefined_where(condition, value):
+    """Mark the elements of value for which condition holds as
+    undefined.
+    """
+    return np.ma.masked_where(np.broadcast_to(condition, np.shape(value)),
+                              value)
+
+
 def _arctan2(y, x):
-    if x == y == 0.0:
-        return None
-    return np.arctan2(y, x)
+    return _undefined_where((x == 0.0) & (y == 0.0), np.arctan2(y, x))
 
 
 def _pow(x, y):
-    if x < 0.0:
-        return None
-    if x == 0.0 and y <= 0.0:
-        return None
-    return np.power(x, y)
+    return _undefined_where((x < 0.0) | ((x == 0.0) & (y <= 0.0)),
+                            np.power(x, y))
 
 
 def _exp2(x):
@@ -492,20 +516,25 @@ def _trunc(x):
 
 
 def _clamp(x, minVal, maxVal):
-    if minVal > maxVal:
-        return None
-    return min(max(x, minVal), maxVal)
+    return _undefined_where(minVal > maxVal,
+                            np.minimum(np.maximum(x, minVal), maxVal))
+
+
+def _min3(x, y, z):
+    return np.minimum(np.minimum(x, y), z)
+
+
+def _max3(x, y, z):
+    return np.maximum(np.maximum(x, y), z)
 
 
 # Inefficient, but obvious
 def _mid3(x, y, z):
-    return np.sort([x, y, z])[1]
+    return np.sort([x, y, z], axis=0)[1]
 
 def _smoothstep(edge0, edge1, x):
-    if edge0 >= edge1:
-        return None
-    t = _clamp((x-edge0)/(edge1-edge0), 0.0, 1.0)
-    return t*t*(3.0-2.0*t)
+    t = np.minimum(np.maximum((x-edge0)/(edge1-edge0), 0.0), 1.0)
+    return _undefined_where(edge0 >= edge1, t*t*(3.0-2.0*t))
 
 
 def _normalize(x):
@@ -661,6 +690,51 @@ def _simulate_function(test_inputs, python_equivalent, tolerance_function):
     return test_vectors
 
 
+# Elementwise versions of the tolerance functions above, for use by
+# _simulate_batch().  np.linalg.norm() of a scalar is computed as
+# sqrt(x*x), which is spelled out here so that the batched tolerances
+# round exactly like the ones computed one result at a time.
+_batch_tolerances = {
+    _strict_tolerance: lambda result: 1e-5 * np.sqrt(result * result),
+    _trig_tolerance:
+        lambda result: np.maximum(1e-4, 1e-3 * np.sqrt(result * result)),
+}
+
+
+def _simulate_batch(test_inputs, python_equivalent, tolerance_function):
+    """Construct test vectors by simulating a GLSL function on a list
+    of possible scalar inputs, and return a list of test vectors.
+
+    This produces the same test vectors as _simulate_function(), but
+    python_equivalent is called only once, with one numpy array per
+    argument holding the value of that argument in every input
+    sequence.  It should operate elementwise and mark the results that
+    are undefined in GLSL using _undefined_where(); the corresponding
+    input sequences are ignored.
+
+    tolerance_function must have an elementwise version in
+    _batch_tolerances.
+    """
+    if not test_inputs:
+        return []
+    arguments = [np.array([extend_to_64_bits(x) for x in column])
+                 for column in zip(*test_inputs)]
+    # Undefined elements are computed as well, so they may overflow or
+    # divide by zero.
+    with np.errstate(all='ignore'):
+        expected_outputs = python_equivalent(*arguments)
+    defined = ~np.ma.getmaskarray(expected_outputs)
+    expected_outputs = np.ma.getdata(expected_outputs)
+    if expected_outputs.dtype in FLOATING_TYPES:
+        tolerances = _batch_tolerances[tolerance_function](expected_outputs)
+    else:
+        tolerances = np.zeros(len(test_inputs))
+    expected_outputs = round_to_32_bits(expected_outputs)
+    tolerances = round_to_32_bits(tolerances)
+    return [TestVector(test_inputs[i], expected_outputs[i], tolerances[i])
+            for i in np.flatnonzero(defined)]
+
+
 def _vectorize_test_vectors(test_vectors, scalar_arg_indices, vector_length):
     """Build a new set of test vectors by combining elements of
     test_vectors into vectors of length vector_length. For example,
@@ -745,6 +819,8 @@ def _store_test_vector(test_suite_dict, name, glsl_version, extension, test_vect
 
     If template is supplied, it is used insted as the template for the
     Signature objects generated.
+
+    Return the Signature under which the test vector was stored.
     """
     if template is None:
         arg_indices = range(len(test_vector.arguments))
@@ -760,6 +836,7 @@ def _store_test_vector(test_suite_dict, name, glsl_version, extension, test_vect
     if signature not in test_suite_dict:
         test_suite_dict[signature] = []
     test_suite_dict[signature].append(test_vector)
+    return signature
 
 
 def _store_test_vectors(test_suite_dict, name, glsl_version, extension,
@@ -770,9 +847,18 @@ def _store_test_vectors(test_suite_dict, name, glsl_version, extension,
     If template is supplied, it is used insted as the template for the
     Signature objects generated.
     """
+    # Test vectors stored together mostly share the same types, so only
+    # work out the signature once for each combination of types.
+    signatures = {}
     for test_vector in test_vectors:
-        _store_test_vector(test_suite_dict, name, glsl_version, extension,
-                           test_vector, template=template)
+        key = tuple(_type_key(value) for value in itertools.chain(
+            [test_vector.result], test_vector.arguments))
+        if key in signatures:
+            test_suite_dict[signatures[key]].append(test_vector)
+        else:
+            signatures[key] = _store_test_vector(
+                test_suite_dict, name, glsl_version, extension,
+                test_vector, template=template)
 
 
 def make_arguments(input_generators):
@@ -820,9 +906,10 @@ def _make_componentwise_test_vectors(test_suite_dict):
         """Create test vectors for the function with the given name
         and arity, which was introduced in the given glsl_version.
 
-        python_equivalent is a Python function which operates on scalars,
-        and simulates the GLSL function.  This function should return None
-        in any case where the output of the GLSL function is undefined.
+        python_equivalent is a Python function which simulates the GLSL
+        function elementwise on arrays of scalars (see _simulate_batch()).
+        It should use _undefined_where() to mark any case where the output
+        of the GLSL function is undefined.
 
         If alternate_scalar_arg_indices is not None, also create test
         vectors for an alternate vectorized version of the function,
@@ -838,7 +925,7 @@ def _make_componentwise_test_vectors(test_suite_dict):
         should be used to compute the tolerance for the test vectors.
         Otherwise, _strict_tolerance is used.
         """
-        scalar_test_vectors = _simulate_function(
+        scalar_test_vectors = _simulate_batch(
             make_arguments(test_inputs), python_equivalent, tolerance_function)
         _store_test_vectors(
             test_suite_dict, name, glsl_version, extension, scalar_test_vectors)
@@ -922,29 +1009,29 @@ def _make_componentwise_test_vectors(test_suite_dict):
       [np.linspace(-2.0, 2.0, 4)])
     f('mod', 2, 110, lambda x, y: x-y*np.floor(x/y), [1],
       [np.linspace(-1.9, 1.9, 4), np.linspace(-2.0, 2.0, 4)])
-    f('min', 2, 110, min, [1],
+    f('min', 2, 110, np.minimum, [1],
       [np.linspace(-2.0, 2.0, 4), np.linspace(-2.0, 2.0, 4)])
-    f('min', 2, 130, min, [1], [ints, ints])
-    f('min', 2, 130, min, [1], [uints, uints])
-    f('max', 2, 110, max, [1],
+    f('min', 2, 130, np.minimum, [1], [ints, ints])
+    f('min', 2, 130, np.minimum, [1], [uints, uints])
+    f('max', 2, 110, np.maximum, [1],
       [np.linspace(-2.0, 2.0, 4), np.linspace(-2.0, 2.0, 4)])
-    f('max', 2, 130, max, [1], [ints, ints])
-    f('max', 2, 130, max, [1], [uints, uints])
-    f('min3', 2, 110, min, None,
+    f('max', 2, 130, np.maximum, [1], [ints, ints])
+    f('max', 2, 130, np.maximum, [1], [uints, uints])
+    f('min3', 2, 110, _min3, None,
       [np.linspace(-2.0, 2.0, 4), np.linspace(-2.0, 2.0, 4),
        np.linspace(-2.0, 2.0, 4)],
       extension="AMD_shader_trinary_minmax")
-    f('min3', 2, 130, min, None, [ints, ints, ints],
+    f('min3', 2, 130, _min3, None, [ints, ints, ints],
       extension="AMD_shader_trinary_minmax")
-    f('min3', 2, 130, min, None, [uints, uints, uints],
+    f('min3', 2, 130, _min3, None, [uints, uints, uints],
       extension="AMD_shader_trinary_minmax")
-    f('max3', 2, 110, max, None,
+    f('max3', 2, 110, _max3, None,
       [np.linspace(-2.0, 2.0, 4), np.linspace(-2.0, 2.0, 4),
        np.linspace(-2.0, 2.0, 4)],
       extension="AMD_shader_trinary_minmax")
-    f('max3', 2, 130, max, None, [ints, ints, ints],
+    f('max3', 2, 130, _max3, None, [ints, ints, ints],
       extension="AMD_shader_trinary_minmax")
-    f('max3', 2, 130, max, None, [uints, uints, uints],
+    f('max3', 2, 130, _max3, None, [uints, uints, uints],
       extension="AMD_shader_trinary_minmax")
     f('mid3', 2, 110, _mid3, None,
       [np.linspace(-2.0, 2.0, 4), np.linspace(-2.0, 2.0, 4),
@@ -961,9 +1048,9 @@ def _make_componentwise_test_vectors(test_suite_dict):
     f('mix', 3, 110, lambda x, y, a: x*(1-a)+y*a, [2],
       [np.linspace(-2.0, 2.0, 2), np.linspace(-3.0, 3.0, 2),
        np.linspace(0.0, 1.0, 4)])
-    f('mix', 3, 130, lambda x, y, a: y if a else x, None,
+    f('mix', 3, 130, lambda x, y, a: np.where(a, y, x), None,
       [np.linspace(-2.0, 2.0, 2), np.linspace(-3.0, 3.0, 2), bools])
-    f('step', 2, 110, lambda edge, x: 0.0 if x < edge else 1.0, [0],
+    f('step', 2, 110, lambda edge, x: np.where(x < edge, 0.0, 1.0), [0],
       [np.linspace(-2.0, 2.0, 4), np.linspace(-2.0, 2.0, 4)])
     f('smoothstep', 3, 110, _smoothstep, [0, 1],
       [np.linspace(-1.9, 1.9, 4), np.linspace(-1.9, 1.9, 4),
@@ -973,23 +1060,23 @@ def _make_componentwise_test_vectors(test_suite_dict):
       extension="ARB_gpu_shader_int64")
     f('sign', 1, 150, np.sign, None, [np.linspace(-15, 15, 5).astype(np.int64)],
       extension="ARB_gpu_shader_int64")
-    f('min', 2, 150, min, [1],
+    f('min', 2, 150, np.minimum, [1],
       [np.linspace(-20, 20, 4).astype(np.int64), np.linspace(-20, 20, 4).astype(np.int64)],
       extension="ARB_gpu_shader_int64")
-    f('min', 2, 150, min, [1],
+    f('min', 2, 150, np.minimum, [1],
       [np.linspace(20, 90, 4).astype(np.uint64), np.linspace(20, 90, 4).astype(np.uint64)],
       extension="ARB_gpu_shader_int64")
-    f('max', 2, 150, max, [1],
+    f('max', 2, 150, np.maximum, [1],
       [np.linspace(-20, 20, 4).astype(np.int64), np.linspace(-20, 20, 4).astype(np.int64)],
       extension="ARB_gpu_shader_int64")
-    f('max', 2, 150, max, [1],
+    f('max', 2, 150, np.maximum, [1],
       [np.linspace(20, 90, 4).astype(np.uint64), np.linspace(20, 90, 4).astype(np.uint64)],
       extension="ARB_gpu_shader_int64")
     f('clamp', 3, 150, _clamp, [1, 2], [np.linspace(-20, 20, 4).astype(np.int64),
                                    np.linspace(-15, 15, 3).astype(np.int64),
                                    np.linspace(-15, 15, 3).astype(np.int64)],
       extension="ARB_gpu_shader_int64")
-    f('mix', 3, 150, lambda x, y, a: y if a else x, None,
+    f('mix', 3, 150, lambda x, y, a: np.where(a, y, x), None,
       [np.linspace(-20, 20, 2).astype(np.int64), np.linspace(-30, 30, 2).astype(np.int64), bools],
       extension="ARB_gpu_shader_int64")
 _make_componentwise_test_vectors(test_suite)
@@ -1014,8 +1101,8 @@ def _make_vector_relational_test_vectors(test_suite_dict):
         """Make test vectors for the function with the given name and
         arity, which was introduced in the given glsl_version.
 
-        python_equivalent is a Python function which operates on scalars,
-        and simulates the GLSL function.
+        python_equivalent is a Python function which simulates the GLSL
+        function elementwise on arrays of scalars (see _simulate_batch()).
 
         arg_types is a string containing 'v' if the function supports
         standard "vec" inputs, 'i' if it supports "ivec" inputs, and 'b'
@@ -1028,7 +1115,7 @@ def _make_vector_relational_test_vectors(test_suite_dict):
         """
         for arg_type in arg_types:
             test_inputs = [_default_inputs[arg_type]]*arity
-            scalar_test_vectors = _simulate_function(
+            scalar_test_vectors = _simulate_batch(
                 make_arguments(test_inputs), python_equivalent,
                 tolerance_function)
             for vector_length in (2, 3, 4):
@@ -1043,7 +1130,7 @@ def _make_vector_relational_test_vectors(test_suite_dict):
     f('greaterThanEqual', 2, 110, lambda x, y: x >= y, 'viu')
     f('equal', 2, 110, lambda x, y: x == y, 'viub')
     f('notEqual', 2, 110, lambda x, y: x != y, 'viub')
-    f('not', 1, 110, lambda x: not x, 'b')
+    f('not', 1, 110, np.logical_not, 'b')
 _make_vector_relational_test_vectors(test_suite)
 
 
@@ -213,11 +213,27 @@ TestVector = collections.namedtuple(
     'TestVector', ('arguments', 'result', 'tolerance'))
 
 
+def _type_key(value):
+    """Return a hashable key which determines glsl_type_of(value)."""
+    return type(value), getattr(value, 'dtype', None), \
+        getattr(value, 'shape', ())
+
+
+# Cache of glsl_type_of() results, indexed by _type_key().
+_glsl_types = {}
+
+
 def glsl_type_of(value):
     """Return the GLSL type corresponding to the given native numpy
     value, as a GlslBuiltinType.
     """
+    key = _type_key(value)
+    if key not in _glsl_types:
+        _glsl_types[key] = _glsl_type_of(value)
+    return _glsl_types[key]
 
+
+def _glsl_type_of(value):
     if isinstance(value, DOUBLE_TYPES):
         return glsl_double
     elif isinstance(value, (bool, np.bool_)):
@@ -368,18 +384,25 @@ def _not_equal(x, y):
     return not _equal(x, y)
 
 
+# _arctan2() through _smoothstep() are evaluated by _simulate_batch(),
+# so they operate elementwise on arrays holding every value of each
+# argument, and mark undefined results with _undefined_where() rather
+# than returning None.
+def _undefined_where(condition, value):
+    """Mark the elements of value for which condition holds as
+    undefined.
+    """
+    return np.ma.masked_where(np.broadcast_to(condition, np.shape(value)),
+                              value)
+
+
 def _arctan2(y, x):
-    if x == y == 0.0:
-        return None
-    return np.arctan2(y, x)
+    return _undefined_where((x == 0.0) & (y == 0.0), np.arctan2(y, x))
 
 
 def _pow(x, y):
-    if x < 0.0:
-        return None
-    if x == 0.0 and y <= 0.0:
-        return None
-    return np.power(x, y)
+    return _undefined_where((x < 0.0) | ((x == 0.0) & (y <= 0.0)),
+                            np.power(x, y))
 
 
 def _exp2(x):
@@ -395,20 +418,17 @@ def _trunc(x):
 
 
 def _clamp(x, minVal, maxVal):
-    if minVal > maxVal:
-        return None
-    return min(max(x, minVal), maxVal)
+    return _undefined_where(minVal > maxVal,
+                            np.minimum(np.maximum(x, minVal), maxVal))
 
 
 # Inefficient, but obvious
 def _mid3(x, y, z):
-    return np.sort([x, y, z])[1]
+    return np.sort([x, y, z], axis=0)[1]
 
 def _smoothstep(edge0, edge1, x):
-    if edge0 >= edge1:
-        return None
-    t = _clamp((x-edge0)/(edge1-edge0), 0.0, 1.0)
-    return t*t*(3.0-2.0*t)
+    t = np.minimum(np.maximum((x-edge0)/(edge1-edge0), 0.0), 1.0)
+    return _undefined_where(edge0 >= edge1, t*t*(3.0-2.0*t))
 
 
 def _normalize(x):
@@ -538,6 +558,48 @@ def _simulate_function(test_inputs, python_equivalent, tolerance_function):
     return test_vectors
 
 
+# Elementwise versions of the tolerance functions above, for use by
+# _simulate_batch().  np.linalg.norm() of a scalar is computed as
+# sqrt(x*x), which is spelled out here so that the batched tolerances
+# round exactly like the ones computed one result at a time.
+_batch_tolerances = {
+    _strict_tolerance: lambda result: 1e-5 * np.sqrt(result * result),
+    _trig_tolerance:
+        lambda result: np.maximum(1e-4, 1e-3 * np.sqrt(result * result)),
+}
+
+
+def _simulate_batch(test_inputs, python_equivalent, tolerance_function):
+    """Construct test vectors by simulating a GLSL function on a list
+    of possible scalar inputs, and return a list of test vectors.
+
+    This produces the same test vectors as _simulate_function(), but
+    python_equivalent is called only once, with one numpy array per
+    argument holding the value of that argument in every input
+    sequence.  It should operate elementwise and mark the results that
+    are undefined in GLSL using _undefined_where(); the corresponding
+    input sequences are ignored.
+
+    tolerance_function must have an elementwise version in
+    _batch_tolerances.
+    """
+    if not test_inputs:
+        return []
+    arguments = [np.array(column) for column in zip(*test_inputs)]
+    # Undefined elements are computed as well, so they may overflow or
+    # divide by zero.
+    with np.errstate(all='ignore'):
+        expected_outputs = python_equivalent(*arguments)
+    defined = ~np.ma.getmaskarray(expected_outputs)
+    expected_outputs = np.ma.getdata(expected_outputs)
+    # Like np.linalg.norm(), compute the tolerance of boolean results
+    # as if they were floats.
+    tolerances = _batch_tolerances[tolerance_function](
+        expected_outputs.astype(np.float64))
+    return [TestVector(test_inputs[i], expected_outputs[i], tolerances[i])
+            for i in np.flatnonzero(defined)]
+
+
 def _vectorize_test_vectors(test_vectors, scalar_arg_indices, vector_length):
     """Build a new set of test vectors by combining elements of
     test_vectors into vectors of length vector_length. For example,
@@ -621,6 +683,8 @@ def _store_test_vector(test_suite_dict, name, glsl_version, extension, test_vect
 
     If template is supplied, it is used insted as the template for the
     Signature objects generated.
+
+    Return the Signature under which the test vector was stored.
     """
     if template is None:
         arg_indices = range(len(test_vector.arguments))
@@ -635,6 +699,7 @@ def _store_test_vector(test_suite_dict, name, glsl_version, extension, test_vect
     if signature not in test_suite_dict:
         test_suite_dict[signature] = []
     test_suite_dict[signature].append(test_vector)
+    return signature
 
 
 def _store_test_vectors(test_suite_dict, name, glsl_version, extension,
@@ -645,9 +710,18 @@ def _store_test_vectors(test_suite_dict, name, glsl_version, extension,
     If template is supplied, it is used insted as the template for the
     Signature objects generated.
     """
+    # Test vectors stored together mostly share the same types, so only
+    # work out the signature once for each combination of types.
+    signatures = {}
     for test_vector in test_vectors:
-        _store_test_vector(test_suite_dict, name, glsl_version, extension,
-                           test_vector, template=template)
+        key = tuple(_type_key(value) for value in itertools.chain(
+            [test_vector.result], test_vector.arguments))
+        if key in signatures:
+            test_suite_dict[signatures[key]].append(test_vector)
+        else:
+            signatures[key] = _store_test_vector(
+                test_suite_dict, name, glsl_version, extension,
+                test_vector, template=template)
 
 
 def make_arguments(input_generators):
@@ -690,9 +764,10 @@ def _make_componentwise_test_vectors(test_suite_dict):
         """Create test vectors for the function with the given name
         and arity, which was introduced in the given glsl_version.
 
-        python_equivalent is a Python function which operates on scalars,
-        and simulates the GLSL function.  This function should return None
-        in any case where the output of the GLSL function is undefined.
+        python_equivalent is a Python function which simulates the GLSL
+        function elementwise on arrays of scalars (see _simulate_batch()).
+        It should use _undefined_where() to mark any case where the output
+        of the GLSL function is undefined.
 
         If alternate_scalar_arg_indices is not None, also create test
         vectors for an alternate vectorized version of the function,
@@ -708,7 +783,7 @@ def _make_componentwise_test_vectors(test_suite_dict):
         should be used to compute the tolerance for the test vectors.
         Otherwise, _strict_tolerance is used.
         """
-        scalar_test_vectors = _simulate_function(
+        scalar_test_vectors = _simulate_batch(
             make_arguments(test_inputs), python_equivalent, tolerance_function)
         _store_test_vectors(
             test_suite_dict, name, 400, None, scalar_test_vectors)
@@ -769,18 +844,18 @@ def _make_componentwise_test_vectors(test_suite_dict):
       [np.linspace(-2.0, 2.0, 4)])
     f('mod', 2, lambda x, y: x-y*np.floor(x/y), [1],
       [np.linspace(-1.9, 1.9, 4), np.linspace(-2.0, 2.0, 4)])
-    f('min', 2, min, [1],
+    f('min', 2, np.minimum, [1],
       [np.linspace(-2.0, 2.0, 4), np.linspace(-2.0, 2.0, 4)])
-    f('max', 2, max, [1],
+    f('max', 2, np.maximum, [1],
       [np.linspace(-2.0, 2.0, 4), np.linspace(-2.0, 2.0, 4)])
     f('clamp', 3, _clamp, [1, 2], [np.linspace(-2.0, 2.0, 4),
       np.linspace(-1.5, 1.5, 3), np.linspace(-1.5, 1.5, 3)])
     f('mix', 3, lambda x, y, a: x*(1-a)+y*a, [2],
       [np.linspace(-2.0, 2.0, 2), np.linspace(-3.0, 3.0, 2),
        np.linspace(0.0, 1.0, 4)])
-    f('mix', 3, lambda x, y, a: y if a else x, None,
+    f('mix', 3, lambda x, y, a: np.where(a, y, x), None,
       [np.linspace(-2.0, 2.0, 2), np.linspace(-3.0, 3.0, 2), bools])
-    f('step', 2, lambda edge, x: 0.0 if x < edge else 1.0, [0],
+    f('step', 2, lambda edge, x: np.where(x < edge, 0.0, 1.0), [0],
       [np.linspace(-2.0, 2.0, 4), np.linspace(-2.0, 2.0, 4)])
     f('smoothstep', 3, _smoothstep, [0, 1],
       [np.linspace(-1.9, 1.9, 4), np.linspace(-1.9, 1.9, 4),
@@ -806,8 +881,8 @@ def _make_vector_relational_test_vectors(test_suite_dict):
         """Make test vectors for the function with the given name and
         arity, which was introduced in the given glsl_version.
 
-        python_equivalent is a Python function which operates on scalars,
-        and simulates the GLSL function.
+        python_equivalent is a Python function which simulates the GLSL
+        function elementwise on arrays of scalars (see _simulate_batch()).
 
         arg_types is a string containing 'v' if the function supports
         standard "vec" inputs, 'i' if it supports "ivec" inputs, and 'b'
@@ -820,7 +895,7 @@ def _make_vector_relational_test_vectors(test_suite_dict):
         """
         for arg_type in arg_types:
             test_inputs = [_default_inputs[arg_type]]*arity
-            scalar_test_vectors = _simulate_function(
+            scalar_test_vectors = _simulate_batch(
                 make_arguments(test_inputs), python_equivalent,
                 tolerance_function)
             for vector_length in (2, 3, 4):
@@ -1029,7 +1029,7 @@ class ShaderTest(object):
         dirname = os.path.dirname(self.filename)
         utils.safe_makedirs(dirname)
 
-        with open(self.filename, "w") as f:
+        with utils.open_if_changed(self.filename) as f:
             f.write(self.__template.render_unicode(func=self.__func_info))
 
 
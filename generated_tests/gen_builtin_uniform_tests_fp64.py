@@ -511,7 +511,7 @@ class ShaderTest(object):
         filename = self.filename()
         dirname = os.path.dirname(filename)
         utils.safe_makedirs(dirname)
-        with open(filename, 'w') as f:
+        with utils.open_if_changed(filename) as f:
             f.write(shader_test)
 
 
@@ -642,9 +642,10 @@ def main():
         action='store_true',
         help="Don't output files, just generate a list of filenames to stdout")
     options, args = parser.parse_args()
-    for test in all_tests():
-        if not options.names_only:
-            test.generate_shader_test()
+    tests = list(all_tests())
+    if not options.names_only:
+        utils.parallel_map(lambda test: test.generate_shader_test(), tests)
+    for test in tests:
         print(test.filename())
 
 
@@ -204,7 +204,7 @@ class ParserTest(object):
         filename = self.filename()
         dirname = os.path.dirname(filename)
         utils.safe_makedirs(dirname)
-        with open(filename, 'w') as f:
+        with utils.open_if_changed(filename) as f:
             f.write(parser_test)
 
 
@@ -266,9 +266,10 @@ def main():
                            "filenames to stdout")
     options, args = parser.parse_args()
 
-    for test in all_tests():
-        if not options.names_only:
-            test.generate_parser_test()
+    tests = list(all_tests())
+    if not options.names_only:
+        utils.parallel_map(lambda test: test.generate_parser_test(), tests)
+    for test in tests:
         print(test.filename())
 
 
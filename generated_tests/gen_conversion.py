@@ -569,7 +569,7 @@ class RegularTestTuple(TestTuple):
         self._filenames.append(filename)
 
         if not self._names_only:
-            with open(filename, 'w') as test_file:
+            with utils.open_if_changed(filename) as test_file:
                 test_file.write(TEMPLATES.get_template(
                     'compiler.{}.mako'.format(self._stage)).render_unicode(
                         ver=self._ver,
@@ -589,7 +589,7 @@ class RegularTestTuple(TestTuple):
         self._filenames.append(filename)
 
         if not self._names_only:
-            with open(filename, 'w') as test_file:
+            with utils.open_if_changed(filename) as test_file:
                 test_file.write(TEMPLATES.get_template(
                     'execution.{}.shader_test.mako'.format(self._stage)).render_unicode(
                         ver=self._ver,
@@ -767,7 +767,7 @@ class ZeroSignTestTuple(TestTuple):
         self._filenames.append(filename)
 
         if not self._names_only:
-            with open(filename, 'w') as test_file:
+            with utils.open_if_changed(filename) as test_file:
                 test_file.write(TEMPLATES.get_template(
                     'execution-zero-sign.{}.shader_test.mako'.format(
                         self._stage)).render_unicode(
@@ -830,9 +830,11 @@ def main():
 
     np.seterr(divide='ignore')
 
-    for test in (list(RegularTestTuple.all_tests(args.names_only)) +
-                 list(ZeroSignTestTuple.all_tests(args.names_only))):
-        test.generate_test_files()
+    tests = (list(RegularTestTuple.all_tests(args.names_only)) +
+             list(ZeroSignTestTuple.all_tests(args.names_only)))
+    if not args.names_only:
+        utils.parallel_map(lambda test: test.generate_test_files(), tests)
+    for test in tests:
         for filename in test.filenames:
             print(filename)
 
@@ -150,9 +150,8 @@ def _gen_tests(ext, version, stage, path, extra_name, extra_extensions):
                            ('disabled-undefined', UNDEFINED_TEMPLATE)]:
         name = os.path.join(path, '{}-{}.{}'.format(test, extra_name, stage))
 
-        # Open in bytes mode to avoid weirdness in python 2/3 compatibility
-        with open(name, 'wb') as f:
-            f.write(template.render(
+        with utils.open_if_changed(name) as f:
+            f.write(template.render_unicode(
                 version=version,
                 extension=ext,
                 extra_extensions=extra_extensions))
@@ -79,7 +79,7 @@ def generate(type_name, mode, interface_block, struct, array, ver, names_only):
     print(filename)
 
     if not names_only:
-        with open(filename, 'w') as test_file:
+        with utils.open_if_changed(filename) as test_file:
             test_file.write(TEMPLATES.get_template(
                 'template.frag.mako').render_unicode(
                     ver=ver,
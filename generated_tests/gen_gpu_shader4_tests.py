@@ -276,7 +276,7 @@ def main():
             for stage in ['frag', 'vert']:
                 filename = '{0}.{1}'.format(name, stage)
                 print(filename)
-                with open(filename, 'w+') as f:
+                with utils.open_if_changed(filename) as f:
                     f.write(TEMPLATES.get_template(
                         '{0}.{1}.mako'.format('unary_op', stage)).render_unicode(
                             param=params,
@@ -296,7 +296,7 @@ def main():
             for stage in ['frag', 'vert']:
                 filename = '{0}.{1}'.format(name, stage)
                 print(filename)
-                with open(filename, 'w+') as f:
+                with utils.open_if_changed(filename) as f:
                     f.write(TEMPLATES.get_template(
                         '{0}.{1}.mako'.format('binary_op', stage)).render_unicode(
                             param=params,
@@ -320,7 +320,7 @@ def main():
                 for stage in ['frag', 'vert']:
                     filename = '{0}.{1}'.format(name, stage)
                     print(filename)
-                    with open(filename, 'w+') as f:
+                    with utils.open_if_changed(filename) as f:
                         f.write(TEMPLATES.get_template(
                             '{0}.{1}.mako'.format(tests[0], stage)).render_unicode(
                                 param=params,
@@ -362,7 +362,7 @@ def main():
                 for stage in stages:
                     filename = '{0}.{1}'.format(name, stage)
                     print(filename)
-                    with open(filename, 'w+') as f:
+                    with utils.open_if_changed(filename) as f:
                         f.write(TEMPLATES.get_template(
                             '{0}.{1}.mako'.format(tests[0], stage)).render_unicode(
                                 param=params,
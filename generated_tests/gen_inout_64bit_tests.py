@@ -32,6 +32,8 @@ import random_ubo
 from textwrap import dedent
 from mako.template import Template
 
+from modules import utils
+
 
 class VaryingType(object):
     __slots__ = ['type', 'members', 'name']
@@ -236,7 +238,7 @@ def do_test(root_types, explicit_locations, glsl_version, extensions,
 
     print(fullname)
 
-    shader_file = open(fullname, "w", buffering=1)
+    shader_file = utils.open_if_changed(fullname)
 
     names = random_ubo.unique_name_dict()
 
@@ -63,7 +63,7 @@ def generate_compilation_tests(type_name, shader, ver, names_only):
     print(filename)
 
     if not names_only:
-        with open(filename, 'w') as test_file:
+        with utils.open_if_changed(filename) as test_file:
             test_file.write(TEMPLATES.get_template(
                 'template.{0}.mako'.format(shader)).render_unicode(
                     glsl_version='{}.{}'.format(ver[0], ver[1:]),
@@ -783,7 +783,7 @@ def main():
             elif attrib['extensions'] is not None:
                 extension_list += attrib['extensions']
 
-            with open(filename, 'w') as f:
+            with utils.open_if_changed(filename) as f:
                 f.write(TEMPLATE.render_unicode(
                     execution_stage=execution_stage,
                     version=attrib['version'],
@@ -268,7 +268,7 @@ class Test(object):
         filename = self.filename()
         dirname = os.path.dirname(filename)
         utils.safe_makedirs(dirname)
-        with open(filename, 'w') as f:
+        with utils.open_if_changed(filename) as f:
             f.write(TEMPLATE.render_unicode(args=self))
 
 
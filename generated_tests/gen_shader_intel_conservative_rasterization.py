@@ -93,7 +93,7 @@ def gen(name, src, tests):
         dirname = os.path.dirname(filename)
         utils.safe_makedirs(dirname)
 
-        with open(filename, 'w') as f:
+        with utils.open_if_changed(filename) as f:
             f.write(template.render(header=gen_header, **t))
 
 
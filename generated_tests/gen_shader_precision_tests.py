@@ -55,6 +55,7 @@ import numpy
 import struct
 
 from templates import template_file
+from modules import utils
 
 
 
@@ -209,53 +210,62 @@ def drop_signbit(xs):
     return np.array([xs.dtype.type(0.0) if x == 0.0 else x for x in xs],
                     xs.dtype)
 
+
+def _generate(signature, test_vectors):
+    """Generate the tests of a signature, returning their filenames."""
+    filenames = []
+    arg_float_check = all(arg.base_type == glsl_float for arg in signature.argtypes)
+    arg_mat_check = any(arg.is_matrix for arg in signature.argtypes)
+    # Filter the test vectors down to only those which deal exclusively in
+    # non-matrix float types and are specified in the spec
+    if (signature.rettype.base_type == glsl_float and
+        arg_float_check and
+        signature.name in shader_precision_spec_fns and
+        not arg_mat_check):
+        # replace the tolerances in each test_vector with
+        # our own tolerances specified in ulps
+        refined_test_vectors = []
+        complex_tol_type = signature.rettype
+        for test_vector in test_vectors:
+            tolerance = _gen_tolerance(signature.name, signature.rettype, test_vector.arguments)
+            result = drop_signbit(test_vector.result)
+            refined_test_vectors.append(TestVector(test_vector.arguments, result, tolerance))
+        # Then generate the shader_test scripts
+        for shader_stage in ('vs', 'fs', 'gs'):
+            template = template_file('gen_shader_precision_tests', '{0}.mako'.format(shader_stage))
+            output_filename = os.path.join( 'spec', 'arb_shader_precision',
+                                            '{0}-{1}-{2}.shader_test'.format(
+                                            shader_stage, signature.name,
+                                            '-'.join(str(argtype)
+                                            for argtype in signature.argtypes)))
+            filenames.append(output_filename)
+            utils.safe_makedirs(os.path.dirname(output_filename))
+            indexers = make_indexers(signature)
+            num_elements = signature.rettype.num_cols * signature.rettype.num_rows
+            invocation = signature.template.format( *['arg{0}'.format(i)
+                                                    for i in range(len(signature.argtypes))])
+            with utils.open_if_changed(output_filename) as f:
+                f.write(template.render_unicode( signature=signature,
+                                                 is_complex_tolerance=_is_sequence(tolerance),
+                                                 complex_tol_type=signature.rettype,
+                                                 test_vectors=refined_test_vectors,
+                                                 invocation=invocation,
+                                                 num_elements=num_elements,
+                                                 indexers=indexers,
+                                                 shader_runner_type=shader_runner_type,
+                                                 shader_runner_format=shader_runner_format,
+                                                 column_major_values=column_major_values ))
+    return filenames
+
+
 def main():
     """ Main function """
 
-    for signature, test_vectors in test_suite.items():
-        arg_float_check = all(arg.base_type == glsl_float for arg in signature.argtypes)
-        arg_mat_check = any(arg.is_matrix for arg in signature.argtypes)
-        # Filter the test vectors down to only those which deal exclusively in
-        # non-matrix float types and are specified in the spec
-        if (signature.rettype.base_type == glsl_float and
-            arg_float_check and
-            signature.name in shader_precision_spec_fns and
-            not arg_mat_check):
-            # replace the tolerances in each test_vector with
-            # our own tolerances specified in ulps
-            refined_test_vectors = []
-            complex_tol_type = signature.rettype
-            for test_vector in test_vectors:
-                tolerance = _gen_tolerance(signature.name, signature.rettype, test_vector.arguments)
-                result = drop_signbit(test_vector.result)
-                refined_test_vectors.append(TestVector(test_vector.arguments, result, tolerance))
-            # Then generate the shader_test scripts
-            for shader_stage in ('vs', 'fs', 'gs'):
-                template = template_file('gen_shader_precision_tests', '{0}.mako'.format(shader_stage))
-                output_filename = os.path.join( 'spec', 'arb_shader_precision',
-                                                '{0}-{1}-{2}.shader_test'.format(
-                                                shader_stage, signature.name,
-                                                '-'.join(str(argtype)
-                                                for argtype in signature.argtypes)))
-                print(output_filename)
-                dirname = os.path.dirname(output_filename)
-                if not os.path.exists(dirname):
-                    os.makedirs(dirname)
-                indexers = make_indexers(signature)
-                num_elements = signature.rettype.num_cols * signature.rettype.num_rows
-                invocation = signature.template.format( *['arg{0}'.format(i)
-                                                        for i in range(len(signature.argtypes))])
-                with open(output_filename, 'w') as f:
-                    f.write(template.render_unicode( signature=signature,
-                                                     is_complex_tolerance=_is_sequence(tolerance),
-                                                     complex_tol_type=signature.rettype,
-                                                     test_vectors=refined_test_vectors,
-                                                     invocation=invocation,
-                                                     num_elements=num_elements,
-                                                     indexers=indexers,
-                                                     shader_runner_type=shader_runner_type,
-                                                     shader_runner_format=shader_runner_format,
-                                                     column_major_values=column_major_values ))
+    for filenames in utils.parallel_map(lambda t: _generate(*t),
+                                        test_suite.items()):
+        for filename in filenames:
+            print(filename)
+
 
 if __name__ == "__main__":
     main()
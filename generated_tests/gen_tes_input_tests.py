@@ -45,6 +45,8 @@ import sys
 import random
 import textwrap
 
+from modules import utils
+
 
 class Test(object):
     def __init__(self, type_name, array, patch_in, name):
@@ -307,7 +309,7 @@ class Test(object):
         dirname = os.path.dirname(filename)
         if not os.path.exists(dirname):
             os.makedirs(dirname)
-        with open(filename, 'w') as f:
+        with utils.open_if_changed(filename) as f:
             f.write(test)
 
 
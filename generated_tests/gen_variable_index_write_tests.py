@@ -232,7 +232,7 @@ def make_vs(name, params):
     """Create a vertex shader test."""
     dirname = _DIRNAME.format(params.formated_version)
     utils.safe_makedirs(dirname)
-    with open(os.path.join(dirname, name), 'w') as f:
+    with utils.open_if_changed(os.path.join(dirname, name)) as f:
         f.write(_VS_TEMPLATE.render_unicode(params=params))
     print(name)
 
@@ -241,7 +241,7 @@ def make_fs(name, params):
     """Create a fragment shader test."""
     dirname = _DIRNAME.format(params.formated_version)
     utils.safe_makedirs(dirname)
-    with open(os.path.join(dirname, name), 'w') as f:
+    with utils.open_if_changed(os.path.join(dirname, name)) as f:
         f.write(_FS_TEMPLATE.render_unicode(params=params))
     print(name)
 
@@ -459,7 +459,7 @@ class RegularTestTuple(TestTuple):
         filename += '.shader_test'
 
         if not self._names_only:
-            with open(filename, 'w') as test_file:
+            with utils.open_if_changed(filename) as test_file:
                 test_file.write(TEMPLATES.get_template(
                     'regular.shader_test.mako').render_unicode(
                         ver=self._ver,
@@ -514,7 +514,7 @@ class ColumnsTestTuple(TestTuple):
         filename += '.shader_test'
 
         if not self._names_only:
-            with open(filename, 'w') as test_file:
+            with utils.open_if_changed(filename) as test_file:
                 test_file.write(TEMPLATES.get_template(
                     'columns.shader_test.mako').render_unicode(
                         ver=self._ver,
@@ -77,7 +77,7 @@ def make_fs_vs_tests(fs_mode, vs_mode, dirname):
                 VS_TO_FS_VARIABLE_MAP[var]))
         print(filename)
 
-        with open(filename, 'w') as f:
+        with utils.open_if_changed(filename) as f:
             f.write(TEMPLATES.get_template('vs-fs.shader_test.mako').render_unicode(
                 vs_mode=vs_mode,
                 vs_variable=var,
@@ -97,7 +97,7 @@ def make_vs_unused_tests(vs_mode, dirname):
                 VS_TO_FS_VARIABLE_MAP[var]))
         print(filename)
 
-        with open(filename, 'w') as f:
+        with utils.open_if_changed(filename) as f:
             f.write(
                 TEMPLATES.get_template('vs-unused.shader_test.mako').render_unicode(
                     vs_mode=vs_mode,
@@ -116,7 +116,7 @@ def make_fs_unused_tests(fs_mode, vs_mode, dirname):
                 VS_TO_FS_VARIABLE_MAP[var]))
         print(filename)
 
-        with open(filename, 'w') as f:
+        with utils.open_if_changed(filename) as f:
             f.write(TEMPLATES.get_template('fs-unused.shader_test.mako').render_unicode(
                 vs_mode=vs_mode,
                 vs_variable=var,
@@ -136,7 +136,7 @@ def make_vs_fs_unused_tests(fs_mode, vs_mode, dirname):
                 VS_TO_FS_VARIABLE_MAP[var]))
         print(filename)
 
-        with open(filename, 'w') as f:
+        with utils.open_if_changed(filename) as f:
             f.write(TEMPLATES.get_template(
                 'fs-vs-unused.shader_test.mako').render_unicode(
                     vs_mode=vs_mode,
@@ -157,7 +157,7 @@ def make_vs_fs_flip_tests(fs_mode, vs_mode, dirname):
                 vs_mode, this_side, fs_mode, other_side))
         print(filename)
 
-        with open(filename, 'w') as f:
+        with utils.open_if_changed(filename) as f:
             f.write(TEMPLATES.get_template(
                 'vs-fs-flip.shader_test.mako').render_unicode(
                     vs_mode=vs_mode,
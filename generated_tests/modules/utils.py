@@ -24,6 +24,8 @@
 import os
 import errno
 import functools
+import io
+import multiprocessing
 
 
 def safe_makedirs(dirs):
@@ -65,3 +67,131 @@ class lazy_property(object):
         value = self.__func(obj)
         setattr(obj, self.__func.__name__, value)
         return value
+
+
+def write_if_changed(filename, content):
+    """Write content to filename unless the file already holds it.
+
+    Leaving unchanged files alone keeps their mtime, so the build steps
+    depending on them don't run again. The file is replaced atomically, so
+    a generator interrupted halfway never leaves a truncated test behind.
+
+    Returns True if the file was written.
+
+    """
+    try:
+        with open(filename, 'r') as f:
+            if f.read() == content:
+                return False
+    except (IOError, OSError, UnicodeDecodeError):
+        pass
+
+    tmp = '{}.{}.tmp'.format(filename, os.getpid())
+    with open(tmp, 'w') as f:
+        f.write(content)
+    os.replace(tmp, filename)
+    return True
+
+
+def frame_script(name, content):
+    """Return a shader_test script framed for shader_runner's stdin.
+
+    "shader_runner -" reads a stream of scripts, each of them preceded by a
+    line holding its size in bytes and its name, which is used to report its
+    result.
+
+    """
+    if '\n' in name:
+        raise ValueError('script names cannot hold newlines: {!r}'.format(name))
+    data = content.encode('utf-8')
+    return '{} {}\n'.format(len(data), name).encode('utf-8') + data
+
+
+_stream = None
+
+
+def stream_script(name, content):
+    """Append a shader_test script to the PIGLIT_GENERATOR_STREAM file.
+
+    The file, typically a pipe to "shader_runner -", is opened on first use.
+
+    """
+    global _stream
+
+    if _stream is None:
+        _stream = open(os.environ['PIGLIT_GENERATOR_STREAM'], 'ab')
+    _stream.write(frame_script(name, content))
+    _stream.flush()
+
+
+class open_if_changed(io.StringIO):
+    """A replacement for open(filename, 'w') using write_if_changed.
+
+    The content is buffered and handed to write_if_changed when the file is
+    closed, either explicitly or at the end of a with block. If the with
+    block raises, the buffer is discarded and the file is left alone.
+
+    When the PIGLIT_GENERATOR_STREAM environment variable names a file,
+    shader_test scripts are appended to it with stream_script instead of
+    being written to disk.
+
+    """
+    def __init__(self, filename):
+        super(open_if_changed, self).__init__()
+        self.name = filename
+
+    def close(self):
+        if not self.closed:
+            if (self.name.endswith('.shader_test') and
+                    os.environ.get('PIGLIT_GENERATOR_STREAM')):
+                stream_script(self.name, self.getvalue())
+            else:
+                write_if_changed(self.name, self.getvalue())
+        super(open_if_changed, self).close()
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        if exc_type is not None:
+            super(open_if_changed, self).close()
+        else:
+            self.close()
+        return False
+
+
+_shards = None
+
+
+def _run_shard(index):
+    func, items = _shards
+    return func(items[index])
+
+
+def parallel_map(func, items, jobs=None):
+    """Return [func(item) for item in items], computed by several processes.
+
+    The work is shared by forking a pool of processes, so neither func nor
+    the items need to be picklable, only the return values. The number of
+    processes comes from jobs or the PIGLIT_GENERATOR_JOBS environment
+    variable, which the build sets from the cmake option of the same name.
+    The build already runs several generators at once, so by default there
+    is a single job. Where fork isn't available, with a
+    single job, or when streaming scripts (see stream_script), everything
+    runs in this process.
+
+    """
+    global _shards
+
+    items = list(items)
+    if jobs is None:
+        jobs = int(os.environ.get('PIGLIT_GENERATOR_JOBS', 0) or 1)
+    if (jobs <= 1 or len(items) < 2 or
+            os.environ.get('PIGLIT_GENERATOR_STREAM') or
+            'fork' not in multiprocessing.get_all_start_methods()):
+        return [func(item) for item in items]
+
+    _shards = (func, items)
+    try:
+        with multiprocessing.get_context('fork').Pool(jobs) as pool:
+            return pool.map(_run_shard, range(len(items)),
+                            chunksize=max(1, len(items) // (jobs * 8)))
+    finally:
+        _shards = None
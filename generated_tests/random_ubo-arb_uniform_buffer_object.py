@@ -25,6 +25,8 @@ import os
 import errno
 import random_ubo
 
+from modules import utils
+
 def do_test(requirements, packing):
     path = os.path.join("spec", "arb_uniform_buffer_object", "execution")
 
@@ -40,7 +42,7 @@ def do_test(requirements, packing):
     basename = random_ubo.generate_file_name(requirements, packing)
     fullname = os.path.join(path, basename)
 
-    file = open(fullname, "w")
+    file = utils.open_if_changed(fullname)
 
     fields, required_layouts = random_ubo.generate_ubo(
         requirements,
@@ -0,0 +1,447 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "piglit-util-egl.h"
+#include "piglit-util-gl.h"
+
+/**
+ * @file egl-context-scaling.c
+ *
+ * Measure how GL throughput scales with the number of threads, each
+ * driving its own context on EGL_MESA_platform_surfaceless.
+ *
+ * For 1, 2, 4, ... threads, every thread makes its own configless
+ * context current without a surface and runs one workload against an
+ * FBO for the given duration:
+ *
+ *   draw    - one 8x8 textured quad per operation
+ *   upload  - one 256x256 RGBA8 glTexSubImage2D per operation
+ *   compile - compile and link one unique program per operation
+ *
+ * Contexts are either unshared or all share with one root context, which
+ * puts them behind the same shared-state locks in the driver. The
+ * aggregate rate is reported together with the scaling efficiency
+ * relative to a single thread, rate(N) / (N * rate(1)).
+ */
+
+static unsigned max_threads;
+static double duration = 1;
+static const char *selected_workload;
+static int selected_sharing = -1;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_es_version = 20;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-threads")) {
+			if (i == argc - 1) {
+				fprintf(stderr, "-threads requires an argument\n");
+				exit(1);
+			}
+
+			max_threads = strtoul(argv[i + 1], NULL, 10);
+			i++;
+		}
+		if (!strcmp(argv[i], "-duration")) {
+			if (i == argc - 1) {
+				fprintf(stderr, "-duration requires an argument\n");
+				exit(1);
+			}
+
+			duration = strtod(argv[i + 1], NULL);
+			printf("Duration forced to %.2f seconds\n", duration);
+			i++;
+		}
+		if (!strcmp(argv[i], "-workload")) {
+			if (i == argc - 1) {
+				fprintf(stderr, "-workload requires an argument\n");
+				exit(1);
+			}
+
+			selected_workload = argv[i + 1];
+			i++;
+		}
+		if (!strcmp(argv[i], "-shared"))
+			selected_sharing = 1;
+		if (!strcmp(argv[i], "-unshared"))
+			selected_sharing = 0;
+		if (!strcmp(argv[i], "-help")) {
+			fprintf(stderr, "egl-context-scaling [-threads MAX] "
+				"[-duration SECS] "
+				"[-workload draw|upload|compile] "
+				"[-shared|-unshared]\n");
+			exit(1);
+		}
+	}
+
+PIGLIT_GL_TEST_CONFIG_END
+
+#define FB_SIZE 256
+
+struct worker;
+
+typedef void (*workload_setup_func)(struct worker *w);
+typedef void (*workload_op_func)(struct worker *w);
+
+struct workload {
+	const char *name;
+	workload_setup_func setup;
+	workload_op_func op;
+};
+
+struct worker {
+	pthread_t thread;
+	unsigned index;
+	EGLContext ctx;
+	const struct workload *workload;
+
+	GLuint fbo;
+	GLuint fb_tex;
+	GLuint tex;
+	GLuint prog;
+	void *data;
+
+	uint64_t ops;
+	bool failed;
+};
+
+static EGLDisplay dpy;
+static pthread_barrier_t ready_barrier;
+static pthread_barrier_t start_barrier;
+static int64_t deadline;
+static unsigned run_count;
+static char nonce[64];
+
+/* dummy */
+enum piglit_result
+piglit_display(void)
+{
+	return PIGLIT_FAIL;
+}
+
+static const char *vs_src =
+	"attribute vec4 piglit_vertex;\n"
+	"varying vec2 tc;\n"
+	"void main() {\n"
+	"	gl_Position = piglit_vertex;\n"
+	"	tc = piglit_vertex.xy * 0.5 + 0.5;\n"
+	"}\n";
+
+static const char *fs_src =
+	"precision mediump float;\n"
+	"uniform sampler2D tex;\n"
+	"varying vec2 tc;\n"
+	"void main() {\n"
+	"	gl_FragColor = texture2D(tex, tc);\n"
+	"}\n";
+
+static GLuint
+create_texture(void)
+{
+	GLuint tex;
+
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, FB_SIZE, FB_SIZE, 0,
+		     GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	return tex;
+}
+
+static void
+draw_setup(struct worker *w)
+{
+	static const float verts[4][2] = {
+		{ -1, -1 }, { 1, -1 }, { -1, 1 }, { 1, 1 },
+	};
+
+	w->prog = piglit_build_simple_program(vs_src, fs_src);
+	glUseProgram(w->prog);
+	glBindTexture(GL_TEXTURE_2D, w->tex);
+
+	/* Set the quad up once rather than going through
+	 * piglit_draw_rect, to keep per-draw overhead to the driver.
+	 */
+	glVertexAttribPointer(PIGLIT_ATTRIB_POS, 2, GL_FLOAT, GL_FALSE, 0,
+			      verts);
+	glEnableVertexAttribArray(PIGLIT_ATTRIB_POS);
+
+	/* Keep the fill cost per draw small, this is about the CPU side. */
+	glViewport(0, 0, 8, 8);
+}
+
+static void
+draw_op(struct worker *w)
+{
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
+static void
+upload_setup(struct worker *w)
+{
+	w->data = calloc(FB_SIZE * FB_SIZE, 4);
+	glBindTexture(GL_TEXTURE_2D, w->tex);
+}
+
+static void
+upload_op(struct worker *w)
+{
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, FB_SIZE, FB_SIZE,
+			GL_RGBA, GL_UNSIGNED_BYTE, w->data);
+}
+
+static void
+compile_setup(struct worker *w)
+{
+}
+
+static void
+compile_op(struct worker *w)
+{
+	char fs[320];
+	GLuint prog;
+
+	/* Make every source unique across threads, runs and invocations,
+	 * so that neither the in-memory nor the on-disk shader cache can
+	 * help.
+	 */
+	snprintf(fs, sizeof(fs),
+		 "#define NONCE_%s_%u_%u_%" PRIu64 "\n"
+		 "precision mediump float;\n"
+		 "void main() {\n"
+		 "	gl_FragColor = vec4(%u.0, %u.0, 0.0, 1.0) / 65536.0;\n"
+		 "}\n",
+		 nonce, run_count, w->index, w->ops,
+		 w->index, (unsigned)(w->ops % 65536));
+
+	prog = piglit_build_simple_program_unlinked(vs_src, fs);
+	glLinkProgram(prog);
+	if (!piglit_link_check_status(prog))
+		w->failed = true;
+	glDeleteProgram(prog);
+}
+
+static const struct workload workloads[] = {
+	{ "draw", draw_setup, draw_op },
+	{ "upload", upload_setup, upload_op },
+	{ "compile", compile_setup, compile_op },
+};
+
+static void *
+worker_main(void *arg)
+{
+	struct worker *w = arg;
+
+	if (!eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, w->ctx)) {
+		fprintf(stderr, "thread %u: eglMakeCurrent failed\n", w->index);
+		w->failed = true;
+	} else {
+		w->fb_tex = create_texture();
+		w->tex = create_texture();
+
+		glGenFramebuffers(1, &w->fbo);
+		glBindFramebuffer(GL_FRAMEBUFFER, w->fbo);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+				       GL_TEXTURE_2D, w->fb_tex, 0);
+		glViewport(0, 0, FB_SIZE, FB_SIZE);
+
+		w->workload->setup(w);
+
+		/* Do one operation outside of the measurement, so that
+		 * first-use costs are not counted.
+		 */
+		w->workload->op(w);
+		glFinish();
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) !=
+		    GL_FRAMEBUFFER_COMPLETE ||
+		    glGetError() != GL_NO_ERROR)
+			w->failed = true;
+	}
+
+	pthread_barrier_wait(&ready_barrier);
+	pthread_barrier_wait(&start_barrier);
+
+	if (!w->failed) {
+		while (piglit_time_get_nano() < deadline) {
+			w->workload->op(w);
+			w->ops++;
+		}
+		glFinish();
+
+		glDeleteProgram(w->prog);
+		glDeleteTextures(1, &w->tex);
+		glDeleteTextures(1, &w->fb_tex);
+		glDeleteFramebuffers(1, &w->fbo);
+		free(w->data);
+	}
+
+	eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	return NULL;
+}
+
+/**
+ * Run one workload on \p num_threads threads and return the aggregate
+ * number of operations per second, or -1 on failure.
+ */
+static double
+run(const struct workload *workload, unsigned num_threads,
+    EGLContext share_ctx)
+{
+	static const EGLint ctx_attr[] = {
+		EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE
+	};
+	struct worker *workers = calloc(num_threads, sizeof(*workers));
+	bool failed = false;
+	uint64_t ops = 0;
+
+	run_count++;
+	pthread_barrier_init(&ready_barrier, NULL, num_threads + 1);
+	pthread_barrier_init(&start_barrier, NULL, num_threads + 1);
+
+	for (unsigned i = 0; i < num_threads; i++) {
+		struct worker *w = &workers[i];
+
+		w->index = i;
+		w->workload = workload;
+		w->ctx = eglCreateContext(dpy, EGL_NO_CONFIG_KHR, share_ctx,
+					  ctx_attr);
+		if (w->ctx == EGL_NO_CONTEXT) {
+			fprintf(stderr, "could not create EGL context\n");
+			piglit_report_result(PIGLIT_FAIL);
+		}
+
+		if (pthread_create(&w->thread, NULL, worker_main, w)) {
+			fprintf(stderr, "failed to create thread %u\n", i);
+			piglit_report_result(PIGLIT_FAIL);
+		}
+	}
+
+	/* Start every thread at once, after all of them are set up. */
+	pthread_barrier_wait(&ready_barrier);
+	int64_t start = piglit_time_get_nano();
+	deadline = start + (int64_t)(duration * 1e9);
+	pthread_barrier_wait(&start_barrier);
+
+	for (unsigned i = 0; i < num_threads; i++) {
+		pthread_join(workers[i].thread, NULL);
+		eglDestroyContext(dpy, workers[i].ctx);
+		ops += workers[i].ops;
+		failed |= workers[i].failed;
+	}
+
+	double secs = (piglit_time_get_nano() - start) / 1e9;
+
+	pthread_barrier_destroy(&ready_barrier);
+	pthread_barrier_destroy(&start_barrier);
+	free(workers);
+
+	return failed ? -1 : ops / secs;
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	static const EGLint ctx_attr[] = {
+		EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE
+	};
+	EGLint major, minor;
+	EGLContext root_ctx;
+
+	/* Require EGL_MESA_platform_surfaceless extension. */
+	const char *exts = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	if (!strstr(exts, "EGL_MESA_platform_surfaceless"))
+		piglit_report_result(PIGLIT_SKIP);
+
+	dpy = piglit_egl_get_default_display(EGL_PLATFORM_SURFACELESS_MESA);
+
+	if (!eglInitialize(dpy, &major, &minor))
+		piglit_report_result(PIGLIT_FAIL);
+
+	piglit_require_egl_extension(dpy, "EGL_MESA_configless_context");
+	piglit_require_egl_extension(dpy, "EGL_KHR_surfaceless_context");
+
+	if (!eglBindAPI(EGL_OPENGL_ES_API))
+		piglit_report_result(PIGLIT_FAIL);
+
+	root_ctx = eglCreateContext(dpy, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT,
+				    ctx_attr);
+	if (root_ctx == EGL_NO_CONTEXT) {
+		fprintf(stderr, "could not create EGL context\n");
+		piglit_report_result(PIGLIT_FAIL);
+	}
+
+	snprintf(nonce, sizeof(nonce), "%ld_%" PRId64,
+		 (long)getpid(), piglit_time_get_nano());
+
+	if (!max_threads) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		max_threads = cpus > 0 ? MIN2(cpus, 16) : 4;
+	}
+
+	puts("Workload, Contexts, Threads,       ops/s, ops/s/thread, efficiency");
+
+	for (unsigned i = 0; i < ARRAY_SIZE(workloads); i++) {
+		const struct workload *workload = &workloads[i];
+
+		if (selected_workload &&
+		    strcmp(selected_workload, workload->name) != 0)
+			continue;
+
+		for (int shared = 0; shared < 2; shared++) {
+			double base = 0;
+
+			if (selected_sharing != -1 && selected_sharing != shared)
+				continue;
+
+			for (unsigned n = 1; n <= max_threads; n *= 2) {
+				double rate = run(workload, n, shared ?
+						  root_ctx : EGL_NO_CONTEXT);
+
+				if (rate < 0) {
+					fprintf(stderr, "%s failed with %u threads\n",
+						workload->name, n);
+					piglit_report_result(PIGLIT_FAIL);
+				}
+
+				if (n == 1)
+					base = rate;
+
+				printf("%-8s, %-8s, %7u, %11.1f, %12.1f, %9.1f%%\n",
+				       workload->name,
+				       shared ? "shared" : "unshared", n,
+				       rate, rate / n,
+				       100.0 * rate / (n * base));
+			}
+		}
+	}
+
+	eglDestroyContext(dpy, root_ctx);
+	eglTerminate(dpy);
+
+	exit(0);
+}
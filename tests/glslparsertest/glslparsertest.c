@@ -34,6 +34,7 @@
 #include <errno.h>
 
 #include "piglit-util-gl.h"
+#include "piglit-blob-cache.h"
 
 #define COMPAT_FLAG (1u << 31)
 
@@ -265,6 +266,7 @@ test(void)
 	GLint size;
 	GLenum type;
 	char *failing_stage = NULL;
+	int64_t start;
 
 	if (strcmp(filename + strlen(filename) - 4, "frag") == 0)
 		type = GL_FRAGMENT_SHADER;
@@ -309,6 +311,7 @@ test(void)
 				 -1, "");
 	}
 
+	start = piglit_time_get_nano();
 	prog = glCreateShader(type);
 	glShaderSource(prog, 1, (const GLchar **)&prog_string, NULL);
 
@@ -367,6 +370,7 @@ test(void)
 		}
 		glDeleteProgram(shader_prog);
 	}
+	piglit_blob_cache_add_compile_time(piglit_time_get_nano() - start);
 
 	pass = (expected_pass == ok);
 
@@ -564,6 +568,7 @@ piglit_init(int argc, char**argv)
 		}
 	}
 
+	piglit_blob_cache_init(filename);
 	test();
 }
 
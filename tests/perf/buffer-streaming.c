@@ -0,0 +1,399 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Measure buffer streaming strategies.
+ *
+ * Every iteration writes a block of vertex data into a buffer object and
+ * draws one tiny triangle out of it, so the data must actually reach the
+ * GPU. This compares glBufferSubData, glMapBufferRange with
+ * INVALIDATE/UNSYNCHRONIZED, orphaning, and persistent mappings used as a
+ * fenced ring buffer, for several update sizes. The sustained upload rate
+ * is reported in MB/s along with the number of draws per second.
+ */
+
+#include "common.h"
+#include <stdbool.h>
+#include "piglit-util-gl.h"
+
+static bool color = true;
+static int selected_test_index = -1;
+static double duration = 0.5;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_core_version = 32;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-nocolor")) {
+			color = false;
+		}
+		if (!strcmp(argv[i], "-test")) {
+			if (i == argc - 1) {
+				fprintf(stderr, "-test requires an argument\n");
+				exit(1);
+			}
+
+			const char *testnum = argv[i + 1];
+			char *endptr;
+			selected_test_index = strtol(testnum, &endptr, 10);
+
+			if (endptr != argv[i + 1] + strlen(testnum)) {
+				fprintf(stderr,
+					"Failed to parse test number '%s'\n", testnum);
+				exit(1);
+			}
+
+			printf("Running only test %d\n", selected_test_index);
+			i++;
+		}
+		if (!strcmp(argv[i], "-duration")) {
+			if (i == argc - 1) {
+				fprintf(stderr, "-duration requires an argument\n");
+				exit(1);
+			}
+
+			duration = strtod(argv[i + 1], NULL);
+			printf("Duration forced to %.2f seconds\n", duration);
+			i++;
+		}
+
+		if (!strcmp(argv[i], "-help")) {
+			fprintf(stderr, "buffer-streaming [-test TESTNUM] "
+				"[-duration SECS] [-nocolor]\n");
+			exit(1);
+		}
+	}
+
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+PIGLIT_GL_TEST_CONFIG_END
+
+/* One vertex is a vec4. */
+#define VERTEX_SIZE 16
+
+/* The ring is split in segments which are fenced when the ring moves
+ * past them. The largest update must fit in a segment. */
+#define RING_SIZE (16 * 1024 * 1024)
+#define NUM_SEGMENTS 4
+#define SEGMENT_SIZE (RING_SIZE / NUM_SEGMENTS)
+
+#define MAX_UPDATE_SIZE (1024 * 1024)
+
+/* Small vertex coordinate to generate as small a triangle as possible
+ * for the lowest GPU overhead.
+ */
+#define V1 0.00001
+
+static GLuint vbo, orphan_vbo, ring_vbo, coherent_vbo, flushed_vbo;
+static uint8_t *coherent_map, *flushed_map;
+static float *vertices;
+static unsigned update_size;
+
+static GLsync segment_fence[NUM_SEGMENTS];
+static unsigned ring_segment, ring_offset;
+
+#define COLOR_RESET	"\033[0m"
+#define COLOR_RED	"\033[31m"
+#define COLOR_GREEN	"\033[1;32m"
+#define COLOR_YELLOW	"\033[1;33m"
+#define COLOR_CYAN	"\033[1;36m"
+
+static void
+bind_vertex_buffer(GLuint buf)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, buf);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, NULL);
+}
+
+static void
+draw_from(unsigned offset)
+{
+	glDrawArrays(GL_TRIANGLES, offset / VERTEX_SIZE, 3);
+}
+
+/**
+ * Allocate update_size bytes in the ring.
+ *
+ * When the current segment is full, it is fenced and the ring moves to
+ * the next one, waiting for its fence first, so the CPU never overwrites
+ * data the GPU hasn't consumed yet. The segment is tracked separately
+ * from the offset, so that a segment filled exactly is also fenced.
+ */
+static unsigned
+ring_alloc(void)
+{
+	if (ring_offset + update_size > (ring_segment + 1) * SEGMENT_SIZE) {
+		segment_fence[ring_segment] =
+			glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		ring_segment = (ring_segment + 1) % NUM_SEGMENTS;
+		if (segment_fence[ring_segment]) {
+			glClientWaitSync(segment_fence[ring_segment],
+					 GL_SYNC_FLUSH_COMMANDS_BIT,
+					 GL_TIMEOUT_IGNORED);
+			glDeleteSync(segment_fence[ring_segment]);
+			segment_fence[ring_segment] = NULL;
+		}
+		ring_offset = ring_segment * SEGMENT_SIZE;
+	}
+
+	unsigned offset = ring_offset;
+	ring_offset += update_size;
+	assert(offset + update_size <= RING_SIZE);
+	return offset;
+}
+
+static void
+ring_reset(void)
+{
+	for (unsigned i = 0; i < NUM_SEGMENTS; i++) {
+		if (segment_fence[i]) {
+			glDeleteSync(segment_fence[i]);
+			segment_fence[i] = NULL;
+		}
+	}
+	ring_segment = 0;
+	ring_offset = 0;
+}
+
+static void
+stream_subdata(unsigned count)
+{
+	bind_vertex_buffer(vbo);
+	for (unsigned i = 0; i < count; i++) {
+		glBufferSubData(GL_ARRAY_BUFFER, 0, update_size, vertices);
+		draw_from(0);
+	}
+}
+
+static void
+stream_orphan(unsigned count)
+{
+	bind_vertex_buffer(orphan_vbo);
+	for (unsigned i = 0; i < count; i++) {
+		glBufferData(GL_ARRAY_BUFFER, update_size, NULL,
+			     GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, update_size, vertices);
+		draw_from(0);
+	}
+}
+
+static void
+stream_map(unsigned count, GLbitfield access)
+{
+	bind_vertex_buffer(vbo);
+	for (unsigned i = 0; i < count; i++) {
+		void *map = glMapBufferRange(GL_ARRAY_BUFFER, 0, update_size,
+					     GL_MAP_WRITE_BIT | access);
+		memcpy(map, vertices, update_size);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		draw_from(0);
+	}
+}
+
+static void
+stream_map_invalidate_range(unsigned count)
+{
+	stream_map(count, GL_MAP_INVALIDATE_RANGE_BIT);
+}
+
+static void
+stream_map_invalidate_buffer(unsigned count)
+{
+	stream_map(count, GL_MAP_INVALIDATE_BUFFER_BIT);
+}
+
+static void
+stream_map_unsynchronized(unsigned count)
+{
+	bind_vertex_buffer(ring_vbo);
+	for (unsigned i = 0; i < count; i++) {
+		unsigned offset = ring_alloc();
+		void *map = glMapBufferRange(GL_ARRAY_BUFFER, offset,
+					     update_size,
+					     GL_MAP_WRITE_BIT |
+					     GL_MAP_INVALIDATE_RANGE_BIT |
+					     GL_MAP_UNSYNCHRONIZED_BIT);
+		memcpy(map, vertices, update_size);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		draw_from(offset);
+	}
+}
+
+static void
+stream_persistent_coherent(unsigned count)
+{
+	bind_vertex_buffer(coherent_vbo);
+	for (unsigned i = 0; i < count; i++) {
+		unsigned offset = ring_alloc();
+		memcpy(coherent_map + offset, vertices, update_size);
+		draw_from(offset);
+	}
+}
+
+static void
+stream_persistent_flushed(unsigned count)
+{
+	bind_vertex_buffer(flushed_vbo);
+	for (unsigned i = 0; i < count; i++) {
+		unsigned offset = ring_alloc();
+		memcpy(flushed_map + offset, vertices, update_size);
+		glFlushMappedBufferRange(GL_ARRAY_BUFFER, offset, update_size);
+		draw_from(offset);
+	}
+}
+
+static double
+perf_run(const char *name, perf_rate_func f, double base_rate)
+{
+	static unsigned test_index;
+	test_index++;
+
+	if (selected_test_index != -1 && test_index != selected_test_index)
+		return 0;
+
+	ring_reset();
+
+	double rate = perf_measure_cpu_rate(f, duration);
+	double ratio = base_rate ? rate / base_rate : 1;
+
+	const char *ratio_color = base_rate == 0 ? COLOR_RESET :
+		ratio > 0.7 ? COLOR_GREEN :
+		ratio > 0.4 ? COLOR_YELLOW : COLOR_RED;
+
+	printf(" %3u, %-44s %7u, %s%9.1f%s, %9u, %s%.1f%%%s\n",
+	       test_index, name, update_size,
+	       color ? COLOR_CYAN : "",
+	       rate * update_size / 1000000.0,
+	       color ? COLOR_RESET : "",
+	       (unsigned)rate,
+	       color ? ratio_color : "",
+	       100 * ratio,
+	       color ? COLOR_RESET : "");
+
+	if (!piglit_check_gl_error(GL_NO_ERROR))
+		piglit_report_result(PIGLIT_FAIL);
+	return rate;
+}
+
+static void *
+create_persistent_ring(GLuint *buf, GLbitfield flags)
+{
+	glGenBuffers(1, buf);
+	glBindBuffer(GL_ARRAY_BUFFER, *buf);
+	glBufferStorage(GL_ARRAY_BUFFER, RING_SIZE, NULL,
+			GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | flags);
+	return glMapBufferRange(GL_ARRAY_BUFFER, 0, RING_SIZE,
+				GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+				(flags & GL_MAP_COHERENT_BIT ?
+				 GL_MAP_COHERENT_BIT : GL_MAP_FLUSH_EXPLICIT_BIT));
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	static const unsigned sizes[] = {256, 4096, 65536, MAX_UPDATE_SIZE};
+	bool has_persistent;
+	GLuint vao, prog;
+
+	piglit_require_gl_version(32);
+	has_persistent = piglit_is_extension_supported("GL_ARB_buffer_storage");
+
+	prog = piglit_build_simple_program(
+		"#version 150\n"
+		"in vec4 v;\n"
+		"void main() {\n"
+		"	gl_Position = v;\n"
+		"}\n",
+		"#version 150\n"
+		"out vec4 c;\n"
+		"void main() {\n"
+		"	c = vec4(1.0);\n"
+		"}\n");
+	glBindAttribLocation(prog, 0, "v");
+	glLinkProgram(prog);
+	glUseProgram(prog);
+
+	/* Fill the source with tiny triangles. */
+	vertices = malloc(MAX_UPDATE_SIZE);
+	for (unsigned i = 0; i < MAX_UPDATE_SIZE / VERTEX_SIZE; i++) {
+		float *v = &vertices[i * 4];
+
+		v[0] = i % 3 == 2 ? V1 : 0;
+		v[1] = i % 3 == 1 ? V1 : 0;
+		v[2] = 0;
+		v[3] = 1;
+	}
+
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glEnableVertexAttribArray(0);
+
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, MAX_UPDATE_SIZE, NULL, GL_STREAM_DRAW);
+
+	/* Orphaning reallocates the buffer at the update size. */
+	glGenBuffers(1, &orphan_vbo);
+
+	glGenBuffers(1, &ring_vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, ring_vbo);
+	glBufferData(GL_ARRAY_BUFFER, RING_SIZE, NULL, GL_STREAM_DRAW);
+
+	if (has_persistent) {
+		coherent_map = create_persistent_ring(&coherent_vbo,
+						      GL_MAP_COHERENT_BIT);
+		flushed_map = create_persistent_ring(&flushed_vbo, 0);
+	}
+
+	puts("   #, Strategy,                                    Bytes/draw,      MB/s,   draws/s, vs BufferSubData");
+
+	for (unsigned i = 0; i < ARRAY_SIZE(sizes); i++) {
+		double base_rate;
+
+		update_size = sizes[i];
+
+		base_rate = perf_run("BufferSubData", stream_subdata, 0);
+		perf_run("BufferData(NULL) orphan + BufferSubData",
+			 stream_orphan, base_rate);
+		perf_run("MapBufferRange INVALIDATE_RANGE",
+			 stream_map_invalidate_range, base_rate);
+		perf_run("MapBufferRange INVALIDATE_BUFFER",
+			 stream_map_invalidate_buffer, base_rate);
+		perf_run("MapBufferRange UNSYNCHRONIZED ring + fences",
+			 stream_map_unsynchronized, base_rate);
+		if (has_persistent) {
+			perf_run("Persistent COHERENT ring + fences",
+				 stream_persistent_coherent, base_rate);
+			perf_run("Persistent FlushMappedBufferRange ring",
+				 stream_persistent_flushed, base_rate);
+		}
+	}
+
+	exit(0);
+}
+
+/** Called from test harness/main */
+enum piglit_result
+piglit_display(void)
+{
+	return PIGLIT_FAIL;
+}
@@ -22,6 +22,10 @@
 #ifndef COMMON_H
 #define COMMON_H
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef void (*perf_rate_func)(unsigned count);
 
 double
@@ -30,5 +34,9 @@ perf_measure_cpu_rate(perf_rate_func f, double minDuration);
 double
 perf_measure_gpu_rate(perf_rate_func f, double minDuration);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* COMMON_H */
 
@@ -0,0 +1,471 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Measure compute dispatch overhead and throughput.
+ *
+ * Like drawoverhead, the CPU cost of glDispatchCompute and
+ * glDispatchComputeIndirect is measured with nothing changing between
+ * dispatches, and then with SSBO, UBO and image rebinding, memory barriers
+ * and program changes in between. After that, the GPU throughput of a
+ * large dispatch is measured for several workgroup sizes.
+ */
+
+#include "common.h"
+#include "../spec/arb_compute_shader/common.h"
+#include <stdbool.h>
+#include "piglit-util-gl.h"
+
+static bool color = true;
+static int selected_test_index = -1;
+static double duration = 1;
+static unsigned test_index;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_core_version = 32;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-nocolor")) {
+			color = false;
+		}
+		if (!strcmp(argv[i], "-test")) {
+			if (i == argc - 1) {
+				fprintf(stderr, "-test requires an argument\n");
+				exit(1);
+			}
+
+			const char *testnum = argv[i + 1];
+			char *endptr;
+			selected_test_index = strtol(testnum, &endptr, 10);
+
+			if (endptr != argv[i + 1] + strlen(testnum)) {
+				fprintf(stderr,
+					"Failed to parse test number '%s'\n", testnum);
+				exit(1);
+			}
+
+			printf("Running only test %d\n", selected_test_index);
+			i++;
+		}
+		if (!strcmp(argv[i], "-duration")) {
+			if (i == argc - 1) {
+				fprintf(stderr, "-duration requires an argument\n");
+				exit(1);
+			}
+
+			duration = strtod(argv[i + 1], NULL);
+			printf("Duration forced to %.2f seconds\n", duration);
+			i++;
+		}
+
+		if (!strcmp(argv[i], "-help")) {
+			fprintf(stderr, "computeoverhead [-test TESTNUM] "
+				"[-duration SECS] [-nocolor]\n");
+			exit(1);
+		}
+	}
+
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+PIGLIT_GL_TEST_CONFIG_END
+
+#define MAX_BINDINGS 8
+
+/* Invocations of one dispatch in the throughput tests. */
+#define THROUGHPUT_INVOCATIONS (1024 * 1024)
+
+static GLuint prog[2], ssbo[MAX_BINDINGS * 2], ubo[MAX_BINDINGS * 2];
+static GLuint img[MAX_BINDINGS * 2], indirect_buf, throughput_buf;
+static unsigned num_ssbos, num_ubos, num_images;
+static unsigned num_groups;
+static bool indirect;
+static GLbitfield barrier_bits;
+
+#define COLOR_RESET	"\033[0m"
+#define COLOR_RED	"\033[31m"
+#define COLOR_GREEN	"\033[1;32m"
+#define COLOR_YELLOW	"\033[1;33m"
+#define COLOR_CYAN	"\033[1;36m"
+
+static GLuint
+build_overhead_prog(bool is_second)
+{
+	char *decls = hunk("");
+	char *body = hunk("void main() {\n"
+			  "	uint v = 0u;\n");
+	unsigned i;
+
+	/* SSBO 0 is always there, it receives the result. */
+	for (i = 0; i < MAX2(num_ssbos, 1); i++) {
+		char *s;
+		(void)!asprintf(&s, "layout(std430, binding = %u) buffer "
+				"ssbo%u { uint s%u[]; };", i, i, i);
+		decls = concat(decls, s, NULL);
+		(void)!asprintf(&s, "	v += s%u[0];", i);
+		body = concat(body, s, NULL);
+	}
+	for (i = 0; i < num_ubos; i++) {
+		char *s;
+		(void)!asprintf(&s, "layout(std140, binding = %u) uniform "
+				"ubo%u { uvec4 u%u; };", i, i, i);
+		decls = concat(decls, s, NULL);
+		(void)!asprintf(&s, "	v += u%u.x;", i);
+		body = concat(body, s, NULL);
+	}
+	for (i = 0; i < num_images; i++) {
+		char *s;
+		(void)!asprintf(&s, "layout(r32ui, binding = %u) readonly "
+				"uniform uimage2D i%u;", i, i);
+		decls = concat(decls, s, NULL);
+		(void)!asprintf(&s, "	v += imageLoad(i%u, ivec2(0)).x;", i);
+		body = concat(body, s, NULL);
+	}
+
+	body = concat(body,
+		      hunk(is_second ? "	s0[1] = v + 1u;\n}\n" :
+				       "	s0[1] = v;\n}\n"),
+		      NULL);
+
+	GLuint p = generate_cs_prog(1, 1, 1,
+				    hunk("#extension GL_ARB_shader_storage_buffer_object : require\n"
+					 "#extension GL_ARB_shading_language_420pack : require\n"
+					 "#extension GL_ARB_shader_image_load_store : require\n"),
+				    concat(decls, body, NULL));
+	if (!p)
+		piglit_report_result(PIGLIT_FAIL);
+	return p;
+}
+
+static void
+setup_shaders_and_resources(void)
+{
+	unsigned i;
+
+	for (i = 0; i < 2; i++) {
+		if (prog[i])
+			glDeleteProgram(prog[i]);
+		prog[i] = build_overhead_prog(i == 1);
+	}
+	glUseProgram(prog[0]);
+
+	for (i = 0; i < MAX_BINDINGS; i++) {
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, ssbo[i]);
+		glBindBufferBase(GL_UNIFORM_BUFFER, i, ubo[i]);
+		glBindImageTexture(i, img[i], 0, GL_FALSE, 0, GL_READ_ONLY,
+				   GL_R32UI);
+	}
+}
+
+static void
+dispatch(void)
+{
+	if (indirect)
+		glDispatchComputeIndirect(0);
+	else
+		glDispatchCompute(1, 1, 1);
+}
+
+static void
+dispatch_no_change(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++)
+		dispatch();
+}
+
+static void
+dispatch_one_ssbo_change(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0,
+				 ssbo[(i & 1) * MAX_BINDINGS]);
+		dispatch();
+	}
+}
+
+static void
+dispatch_many_ssbo_change(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		for (unsigned j = 0; j < num_ssbos; j++) {
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, j,
+					 ssbo[(i & 1) * MAX_BINDINGS + j]);
+		}
+		dispatch();
+	}
+}
+
+static void
+dispatch_one_ubo_change(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		glBindBufferBase(GL_UNIFORM_BUFFER, 0,
+				 ubo[(i & 1) * MAX_BINDINGS]);
+		dispatch();
+	}
+}
+
+static void
+dispatch_many_ubo_change(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		for (unsigned j = 0; j < num_ubos; j++) {
+			glBindBufferBase(GL_UNIFORM_BUFFER, j,
+					 ubo[(i & 1) * MAX_BINDINGS + j]);
+		}
+		dispatch();
+	}
+}
+
+static void
+dispatch_one_img_change(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		glBindImageTexture(0, img[(i & 1) * MAX_BINDINGS], 0, GL_FALSE,
+				   0, GL_READ_ONLY, GL_R32UI);
+		dispatch();
+	}
+}
+
+static void
+dispatch_many_img_change(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		for (unsigned j = 0; j < num_images; j++) {
+			glBindImageTexture(j, img[(i & 1) * MAX_BINDINGS + j],
+					   0, GL_FALSE, 0, GL_READ_ONLY,
+					   GL_R32UI);
+		}
+		dispatch();
+	}
+}
+
+static void
+dispatch_barrier(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		glMemoryBarrier(barrier_bits);
+		dispatch();
+	}
+}
+
+static void
+dispatch_shader_change(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		glUseProgram(prog[i & 1]);
+		dispatch();
+	}
+}
+
+static void
+dispatch_throughput(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++)
+		glDispatchCompute(num_groups, 1, 1);
+}
+
+static double
+perf_run(const char *call, const char *change, perf_rate_func f,
+	 double base_rate)
+{
+	test_index++;
+
+	if (selected_test_index != -1 && test_index != selected_test_index)
+		return 0;
+
+	setup_shaders_and_resources();
+
+	double rate = perf_measure_cpu_rate(f, duration);
+	double ratio = base_rate ? rate / base_rate : 1;
+
+	const char *ratio_color = base_rate == 0 ? COLOR_RESET :
+		ratio > 0.7 ? COLOR_GREEN :
+		ratio > 0.4 ? COLOR_YELLOW : COLOR_RED;
+
+	printf(" %3u, %-23s (%u SSBO| %u UBO| %u Img) w/ %-24s %s%5u%s, %s%.1f%%%s\n",
+	       test_index, call, MAX2(num_ssbos, 1), num_ubos, num_images,
+	       change,
+	       color ? COLOR_CYAN : "",
+	       (unsigned)(rate / 1000),
+	       color ? COLOR_RESET : "",
+	       color ? ratio_color : "",
+	       100 * ratio,
+	       color ? COLOR_RESET : "");
+	return rate;
+}
+
+static void
+perf_throughput(unsigned local_size)
+{
+	GLint max_invocations, max_size[3];
+
+	test_index++;
+	if (selected_test_index != -1 && test_index != selected_test_index)
+		return;
+
+	glGetIntegerv(GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS, &max_invocations);
+	glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_SIZE, 0, &max_size[0]);
+	if (local_size > max_invocations || local_size > max_size[0])
+		return;
+
+	GLuint p = generate_cs_prog(local_size, 1, 1,
+				    hunk("#extension GL_ARB_shader_storage_buffer_object : require\n"),
+				    hunk("layout(std430) buffer ssbo { uint s[]; };\n"
+					 "void main() {\n"
+					 "	uint id = gl_GlobalInvocationID.x;\n"
+					 "	s[id] = id * 3u + 1u;\n"
+					 "}\n"));
+	if (!p)
+		piglit_report_result(PIGLIT_FAIL);
+
+	glUseProgram(p);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, throughput_buf);
+	num_groups = THROUGHPUT_INVOCATIONS / local_size;
+
+	double rate = perf_measure_gpu_rate(dispatch_throughput, duration);
+
+	printf(" %3u, local size %4u, %6u groups, %s%8.1f%s Minvocations/s\n",
+	       test_index, local_size, num_groups,
+	       color ? COLOR_CYAN : "",
+	       rate * THROUGHPUT_INVOCATIONS / 1000000.0,
+	       color ? COLOR_RESET : "");
+
+	glDeleteProgram(p);
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	static const GLuint indirect_params[3] = {1, 1, 1};
+	static const GLuint zero[4] = {0};
+	unsigned i;
+
+	piglit_require_gl_version(32);
+	piglit_require_extension("GL_ARB_compute_shader");
+	piglit_require_extension("GL_ARB_shader_storage_buffer_object");
+	piglit_require_extension("GL_ARB_shader_image_load_store");
+	piglit_require_extension("GL_ARB_shading_language_420pack");
+
+	glGenBuffers(ARRAY_SIZE(ssbo), ssbo);
+	glGenBuffers(ARRAY_SIZE(ubo), ubo);
+	glGenTextures(ARRAY_SIZE(img), img);
+	for (i = 0; i < ARRAY_SIZE(ssbo); i++) {
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo[i]);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(zero), zero,
+			     GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, ubo[i]);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(zero), zero,
+			     GL_STATIC_DRAW);
+		glBindTexture(GL_TEXTURE_2D, img[i]);
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32UI, 1, 1);
+	}
+
+	glGenBuffers(1, &indirect_buf);
+	glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, indirect_buf);
+	glBufferData(GL_DISPATCH_INDIRECT_BUFFER, sizeof(indirect_params),
+		     indirect_params, GL_STATIC_DRAW);
+
+	glGenBuffers(1, &throughput_buf);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, throughput_buf);
+	glBufferData(GL_SHADER_STORAGE_BUFFER,
+		     THROUGHPUT_INVOCATIONS * sizeof(GLuint), NULL,
+		     GL_DYNAMIC_DRAW);
+
+	puts("   #, Test name                                                            ,    Thousands dispatches/s, Difference vs the 1st");
+
+	for (indirect = false; ; indirect = true) {
+		const char *call = indirect ? "DispatchComputeIndirect" :
+					      "DispatchCompute";
+		double base_rate;
+
+		num_ssbos = num_ubos = num_images = 0;
+		base_rate = perf_run(call, "no state change",
+				     dispatch_no_change, 0);
+
+		num_ssbos = num_ubos = num_images = MAX_BINDINGS;
+		perf_run(call, "no state change", dispatch_no_change,
+			 base_rate);
+
+		num_ssbos = 1;
+		num_ubos = num_images = 0;
+		perf_run(call, "1/1 SSBO change", dispatch_one_ssbo_change,
+			 base_rate);
+		num_ssbos = MAX_BINDINGS;
+		perf_run(call, "1/8 SSBO change", dispatch_one_ssbo_change,
+			 base_rate);
+		perf_run(call, "8/8 SSBOs change", dispatch_many_ssbo_change,
+			 base_rate);
+
+		num_ssbos = 0;
+		num_ubos = 1;
+		perf_run(call, "1/1 UBO change", dispatch_one_ubo_change,
+			 base_rate);
+		num_ubos = MAX_BINDINGS;
+		perf_run(call, "1/8 UBO change", dispatch_one_ubo_change,
+			 base_rate);
+		perf_run(call, "8/8 UBOs change", dispatch_many_ubo_change,
+			 base_rate);
+
+		num_ubos = 0;
+		num_images = 1;
+		perf_run(call, "1/1 image change", dispatch_one_img_change,
+			 base_rate);
+		num_images = MAX_BINDINGS;
+		perf_run(call, "1/8 image change", dispatch_one_img_change,
+			 base_rate);
+		perf_run(call, "8/8 images change", dispatch_many_img_change,
+			 base_rate);
+
+		num_images = 0;
+		num_ssbos = 1;
+		barrier_bits = GL_SHADER_STORAGE_BARRIER_BIT;
+		perf_run(call, "SSBO barrier", dispatch_barrier, base_rate);
+		barrier_bits = GL_ALL_BARRIER_BITS;
+		perf_run(call, "all barriers", dispatch_barrier, base_rate);
+
+		perf_run(call, "shader program change",
+			 dispatch_shader_change, base_rate);
+		num_ssbos = num_ubos = num_images = MAX_BINDINGS;
+		perf_run(call, "shader program change",
+			 dispatch_shader_change, base_rate);
+
+		if (indirect)
+			break;
+	}
+
+	if (!piglit_is_extension_supported("GL_ARB_timer_query")) {
+		puts("GL_ARB_timer_query not supported, throughput tests skipped");
+		exit(0);
+	}
+
+	puts("\n   #, Workgroup size                 , GPU throughput");
+	for (i = 32; i <= 1024; i *= 2)
+		perf_throughput(i);
+
+	exit(0);
+}
+
+/** Called from test harness/main */
+enum piglit_result
+piglit_display(void)
+{
+	return PIGLIT_FAIL;
+}
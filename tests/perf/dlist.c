@@ -0,0 +1,273 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Measure display list compile and execute rates.
+ *
+ * Lists of growing size are compiled with glNewList(GL_COMPILE) and
+ * GL_COMPILE_AND_EXECUTE and then executed with glCallList, for these
+ * kinds of content:
+ * - glVertex only
+ * - glColor, glNormal, glTexCoord and glVertex for every vertex
+ * - the above with matrix, material and enable changes every 16 triangles
+ * - a list of glCallList of 16-triangle lists
+ *
+ * Like the calllist cases in drawoverhead, triangles are tiny so that the
+ * GPU doesn't affect the results.
+ */
+
+#include "common.h"
+#include <stdbool.h>
+#include "piglit-util-gl.h"
+
+static bool color = true;
+static int selected_test_index = -1;
+static double duration = 1;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 10;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-nocolor")) {
+			color = false;
+		}
+		if (!strcmp(argv[i], "-test")) {
+			if (i == argc - 1) {
+				fprintf(stderr, "-test requires an argument\n");
+				exit(1);
+			}
+
+			const char *testnum = argv[i + 1];
+			char *endptr;
+			selected_test_index = strtol(testnum, &endptr, 10);
+
+			if (endptr != argv[i + 1] + strlen(testnum)) {
+				fprintf(stderr,
+					"Failed to parse test number '%s'\n", testnum);
+				exit(1);
+			}
+
+			printf("Running only test %d\n", selected_test_index);
+			i++;
+		}
+		if (!strcmp(argv[i], "-duration")) {
+			if (i == argc - 1) {
+				fprintf(stderr, "-duration requires an argument\n");
+				exit(1);
+			}
+
+			duration = strtod(argv[i + 1], NULL);
+			printf("Duration forced to %.2f seconds\n", duration);
+			i++;
+		}
+
+		if (!strcmp(argv[i], "-help")) {
+			fprintf(stderr, "dlist [-test TESTNUM] "
+				"[-duration SECS] [-nocolor]\n");
+			exit(1);
+		}
+	}
+
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+PIGLIT_GL_TEST_CONFIG_END
+
+/* Small vertex coordinate to generate as small a triangle as possible
+ * for the lowest GPU overhead.
+ */
+#define V1 0.00001
+
+/* Vertices between state changes, and per nested list. */
+#define CHUNK_VERTICES 48
+#define NUM_CHILD_LISTS 16
+
+enum content {
+	CONTENT_VERTEX,
+	CONTENT_ALL_ATTRIBS,
+	CONTENT_STATE_CHANGES,
+	CONTENT_NESTED,
+	NUM_CONTENTS,
+};
+
+static const char *content_names[NUM_CONTENTS] = {
+	"glVertex",
+	"glColor/Normal/TexCoord/Vertex",
+	"all attribs + state changes",
+	"nested glCallList",
+};
+
+static GLuint list, child_lists;
+static enum content content;
+static unsigned num_vertices;
+static GLenum compile_mode;
+
+#define COLOR_RESET	"\033[0m"
+#define COLOR_CYAN	"\033[1;36m"
+
+static void
+emit_vertices(unsigned first, unsigned count, bool all_attribs)
+{
+	glBegin(GL_TRIANGLES);
+	for (unsigned v = first; v < first + count; v++) {
+		if (all_attribs) {
+			glColor4f(1, v & 1, 0, 1);
+			glNormal3f(0, 0, 1);
+			glTexCoord2f(v & 1, 0);
+		}
+		glVertex3f(v % 3 == 1 ? V1 : 0, v % 3 == 2 ? V1 : 0, 0);
+	}
+	glEnd();
+}
+
+static void
+emit_state_change(unsigned chunk)
+{
+	static const float diffuse[2][4] = {
+		{ 1, 0, 0, 1 },
+		{ 0, 1, 0, 1 },
+	};
+
+	glPopMatrix();
+	glPushMatrix();
+	glTranslatef(chunk & 1 ? V1 : 0, 0, 0);
+	glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, diffuse[chunk & 1]);
+	if (chunk & 1)
+		glEnable(GL_BLEND);
+	else
+		glDisable(GL_BLEND);
+}
+
+static void
+emit_content(void)
+{
+	unsigned v, chunk;
+
+	switch (content) {
+	case CONTENT_VERTEX:
+		emit_vertices(0, num_vertices, false);
+		break;
+	case CONTENT_ALL_ATTRIBS:
+		emit_vertices(0, num_vertices, true);
+		break;
+	case CONTENT_STATE_CHANGES:
+		glPushMatrix();
+		for (v = 0, chunk = 0; v < num_vertices;
+		     v += CHUNK_VERTICES, chunk++) {
+			emit_state_change(chunk);
+			emit_vertices(v, MIN2(CHUNK_VERTICES, num_vertices - v),
+				      true);
+		}
+		glPopMatrix();
+		glDisable(GL_BLEND);
+		break;
+	case CONTENT_NESTED:
+		for (v = 0, chunk = 0; v < num_vertices;
+		     v += CHUNK_VERTICES, chunk++)
+			glCallList(child_lists + chunk % NUM_CHILD_LISTS);
+		break;
+	case NUM_CONTENTS:
+		break;
+	}
+}
+
+static void
+compile(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		glNewList(list, compile_mode);
+		emit_content();
+		glEndList();
+	}
+}
+
+static void
+execute(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++)
+		glCallList(list);
+}
+
+static void
+print_rate(double rate)
+{
+	printf(", %s%9.1f%s, %8.2f",
+	       color ? COLOR_CYAN : "", rate, color ? COLOR_RESET : "",
+	       rate * num_vertices / 1000000);
+}
+
+static void
+perf_run(void)
+{
+	static unsigned test_index;
+	test_index++;
+
+	if (selected_test_index != -1 && test_index != selected_test_index)
+		return;
+
+	printf(" %3u, %-30s %6u verts", test_index, content_names[content],
+	       num_vertices);
+
+	compile_mode = GL_COMPILE;
+	print_rate(perf_measure_cpu_rate(compile, duration));
+	compile_mode = GL_COMPILE_AND_EXECUTE;
+	print_rate(perf_measure_cpu_rate(compile, duration));
+
+	/* Execute the list compiled last. */
+	print_rate(perf_measure_cpu_rate(execute, duration));
+	printf("\n");
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	static const unsigned sizes[] = {
+		CHUNK_VERTICES, CHUNK_VERTICES * 16, CHUNK_VERTICES * 256,
+		CHUNK_VERTICES * 4096,
+	};
+
+	list = glGenLists(1);
+
+	child_lists = glGenLists(NUM_CHILD_LISTS);
+	for (unsigned i = 0; i < NUM_CHILD_LISTS; i++) {
+		glNewList(child_lists + i, GL_COMPILE);
+		emit_vertices(0, CHUNK_VERTICES, i & 1);
+		glEndList();
+	}
+
+	puts("   #, Content                        Size       , "
+	     "Compile/s, Mverts/s, Comp+Ex/s, Mverts/s, Execute/s, Mverts/s");
+
+	for (content = 0; content < NUM_CONTENTS; content++) {
+		for (unsigned s = 0; s < ARRAY_SIZE(sizes); s++) {
+			num_vertices = sizes[s];
+			perf_run();
+		}
+	}
+
+	exit(0);
+}
+
+/** Called from test harness/main */
+enum piglit_result
+piglit_display(void)
+{
+	return PIGLIT_FAIL;
+}
@@ -0,0 +1,380 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Measure the GPU throughput of framebuffer clears, blits, multisample
+ * resolves and glCopyImageSubData over a matrix of color and depth
+ * formats.
+ *
+ * Clears are measured with values that are likely to hit fast clear
+ * paths (0 and 1) and with arbitrary values. Blits are measured 1:1,
+ * downscaled 2x with filtering, converting to GL_RGBA8, and as resolves
+ * from 2, 4, 8 and 16 samples. Throughput is reported in destination
+ * pixels per second and the corresponding bandwidth of the destination
+ * format.
+ */
+
+#include "common.h"
+#include "piglit-fbo.h"
+using namespace piglit_util_fbo;
+
+static int selected_test_index = -1;
+static double duration = 1;
+static int size = 1024;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_core_version = 32;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-test")) {
+			if (i == argc - 1) {
+				fprintf(stderr, "-test requires an argument\n");
+				exit(1);
+			}
+
+			const char *testnum = argv[i + 1];
+			char *endptr;
+			selected_test_index = strtol(testnum, &endptr, 10);
+
+			if (endptr != argv[i + 1] + strlen(testnum)) {
+				fprintf(stderr,
+					"Failed to parse test number '%s'\n", testnum);
+				exit(1);
+			}
+
+			printf("Running only test %d\n", selected_test_index);
+			i++;
+		}
+		if (!strcmp(argv[i], "-duration")) {
+			if (i == argc - 1) {
+				fprintf(stderr, "-duration requires an argument\n");
+				exit(1);
+			}
+
+			duration = strtod(argv[i + 1], NULL);
+			printf("Duration forced to %.2f seconds\n", duration);
+			i++;
+		}
+		if (!strcmp(argv[i], "-size")) {
+			if (i == argc - 1) {
+				fprintf(stderr, "-size requires an argument\n");
+				exit(1);
+			}
+
+			size = atoi(argv[i + 1]);
+			i++;
+		}
+
+		if (!strcmp(argv[i], "-help")) {
+			fprintf(stderr, "fbo-bandwidth [-test TESTNUM] "
+				"[-duration SECS] [-size PIXELS]\n");
+			exit(1);
+		}
+	}
+
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+PIGLIT_GL_TEST_CONFIG_END
+
+namespace {
+
+struct format {
+	GLenum internalformat;
+	const char *name;
+	unsigned bpp;
+	GLbitfield mask;
+};
+
+const struct format formats[] = {
+	{ GL_R8, "R8", 1, GL_COLOR_BUFFER_BIT },
+	{ GL_RGBA8, "RGBA8", 4, GL_COLOR_BUFFER_BIT },
+	{ GL_SRGB8_ALPHA8, "SRGB8_ALPHA8", 4, GL_COLOR_BUFFER_BIT },
+	{ GL_RGB10_A2, "RGB10_A2", 4, GL_COLOR_BUFFER_BIT },
+	{ GL_R11F_G11F_B10F, "R11F_G11F_B10F", 4, GL_COLOR_BUFFER_BIT },
+	{ GL_RGBA16F, "RGBA16F", 8, GL_COLOR_BUFFER_BIT },
+	{ GL_RGBA32F, "RGBA32F", 16, GL_COLOR_BUFFER_BIT },
+	{ GL_DEPTH_COMPONENT16, "DEPTH16", 2, GL_DEPTH_BUFFER_BIT },
+	{ GL_DEPTH_COMPONENT24, "DEPTH24", 4, GL_DEPTH_BUFFER_BIT },
+	{ GL_DEPTH_COMPONENT32F, "DEPTH32F", 4, GL_DEPTH_BUFFER_BIT },
+	/* Fbo only supports packed depth/stencil as GL_DEPTH_STENCIL. */
+	{ GL_DEPTH24_STENCIL8, "DEPTH24_STENCIL8", 4,
+	  GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT },
+};
+
+const int sample_counts[] = { 2, 4, 8, 16 };
+
+const float clear_colors[2][2][4] = {
+	{ { 0, 0, 0, 0 }, { 1, 1, 1, 1 } },
+	{ { 0.2, 0.4, 0.6, 0.8 }, { 0.7, 0.5, 0.3, 0.1 } },
+};
+
+const float clear_depths[2][2] = {
+	{ 0, 1 },
+	{ 0.3, 0.6 },
+};
+
+Fbo src_fbo, dst_fbo, half_fbo, rgba8_fbo, ms_fbo;
+bool has_copy_image;
+GLint max_samples;
+
+/* State of the operation being measured. */
+GLbitfield op_mask;
+GLenum op_filter;
+int src_size, dst_size;
+bool arbitrary_value;
+GLuint copy_src, copy_dst;
+
+/**
+ * Set up \p fbo for the format. Attachments that were left over from a
+ * previous format of the other kind (color vs depth) are detached first,
+ * because Fbo only ever attaches buffers.
+ */
+bool
+setup_fbo(Fbo &fbo, const struct format *f, int samples, int fbo_size)
+{
+	FboConfig config(samples, fbo_size, fbo_size);
+
+	if (fbo.handle) {
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo.handle);
+		glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER,
+					  GL_COLOR_ATTACHMENT0,
+					  GL_RENDERBUFFER, 0);
+		glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER,
+					  GL_DEPTH_STENCIL_ATTACHMENT,
+					  GL_RENDERBUFFER, 0);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, piglit_winsys_fbo);
+	}
+
+	config.combine_depth_stencil = false;
+	config.color_internalformat = GL_NONE;
+	config.depth_internalformat = GL_NONE;
+	config.stencil_internalformat = GL_NONE;
+
+	if (f->mask & GL_COLOR_BUFFER_BIT)
+		config.color_internalformat = f->internalformat;
+	else if (f->mask & GL_STENCIL_BUFFER_BIT)
+		config.combine_depth_stencil = true;
+	else
+		config.depth_internalformat = f->internalformat;
+
+	bool ok = fbo.try_setup(config);
+
+	/* Swallow GL_OUT_OF_MEMORY and friends for unsupported
+	 * combinations.
+	 */
+	while (glGetError() != GL_NO_ERROR)
+		;
+	return ok;
+}
+
+GLuint
+get_renderbuffer(const Fbo &fbo, const struct format *f)
+{
+	return f->mask & GL_COLOR_BUFFER_BIT ? fbo.color_rb[0] : fbo.depth_rb;
+}
+
+void
+clear(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		const float *c = clear_colors[arbitrary_value][i & 1];
+
+		if (op_mask & GL_COLOR_BUFFER_BIT)
+			glClearColor(c[0], c[1], c[2], c[3]);
+		if (op_mask & GL_DEPTH_BUFFER_BIT)
+			glClearDepth(clear_depths[arbitrary_value][i & 1]);
+		if (op_mask & GL_STENCIL_BUFFER_BIT)
+			glClearStencil(i & 1 ? 0xff : 0);
+		glClear(op_mask);
+	}
+}
+
+void
+clear_buffer(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		const float depth = clear_depths[arbitrary_value][i & 1];
+
+		if (op_mask & GL_COLOR_BUFFER_BIT) {
+			glClearBufferfv(GL_COLOR, 0,
+					clear_colors[arbitrary_value][i & 1]);
+		} else if (op_mask & GL_STENCIL_BUFFER_BIT) {
+			glClearBufferfi(GL_DEPTH_STENCIL, 0, depth,
+					i & 1 ? 0xff : 0);
+		} else {
+			glClearBufferfv(GL_DEPTH, 0, &depth);
+		}
+	}
+}
+
+void
+blit(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		glBlitFramebuffer(0, 0, src_size, src_size,
+				  0, 0, dst_size, dst_size,
+				  op_mask, op_filter);
+	}
+}
+
+void
+copy_image(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		glCopyImageSubData(copy_src, GL_RENDERBUFFER, 0, 0, 0, 0,
+				   copy_dst, GL_RENDERBUFFER, 0, 0, 0, 0,
+				   src_size, src_size, 1);
+	}
+}
+
+/**
+ * Measure \p f, which writes \p pixels pixels of \p bpp bytes per
+ * iteration, with the read and draw framebuffers already bound. \p fmt
+ * names the row.
+ */
+void
+perf_run(const char *op, const struct format *fmt, int samples,
+	 perf_rate_func f, unsigned pixels, unsigned bpp, bool supported)
+{
+	static unsigned test_index;
+	test_index++;
+
+	if (selected_test_index != -1 &&
+	    (int)test_index != selected_test_index)
+		return;
+
+	char name[64];
+	if (samples)
+		snprintf(name, sizeof(name), "%s %2ux", op, samples);
+	else
+		snprintf(name, sizeof(name), "%s", op);
+
+	if (!supported) {
+		printf(" %3u, %-28s %-18s, not supported\n", test_index, name,
+		       fmt->name);
+		return;
+	}
+
+	double rate = perf_measure_gpu_rate(f, duration);
+
+	printf(" %3u, %-28s %-18s, %10.1f, %8.2f\n", test_index, name,
+	       fmt->name, rate * pixels / 1000000.0,
+	       rate * pixels * bpp / (1024.0 * 1024 * 1024));
+}
+
+void
+bind_fbos(const Fbo &read, const Fbo &draw)
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, read.handle);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, draw.handle);
+}
+
+void
+run_format(const struct format *f)
+{
+	const unsigned pixels = size * size;
+	const bool is_color = f->mask & GL_COLOR_BUFFER_BIT;
+	bool ok = setup_fbo(src_fbo, f, 0, size) &&
+		  setup_fbo(dst_fbo, f, 0, size);
+
+	op_mask = f->mask;
+	op_filter = GL_NEAREST;
+	src_size = dst_size = size;
+
+	/* Clears */
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dst_fbo.handle);
+	arbitrary_value = false;
+	perf_run("Clear 0/1", f, 0, clear, pixels, f->bpp, ok);
+	perf_run("ClearBuffer 0/1", f, 0, clear_buffer, pixels, f->bpp, ok);
+	arbitrary_value = true;
+	perf_run("Clear arbitrary", f, 0, clear, pixels, f->bpp, ok);
+	perf_run("ClearBuffer arbitrary", f, 0, clear_buffer, pixels, f->bpp, ok);
+
+	/* Blits */
+	bind_fbos(src_fbo, dst_fbo);
+	perf_run("Blit 1:1", f, 0, blit, pixels, f->bpp, ok);
+
+	/* Only color blits may be filtered. */
+	bool half_ok = ok && setup_fbo(half_fbo, f, 0, size / 2);
+	bind_fbos(src_fbo, half_fbo);
+	dst_size = size / 2;
+	op_filter = is_color ? GL_LINEAR : GL_NEAREST;
+	perf_run(is_color ? "Blit 2x down, linear" : "Blit 2x down", f, 0,
+		 blit, pixels / 4, f->bpp, half_ok);
+	dst_size = size;
+	op_filter = GL_NEAREST;
+
+	if (is_color && f->internalformat != GL_RGBA8) {
+		const struct format *rgba8 = &formats[1];
+		bool conv_ok = ok && setup_fbo(rgba8_fbo, rgba8, 0, size);
+
+		bind_fbos(src_fbo, rgba8_fbo);
+		perf_run("Blit to RGBA8", f, 0, blit, pixels, rgba8->bpp,
+			 conv_ok);
+	}
+
+	/* Resolves */
+	for (unsigned i = 0; i < ARRAY_SIZE(sample_counts); i++) {
+		int samples = sample_counts[i];
+		bool ms_ok = ok && samples <= max_samples &&
+			     setup_fbo(ms_fbo, f, samples, size);
+
+		bind_fbos(ms_fbo, dst_fbo);
+		perf_run("Resolve", f, samples, blit, pixels, f->bpp,
+			 ms_ok);
+	}
+
+	/* Copies */
+	copy_src = get_renderbuffer(src_fbo, f);
+	copy_dst = get_renderbuffer(dst_fbo, f);
+	perf_run("CopyImageSubData", f, 0, copy_image, pixels, f->bpp,
+		 ok && has_copy_image);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, piglit_winsys_fbo);
+}
+
+} /* anonymous namespace */
+
+void
+piglit_init(int argc, char **argv)
+{
+	if (piglit_get_gl_version() < 33)
+		piglit_require_extension("GL_ARB_timer_query");
+
+	has_copy_image = piglit_get_gl_version() >= 43 ||
+		piglit_is_extension_supported("GL_ARB_copy_image");
+	glGetIntegerv(GL_MAX_SAMPLES, &max_samples);
+
+	printf("%ux%u pixels\n", size, size);
+	puts("   #, Operation                    Format            ,    Mpix/s,     GB/s");
+
+	for (unsigned i = 0; i < ARRAY_SIZE(formats); i++)
+		run_format(&formats[i]);
+
+	exit(0);
+}
+
+/** Called from test harness/main */
+enum piglit_result
+piglit_display(void)
+{
+	return PIGLIT_FAIL;
+}
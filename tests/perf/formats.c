@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) 2009 VMware, Inc.
+ * Copyright (C) 2017 Advanced Micro Devices, Inc.
+ * Copyright (C) 2021 Valve Corporation
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * VMWARE BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Internal format/format/type combinations shared by the pixel transfer
+ * benchmarks.
+ */
+
+#include "piglit-util-gl.h"
+#include "formats.h"
+
+const Format format_es[] = {
+	{GL_RGBA8,				GL_RGBA,			GL_UNSIGNED_BYTE},
+	{GL_RGB5_A1,			GL_RGBA,			GL_UNSIGNED_BYTE},
+	{GL_RGBA4,				GL_RGBA,			GL_UNSIGNED_BYTE},
+	{GL_SRGB8_ALPHA8,		GL_RGBA,			GL_UNSIGNED_BYTE},
+	{GL_RGBA8_SNORM,		GL_RGBA,			GL_BYTE},
+	{GL_RGBA4,				GL_RGBA,			GL_UNSIGNED_SHORT_4_4_4_4},
+	{GL_RGB5_A1,			GL_RGBA,			GL_UNSIGNED_SHORT_5_5_5_1},
+	{GL_RGB10_A2,			GL_RGBA,			GL_UNSIGNED_INT_2_10_10_10_REV},
+	{GL_RGB5_A1,			GL_RGBA,			GL_UNSIGNED_INT_2_10_10_10_REV},
+	{GL_RGBA16F,			GL_RGBA,			GL_HALF_FLOAT},
+	{GL_RGBA32F,			GL_RGBA,			GL_FLOAT},
+	{GL_RGBA16F,			GL_RGBA,			GL_FLOAT},
+	{GL_RGB8,				GL_RGB,			GL_UNSIGNED_BYTE},
+	{GL_RGB565,			GL_RGB,			GL_UNSIGNED_BYTE},
+	{GL_SRGB8,				GL_RGB,			GL_UNSIGNED_BYTE},
+	{GL_RGB8_SNORM,		GL_RGB,			GL_BYTE},
+	{GL_RGB565,			GL_RGB,			GL_UNSIGNED_SHORT_5_6_5},
+	{GL_R11F_G11F_B10F,	GL_RGB,			GL_UNSIGNED_INT_10F_11F_11F_REV},
+	{GL_R11F_G11F_B10F,	GL_RGB,			GL_HALF_FLOAT},
+	{GL_R11F_G11F_B10F,	GL_RGB,			GL_FLOAT},
+	{GL_RGB9_E5,			GL_RGB,			GL_UNSIGNED_INT_5_9_9_9_REV},
+	{GL_RGB9_E5,			GL_RGB,			GL_HALF_FLOAT},
+	{GL_RGB9_E5,			GL_RGB,			GL_FLOAT},
+	{GL_RGB16F,			GL_RGB,			GL_HALF_FLOAT},
+	{GL_RGB32F,			GL_RGB,			GL_FLOAT},
+	{GL_RGB16F,			GL_RGB,			GL_FLOAT},
+	{GL_RG8,				GL_RG,				GL_UNSIGNED_BYTE},
+	{GL_RG8_SNORM,			GL_RG,				GL_BYTE},
+	{GL_RG16F,				GL_RG,				GL_HALF_FLOAT},
+	{GL_RG32F,				GL_RG,				GL_FLOAT},
+	{GL_RG16F,				GL_RG,				GL_FLOAT},
+	{GL_R8,				GL_RED,			GL_UNSIGNED_BYTE},
+	{GL_R8_SNORM,			GL_RED,			GL_BYTE},
+	{GL_R16F,				GL_RED,			GL_HALF_FLOAT},
+	{GL_R32F,				GL_RED,			GL_FLOAT},
+	{GL_R16F,				GL_RED,			GL_FLOAT},
+	{GL_RGBA,				GL_RGBA,			GL_UNSIGNED_BYTE},
+	{GL_RGBA,				GL_RGBA,			GL_UNSIGNED_SHORT_4_4_4_4},
+	{GL_RGBA,				GL_RGBA,			GL_UNSIGNED_SHORT_5_5_5_1},
+	{GL_RGB,				GL_RGB,			GL_UNSIGNED_BYTE},
+	{GL_RGB,				GL_RGB,			GL_UNSIGNED_SHORT_5_6_5},
+	{GL_LUMINANCE_ALPHA,	GL_LUMINANCE_ALPHA,GL_UNSIGNED_BYTE},
+	{GL_LUMINANCE,			GL_LUMINANCE,		GL_UNSIGNED_BYTE},
+	{GL_ALPHA,				GL_ALPHA,			GL_UNSIGNED_BYTE}
+};
+const unsigned num_format_es = ARRAY_SIZE(format_es);
+
+const Format format_es_int[] = {
+	{GL_RGBA8UI,			GL_RGBA_INTEGER,	GL_UNSIGNED_BYTE},
+	{GL_RGBA8I,			GL_RGBA_INTEGER,	GL_BYTE},
+	{GL_RGBA16UI,			GL_RGBA_INTEGER,	GL_UNSIGNED_SHORT},
+	{GL_RGBA16I,			GL_RGBA_INTEGER,	GL_SHORT},
+	{GL_RGBA32UI,			GL_RGBA_INTEGER,	GL_UNSIGNED_INT},
+	{GL_RGBA32I,			GL_RGBA_INTEGER,	GL_INT},
+	{GL_RGB10_A2UI,		GL_RGBA_INTEGER,	GL_UNSIGNED_INT_2_10_10_10_REV},
+	{GL_RGB8UI,			GL_RGB_INTEGER,	GL_UNSIGNED_BYTE},
+	{GL_RGB8I,				GL_RGB_INTEGER,	GL_BYTE},
+	{GL_RGB16UI,			GL_RGB_INTEGER,	GL_UNSIGNED_SHORT},
+	{GL_RGB16I,			GL_RGB_INTEGER,	GL_SHORT},
+	{GL_RGB32UI,			GL_RGB_INTEGER,	GL_UNSIGNED_INT},
+	{GL_RGB32I,			GL_RGB_INTEGER,	GL_INT},
+	{GL_RG8UI,				GL_RG_INTEGER,		GL_UNSIGNED_BYTE},
+	{GL_RG8I,				GL_RG_INTEGER,		GL_BYTE},
+	{GL_RG16UI,			GL_RG_INTEGER,		GL_UNSIGNED_SHORT},
+	{GL_RG16I,				GL_RG_INTEGER,		GL_SHORT},
+	{GL_RG32UI,			GL_RG_INTEGER,		GL_UNSIGNED_INT},
+	{GL_RG32I,				GL_RG_INTEGER,		GL_INT},
+	{GL_R8UI,				GL_RED_INTEGER,	GL_UNSIGNED_BYTE},
+	{GL_R8I,				GL_RED_INTEGER,	GL_BYTE},
+	{GL_R16UI,				GL_RED_INTEGER,	GL_UNSIGNED_SHORT},
+	{GL_R16I,				GL_RED_INTEGER,	GL_SHORT},
+	{GL_R32UI,				GL_RED_INTEGER,	GL_UNSIGNED_INT},
+	{GL_R32I,				GL_RED_INTEGER,	GL_INT},
+	{GL_DEPTH_COMPONENT24,GL_DEPTH_COMPONENT,GL_UNSIGNED_INT},
+	{GL_DEPTH_COMPONENT16,GL_DEPTH_COMPONENT,GL_UNSIGNED_INT},
+	{GL_DEPTH_COMPONENT16,GL_DEPTH_COMPONENT,GL_UNSIGNED_SHORT},
+	{GL_DEPTH_COMPONENT32F,GL_DEPTH_COMPONENT,GL_FLOAT},
+	{GL_DEPTH24_STENCIL8,GL_DEPTH_STENCIL,	GL_UNSIGNED_INT_24_8},
+	{GL_DEPTH32F_STENCIL8,GL_DEPTH_STENCIL,	GL_FLOAT_32_UNSIGNED_INT_24_8_REV},
+};
+const unsigned num_format_es_int = ARRAY_SIZE(format_es_int);
+
+const Format format_core[] = {
+	{GL_RGB,			GL_RGB,			GL_UNSIGNED_BYTE_3_3_2},
+	{GL_RGB,			GL_RGB,			GL_UNSIGNED_BYTE_2_3_3_REV},
+	{GL_RGB,			GL_RGB,			GL_UNSIGNED_SHORT_5_6_5},
+	{GL_RGB,			GL_RGB,			GL_UNSIGNED_SHORT_5_6_5_REV},
+	{GL_RGB,			GL_RGB,			GL_UNSIGNED_INT_10F_11F_11F_REV},
+	{GL_RGB,			GL_RGB,			GL_UNSIGNED_INT_5_9_9_9_REV},
+	{GL_RGBA,			GL_RGBA,		GL_UNSIGNED_SHORT_4_4_4_4},
+	{GL_RGBA,			GL_RGBA,		GL_UNSIGNED_SHORT_4_4_4_4_REV},
+	{GL_BGRA,			GL_BGRA,		GL_UNSIGNED_SHORT_4_4_4_4_REV},
+	{GL_BGRA,			GL_BGRA,		GL_UNSIGNED_SHORT_4_4_4_4},
+	{GL_RGBA,			GL_RGBA,		GL_UNSIGNED_SHORT_5_5_5_1},
+	{GL_BGRA,			GL_BGRA,		GL_UNSIGNED_SHORT_5_5_5_1},
+	{GL_RGBA,			GL_RGBA,		GL_UNSIGNED_SHORT_1_5_5_5_REV},
+	{GL_BGRA,			GL_BGRA,		GL_UNSIGNED_SHORT_1_5_5_5_REV},
+	{GL_RGBA,			GL_RGBA,		GL_UNSIGNED_INT_8_8_8_8},
+	{GL_BGRA,			GL_BGRA,		GL_UNSIGNED_INT_8_8_8_8},
+	{GL_RGBA,			GL_RGBA,		GL_UNSIGNED_INT_8_8_8_8_REV},
+	{GL_BGRA,			GL_BGRA,		GL_UNSIGNED_INT_8_8_8_8_REV},
+	{GL_RGBA,			GL_RGBA,		GL_UNSIGNED_INT_10_10_10_2},
+	{GL_BGRA,			GL_BGRA,		GL_UNSIGNED_INT_10_10_10_2},
+	{GL_RGBA,			GL_RGBA,		GL_UNSIGNED_INT_2_10_10_10_REV},
+	{GL_BGRA,			GL_BGRA,		GL_UNSIGNED_INT_2_10_10_10_REV},
+};
+const unsigned num_format_core = ARRAY_SIZE(format_core);
+
+const Format format_core_int[] = {
+	{GL_RGB_INTEGER,	GL_RGB_INTEGER,GL_UNSIGNED_BYTE_3_3_2},
+	{GL_RGB_INTEGER,	GL_RGB_INTEGER,GL_UNSIGNED_BYTE_2_3_3_REV},
+	{GL_RGB_INTEGER,	GL_RGB_INTEGER,GL_UNSIGNED_SHORT_5_6_5},
+	{GL_RGB_INTEGER,	GL_RGB_INTEGER,GL_UNSIGNED_SHORT_5_6_5_REV},
+	{GL_RGBA_INTEGER,	GL_RGBA_INTEGER,GL_UNSIGNED_SHORT_4_4_4_4},
+	{GL_RGBA_INTEGER,	GL_RGBA_INTEGER,GL_UNSIGNED_SHORT_4_4_4_4_REV},
+	{GL_BGRA_INTEGER,	GL_BGRA_INTEGER,GL_UNSIGNED_SHORT_4_4_4_4_REV},
+	{GL_BGRA_INTEGER,	GL_BGRA_INTEGER,GL_UNSIGNED_SHORT_4_4_4_4},
+	{GL_RGBA_INTEGER,GL_RGBA_INTEGER,GL_UNSIGNED_SHORT_5_5_5_1},
+	{GL_BGRA_INTEGER,GL_BGRA_INTEGER,GL_UNSIGNED_SHORT_5_5_5_1},
+	{GL_RGBA_INTEGER,GL_RGBA_INTEGER,GL_UNSIGNED_SHORT_1_5_5_5_REV},
+	{GL_BGRA_INTEGER,GL_BGRA_INTEGER,GL_UNSIGNED_SHORT_1_5_5_5_REV},
+	{GL_RGBA_INTEGER,GL_RGBA_INTEGER,GL_UNSIGNED_INT_8_8_8_8},
+	{GL_BGRA_INTEGER,GL_BGRA_INTEGER,GL_UNSIGNED_INT_8_8_8_8},
+	{GL_RGBA_INTEGER,GL_RGBA_INTEGER,GL_UNSIGNED_INT_8_8_8_8_REV},
+	{GL_BGRA_INTEGER,GL_BGRA_INTEGER,GL_UNSIGNED_INT_8_8_8_8_REV},
+	{GL_RGBA_INTEGER,GL_RGBA_INTEGER,GL_UNSIGNED_INT_10_10_10_2},
+	{GL_BGRA_INTEGER,GL_BGRA_INTEGER,GL_UNSIGNED_INT_10_10_10_2},
+	{GL_RGBA_INTEGER,GL_RGBA_INTEGER,GL_UNSIGNED_INT_2_10_10_10_REV},
+	{GL_BGRA_INTEGER,GL_BGRA_INTEGER,GL_UNSIGNED_INT_2_10_10_10_REV},
+	{GL_DEPTH_STENCIL,GL_DEPTH_STENCIL,GL_UNSIGNED_INT_24_8},
+	{GL_DEPTH_STENCIL,GL_DEPTH_STENCIL,GL_FLOAT_32_UNSIGNED_INT_24_8_REV}
+};
+const unsigned num_format_core_int = ARRAY_SIZE(format_core_int);
+
+const Format formats_EXT_texture_type_2_10_10_10_REV[] = {
+	{GL_RGBA,GL_RGBA,GL_UNSIGNED_INT_2_10_10_10_REV_EXT},
+	{GL_RGB,GL_RGB,GL_UNSIGNED_INT_2_10_10_10_REV_EXT}
+};
+const unsigned num_formats_EXT_texture_type_2_10_10_10_REV = ARRAY_SIZE(formats_EXT_texture_type_2_10_10_10_REV);
+
+const Format formats_OES_required_internalformat[] = {
+	{GL_RGB8_OES,GL_RGB,GL_UNSIGNED_INT_2_10_10_10_REV_EXT},
+	{GL_RGB565,GL_RGB,GL_UNSIGNED_INT_2_10_10_10_REV_EXT}
+};
+const unsigned num_formats_OES_required_internalformat = ARRAY_SIZE(formats_OES_required_internalformat);
+
+static unsigned
+type_size(GLenum type)
+{
+	switch (type) {
+	case GL_BYTE:
+	case GL_UNSIGNED_BYTE:
+		return 1;
+	case GL_SHORT:
+	case GL_UNSIGNED_SHORT:
+	case GL_HALF_FLOAT:
+		return 2;
+	default:
+		return 4;
+	}
+}
+
+/**
+ * Return the number of bytes of one pixel of client data in the given
+ * format and type.
+ */
+unsigned
+perf_format_pixel_size(const Format *f)
+{
+	switch (f->type) {
+	case GL_UNSIGNED_BYTE_3_3_2:
+	case GL_UNSIGNED_BYTE_2_3_3_REV:
+		return 1;
+	case GL_UNSIGNED_SHORT_5_6_5:
+	case GL_UNSIGNED_SHORT_5_6_5_REV:
+	case GL_UNSIGNED_SHORT_4_4_4_4:
+	case GL_UNSIGNED_SHORT_4_4_4_4_REV:
+	case GL_UNSIGNED_SHORT_5_5_5_1:
+	case GL_UNSIGNED_SHORT_1_5_5_5_REV:
+		return 2;
+	case GL_UNSIGNED_INT_8_8_8_8:
+	case GL_UNSIGNED_INT_8_8_8_8_REV:
+	case GL_UNSIGNED_INT_10_10_10_2:
+	case GL_UNSIGNED_INT_2_10_10_10_REV:
+	case GL_UNSIGNED_INT_10F_11F_11F_REV:
+	case GL_UNSIGNED_INT_5_9_9_9_REV:
+	case GL_UNSIGNED_INT_24_8:
+		return 4;
+	case GL_FLOAT_32_UNSIGNED_INT_24_8_REV:
+		return 8;
+	}
+
+	switch (f->format) {
+	case GL_RED_INTEGER:
+		return type_size(f->type);
+	case GL_RG_INTEGER:
+		return 2 * type_size(f->type);
+	case GL_RGB_INTEGER:
+		return 3 * type_size(f->type);
+	case GL_RGBA_INTEGER:
+	case GL_BGRA_INTEGER:
+		return 4 * type_size(f->type);
+	default:
+		return piglit_num_components(f->format) * type_size(f->type);
+	}
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2009 VMware, Inc.
+ * Copyright (C) 2017 Advanced Micro Devices, Inc.
+ * Copyright (C) 2021 Valve Corporation
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * VMWARE BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FORMATS_H
+#define FORMATS_H
+
+#include "piglit-util-gl.h"
+
+typedef struct Format {
+   GLenum internal_format;
+   GLenum format;
+   GLenum type;
+} Format;
+
+extern const Format format_es[];
+extern const unsigned num_format_es;
+extern const Format format_es_int[];
+extern const unsigned num_format_es_int;
+extern const Format format_core[];
+extern const unsigned num_format_core;
+extern const Format format_core_int[];
+extern const unsigned num_format_core_int;
+extern const Format formats_EXT_texture_type_2_10_10_10_REV[];
+extern const unsigned num_formats_EXT_texture_type_2_10_10_10_REV;
+extern const Format formats_OES_required_internalformat[];
+extern const unsigned num_formats_OES_required_internalformat;
+
+unsigned
+perf_format_pixel_size(const Format *f);
+
+#endif /* FORMATS_H */
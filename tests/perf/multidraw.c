@@ -0,0 +1,488 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Measure multi-draw and indirect draw throughput.
+ *
+ * Each draw method is measured for a sweep of draw counts and primitives
+ * per draw, and compared against issuing the same draws one at a time
+ * with glDrawArrays or glDrawElements:
+ * - glDrawElementsBaseVertex and glDrawElementsIndirect in a loop
+ * - glMultiDrawArrays, glMultiDrawElements(BaseVertex)
+ * - glMultiDraw{Arrays,Elements}Indirect
+ * - glMultiDraw{Arrays,Elements}IndirectCountARB
+ *
+ * The indirect draws use a different base vertex and base instance for
+ * every draw, and an instanced attribute is read so that the base
+ * instance isn't dead.
+ */
+
+#include "common.h"
+#include <stdbool.h>
+#include "piglit-util-gl.h"
+
+static bool color = true;
+static int selected_test_index = -1;
+static double duration = 1;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_core_version = 32;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-nocolor")) {
+			color = false;
+		}
+		if (!strcmp(argv[i], "-test")) {
+			if (i == argc - 1) {
+				fprintf(stderr, "-test requires an argument\n");
+				exit(1);
+			}
+
+			const char *testnum = argv[i + 1];
+			char *endptr;
+			selected_test_index = strtol(testnum, &endptr, 10);
+
+			if (endptr != argv[i + 1] + strlen(testnum)) {
+				fprintf(stderr,
+					"Failed to parse test number '%s'\n", testnum);
+				exit(1);
+			}
+
+			printf("Running only test %d\n", selected_test_index);
+			i++;
+		}
+		if (!strcmp(argv[i], "-duration")) {
+			if (i == argc - 1) {
+				fprintf(stderr, "-duration requires an argument\n");
+				exit(1);
+			}
+
+			duration = strtod(argv[i + 1], NULL);
+			printf("Duration forced to %.2f seconds\n", duration);
+			i++;
+		}
+
+		if (!strcmp(argv[i], "-help")) {
+			fprintf(stderr, "multidraw [-test TESTNUM] "
+				"[-duration SECS] [-nocolor]\n");
+			exit(1);
+		}
+	}
+
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+PIGLIT_GL_TEST_CONFIG_END
+
+#define MAX_DRAWS 1024
+#define MAX_PRIMS 512
+#define MAX_VERTICES (MAX_DRAWS * MAX_PRIMS * 3)
+
+/* Small vertex coordinate to generate as small a triangle as possible
+ * for the lowest GPU overhead.
+ */
+#define V1 0.00001
+
+struct arrays_cmd {
+	GLuint count;
+	GLuint instance_count;
+	GLuint first;
+	GLuint base_instance;
+};
+
+struct elements_cmd {
+	GLuint count;
+	GLuint instance_count;
+	GLuint first_index;
+	GLint base_vertex;
+	GLuint base_instance;
+};
+
+/* Both command arrays live in the same indirect buffer. */
+#define ELEMENTS_CMD_OFFSET (MAX_DRAWS * sizeof(struct arrays_cmd))
+
+static unsigned draw_count, prims_per_draw;
+static GLint firsts[MAX_DRAWS], base_vertices[MAX_DRAWS];
+static GLsizei counts[MAX_DRAWS];
+static const void *index_offsets[MAX_DRAWS], *zero_offsets[MAX_DRAWS];
+static GLuint indirect_buf, param_buf;
+static bool has_indirect, has_base_instance, has_indirect_count;
+
+#define COLOR_RESET	"\033[0m"
+#define COLOR_RED	"\033[31m"
+#define COLOR_GREEN	"\033[1;32m"
+#define COLOR_YELLOW	"\033[1;33m"
+#define COLOR_CYAN	"\033[1;36m"
+
+static const char *vs_text =
+	"#version 150\n"
+	"in vec2 pos;\n"
+	"in vec2 offset;\n"
+	"void main() {\n"
+	"	gl_Position = vec4(pos + offset, 0.0, 1.0);\n"
+	"}\n";
+
+static const char *fs_text =
+	"#version 150\n"
+	"out vec4 color;\n"
+	"void main() {\n"
+	"	color = vec4(1.0);\n"
+	"}\n";
+
+static void
+setup_buffers(void)
+{
+	GLuint vao, vbo, instance_vbo, ebo, prog;
+	float (*pos)[2] = malloc(MAX_VERTICES * sizeof(*pos));
+	GLuint *indices = malloc(MAX_VERTICES * sizeof(*indices));
+	static const float offsets[MAX_DRAWS][2];
+
+	for (unsigned i = 0; i < MAX_VERTICES; i++) {
+		pos[i][0] = i % 3 == 1 ? V1 : 0;
+		pos[i][1] = i % 3 == 2 ? V1 : 0;
+		indices[i] = i;
+	}
+
+	prog = glCreateProgram();
+	glAttachShader(prog, piglit_compile_shader_text(GL_VERTEX_SHADER,
+							vs_text));
+	glAttachShader(prog, piglit_compile_shader_text(GL_FRAGMENT_SHADER,
+							fs_text));
+	glBindAttribLocation(prog, 0, "pos");
+	glBindAttribLocation(prog, 1, "offset");
+	glLinkProgram(prog);
+	if (!piglit_link_check_status(prog))
+		piglit_report_result(PIGLIT_FAIL);
+	glUseProgram(prog);
+
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, MAX_VERTICES * sizeof(*pos), pos,
+		     GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, NULL);
+	glEnableVertexAttribArray(0);
+
+	glGenBuffers(1, &instance_vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(offsets), offsets,
+		     GL_STATIC_DRAW);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, NULL);
+	glVertexAttribDivisor(1, 1);
+	glEnableVertexAttribArray(1);
+
+	glGenBuffers(1, &ebo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, MAX_VERTICES * sizeof(*indices),
+		     indices, GL_STATIC_DRAW);
+
+	if (has_indirect) {
+		glGenBuffers(1, &indirect_buf);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buf);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER,
+			     MAX_DRAWS * (sizeof(struct arrays_cmd) +
+					  sizeof(struct elements_cmd)),
+			     NULL, GL_STATIC_DRAW);
+	}
+	if (has_indirect_count) {
+		glGenBuffers(1, &param_buf);
+		glBindBuffer(GL_PARAMETER_BUFFER_ARB, param_buf);
+		glBufferData(GL_PARAMETER_BUFFER_ARB, sizeof(GLuint), NULL,
+			     GL_STATIC_DRAW);
+	}
+
+	free(pos);
+	free(indices);
+}
+
+/**
+ * Fill the draw parameters for the current draw count and primitive
+ * count. Draw i uses its own range of vertices.
+ */
+static void
+setup_draws(void)
+{
+	struct arrays_cmd arrays[MAX_DRAWS];
+	struct elements_cmd elements[MAX_DRAWS];
+	unsigned verts = prims_per_draw * 3;
+
+	for (unsigned i = 0; i < draw_count; i++) {
+		firsts[i] = i * verts;
+		counts[i] = verts;
+		base_vertices[i] = i * verts;
+		index_offsets[i] = (void *)(intptr_t)(i * verts * sizeof(GLuint));
+		zero_offsets[i] = NULL;
+
+		arrays[i].count = verts;
+		arrays[i].instance_count = 1;
+		arrays[i].first = i * verts;
+		arrays[i].base_instance = has_base_instance ? i : 0;
+
+		elements[i].count = verts;
+		elements[i].instance_count = 1;
+		elements[i].first_index = 0;
+		elements[i].base_vertex = i * verts;
+		elements[i].base_instance = has_base_instance ? i : 0;
+	}
+
+	if (has_indirect) {
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0,
+				draw_count * sizeof(arrays[0]), arrays);
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, ELEMENTS_CMD_OFFSET,
+				draw_count * sizeof(elements[0]), elements);
+	}
+	if (has_indirect_count) {
+		GLuint count = draw_count;
+		glBufferSubData(GL_PARAMETER_BUFFER_ARB, 0, sizeof(count),
+				&count);
+	}
+}
+
+static void
+draw_arrays(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		for (unsigned j = 0; j < draw_count; j++)
+			glDrawArrays(GL_TRIANGLES, firsts[j], counts[j]);
+	}
+}
+
+static void
+draw_elements(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		for (unsigned j = 0; j < draw_count; j++) {
+			glDrawElements(GL_TRIANGLES, counts[j],
+				       GL_UNSIGNED_INT, index_offsets[j]);
+		}
+	}
+}
+
+static void
+draw_elements_base_vertex(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		for (unsigned j = 0; j < draw_count; j++) {
+			glDrawElementsBaseVertex(GL_TRIANGLES, counts[j],
+						 GL_UNSIGNED_INT, NULL,
+						 base_vertices[j]);
+		}
+	}
+}
+
+static void
+draw_arrays_indirect(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		for (unsigned j = 0; j < draw_count; j++) {
+			glDrawArraysIndirect(GL_TRIANGLES, (void *)(intptr_t)
+					     (j * sizeof(struct arrays_cmd)));
+		}
+	}
+}
+
+static void
+draw_elements_indirect(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		for (unsigned j = 0; j < draw_count; j++) {
+			glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+					       (void *)(intptr_t)
+					       (ELEMENTS_CMD_OFFSET +
+						j * sizeof(struct elements_cmd)));
+		}
+	}
+}
+
+static void
+multi_draw_arrays(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++)
+		glMultiDrawArrays(GL_TRIANGLES, firsts, counts, draw_count);
+}
+
+static void
+multi_draw_elements(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		glMultiDrawElements(GL_TRIANGLES, counts, GL_UNSIGNED_INT,
+				    index_offsets, draw_count);
+	}
+}
+
+static void
+multi_draw_elements_base_vertex(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts,
+					      GL_UNSIGNED_INT, zero_offsets,
+					      draw_count, base_vertices);
+	}
+}
+
+static void
+multi_draw_arrays_indirect(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++)
+		glMultiDrawArraysIndirect(GL_TRIANGLES, NULL, draw_count, 0);
+}
+
+static void
+multi_draw_elements_indirect(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+					    (void *)ELEMENTS_CMD_OFFSET,
+					    draw_count, 0);
+	}
+}
+
+static void
+multi_draw_arrays_indirect_count(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		glMultiDrawArraysIndirectCountARB(GL_TRIANGLES, 0, 0,
+						  draw_count, 0);
+	}
+}
+
+static void
+multi_draw_elements_indirect_count(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		glMultiDrawElementsIndirectCountARB(GL_TRIANGLES,
+						    GL_UNSIGNED_INT,
+						    (void *)ELEMENTS_CMD_OFFSET,
+						    0,
+						    draw_count, 0);
+	}
+}
+
+/**
+ * Measure one draw method. Every iteration of \p f issues draw_count
+ * draws, either as separate calls or as one multi-draw call. Returns
+ * draws per second.
+ */
+static double
+perf_run(const char *call, perf_rate_func f, bool supported,
+	 double base_rate)
+{
+	static unsigned test_index;
+	test_index++;
+
+	if (selected_test_index != -1 && test_index != selected_test_index)
+		return 0;
+
+	if (!supported) {
+		printf(" %3u, %-34s (%4u draws x %3u prims) not supported\n",
+		       test_index, call, draw_count, prims_per_draw);
+		return 0;
+	}
+
+	double rate = perf_measure_cpu_rate(f, duration) * draw_count;
+	double ratio = base_rate ? rate / base_rate : 1;
+
+	const char *ratio_color = base_rate == 0 ? COLOR_RESET :
+		ratio > 0.7 ? COLOR_GREEN :
+		ratio > 0.4 ? COLOR_YELLOW : COLOR_RED;
+
+	printf(" %3u, %-34s (%4u draws x %3u prims), %s%9u%s, %9.1f, %s%.1f%%%s\n",
+	       test_index, call, draw_count, prims_per_draw,
+	       color ? COLOR_CYAN : "",
+	       (unsigned)(rate / 1000),
+	       color ? COLOR_RESET : "",
+	       rate * prims_per_draw / 1000000,
+	       color ? ratio_color : "",
+	       100 * ratio,
+	       color ? COLOR_RESET : "");
+	return rate;
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	static const unsigned draw_counts[] = {1, 16, 256, MAX_DRAWS};
+	static const unsigned prim_counts[] = {1, 32, MAX_PRIMS};
+
+	has_indirect = piglit_get_gl_version() >= 43 ||
+		piglit_is_extension_supported("GL_ARB_multi_draw_indirect");
+	has_base_instance = piglit_get_gl_version() >= 42 ||
+		piglit_is_extension_supported("GL_ARB_base_instance");
+	has_indirect_count = has_indirect &&
+		piglit_is_extension_supported("GL_ARB_indirect_parameters");
+
+	setup_buffers();
+
+	puts("   #, Draw method                          (draws  x  prims),  Kdraws/s, Mprims/s, Difference vs single draws");
+
+	for (unsigned d = 0; d < ARRAY_SIZE(draw_counts); d++) {
+		for (unsigned p = 0; p < ARRAY_SIZE(prim_counts); p++) {
+			double arrays_rate, elements_rate;
+
+			draw_count = draw_counts[d];
+			prims_per_draw = prim_counts[p];
+			setup_draws();
+
+			arrays_rate = perf_run("DrawArrays", draw_arrays,
+					       true, 0);
+			perf_run("DrawArraysIndirect", draw_arrays_indirect,
+				 has_indirect, arrays_rate);
+			perf_run("MultiDrawArrays", multi_draw_arrays,
+				 true, arrays_rate);
+			perf_run("MultiDrawArraysIndirect",
+				 multi_draw_arrays_indirect, has_indirect,
+				 arrays_rate);
+			perf_run("MultiDrawArraysIndirectCount",
+				 multi_draw_arrays_indirect_count,
+				 has_indirect_count, arrays_rate);
+
+			elements_rate = perf_run("DrawElements", draw_elements,
+						 true, 0);
+			perf_run("DrawElementsBaseVertex",
+				 draw_elements_base_vertex, true,
+				 elements_rate);
+			perf_run("DrawElementsIndirect",
+				 draw_elements_indirect, has_indirect,
+				 elements_rate);
+			perf_run("MultiDrawElements", multi_draw_elements,
+				 true, elements_rate);
+			perf_run("MultiDrawElementsBaseVertex",
+				 multi_draw_elements_base_vertex, true,
+				 elements_rate);
+			perf_run("MultiDrawElementsIndirect",
+				 multi_draw_elements_indirect, has_indirect,
+				 elements_rate);
+			perf_run("MultiDrawElementsIndirectCount",
+				 multi_draw_elements_indirect_count,
+				 has_indirect_count, elements_rate);
+		}
+	}
+
+	exit(0);
+}
+
+/** Called from test harness/main */
+enum piglit_result
+piglit_display(void)
+{
+	return PIGLIT_FAIL;
+}
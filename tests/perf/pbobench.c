@@ -25,6 +25,7 @@
  */
 
 #include "common.h"
+#include "formats.h"
 #include <stdbool.h>
 #include "piglit-util-gl.h"
 
@@ -72,153 +73,6 @@ PIGLIT_GL_TEST_CONFIG_BEGIN
 
 PIGLIT_GL_TEST_CONFIG_END
 
-typedef struct Format {
-   GLenum internal_format;
-   GLenum format;
-   GLenum type;
-} Format;
-
-static const Format format_es[] = {
-	{GL_RGBA8,				GL_RGBA,			GL_UNSIGNED_BYTE},
-	{GL_RGB5_A1,			GL_RGBA,			GL_UNSIGNED_BYTE},
-	{GL_RGBA4,				GL_RGBA,			GL_UNSIGNED_BYTE},
-	{GL_SRGB8_ALPHA8,		GL_RGBA,			GL_UNSIGNED_BYTE},
-	{GL_RGBA8_SNORM,		GL_RGBA,			GL_BYTE},
-	{GL_RGBA4,				GL_RGBA,			GL_UNSIGNED_SHORT_4_4_4_4},
-	{GL_RGB5_A1,			GL_RGBA,			GL_UNSIGNED_SHORT_5_5_5_1},
-	{GL_RGB10_A2,			GL_RGBA,			GL_UNSIGNED_INT_2_10_10_10_REV},
-	{GL_RGB5_A1,			GL_RGBA,			GL_UNSIGNED_INT_2_10_10_10_REV},
-	{GL_RGBA16F,			GL_RGBA,			GL_HALF_FLOAT},
-	{GL_RGBA32F,			GL_RGBA,			GL_FLOAT},
-	{GL_RGBA16F,			GL_RGBA,			GL_FLOAT},
-	{GL_RGB8,				GL_RGB,			GL_UNSIGNED_BYTE},
-	{GL_RGB565,			GL_RGB,			GL_UNSIGNED_BYTE},
-	{GL_SRGB8,				GL_RGB,			GL_UNSIGNED_BYTE},
-	{GL_RGB8_SNORM,		GL_RGB,			GL_BYTE},
-	{GL_RGB565,			GL_RGB,			GL_UNSIGNED_SHORT_5_6_5},
-	{GL_R11F_G11F_B10F,	GL_RGB,			GL_UNSIGNED_INT_10F_11F_11F_REV},
-	{GL_R11F_G11F_B10F,	GL_RGB,			GL_HALF_FLOAT},
-	{GL_R11F_G11F_B10F,	GL_RGB,			GL_FLOAT},
-	{GL_RGB9_E5,			GL_RGB,			GL_UNSIGNED_INT_5_9_9_9_REV},
-	{GL_RGB9_E5,			GL_RGB,			GL_HALF_FLOAT},
-	{GL_RGB9_E5,			GL_RGB,			GL_FLOAT},
-	{GL_RGB16F,			GL_RGB,			GL_HALF_FLOAT},
-	{GL_RGB32F,			GL_RGB,			GL_FLOAT},
-	{GL_RGB16F,			GL_RGB,			GL_FLOAT},
-	{GL_RG8,				GL_RG,				GL_UNSIGNED_BYTE},
-	{GL_RG8_SNORM,			GL_RG,				GL_BYTE},
-	{GL_RG16F,				GL_RG,				GL_HALF_FLOAT},
-	{GL_RG32F,				GL_RG,				GL_FLOAT},
-	{GL_RG16F,				GL_RG,				GL_FLOAT},
-	{GL_R8,				GL_RED,			GL_UNSIGNED_BYTE},
-	{GL_R8_SNORM,			GL_RED,			GL_BYTE},
-	{GL_R16F,				GL_RED,			GL_HALF_FLOAT},
-	{GL_R32F,				GL_RED,			GL_FLOAT},
-	{GL_R16F,				GL_RED,			GL_FLOAT},
-	{GL_RGBA,				GL_RGBA,			GL_UNSIGNED_BYTE},
-	{GL_RGBA,				GL_RGBA,			GL_UNSIGNED_SHORT_4_4_4_4},
-	{GL_RGBA,				GL_RGBA,			GL_UNSIGNED_SHORT_5_5_5_1},
-	{GL_RGB,				GL_RGB,			GL_UNSIGNED_BYTE},
-	{GL_RGB,				GL_RGB,			GL_UNSIGNED_SHORT_5_6_5},
-	{GL_LUMINANCE_ALPHA,	GL_LUMINANCE_ALPHA,GL_UNSIGNED_BYTE},
-	{GL_LUMINANCE,			GL_LUMINANCE,		GL_UNSIGNED_BYTE},
-	{GL_ALPHA,				GL_ALPHA,			GL_UNSIGNED_BYTE}
-};
-
-static const Format format_es_int[] = {
-	{GL_RGBA8UI,			GL_RGBA_INTEGER,	GL_UNSIGNED_BYTE},
-	{GL_RGBA8I,			GL_RGBA_INTEGER,	GL_BYTE},
-	{GL_RGBA16UI,			GL_RGBA_INTEGER,	GL_UNSIGNED_SHORT},
-	{GL_RGBA16I,			GL_RGBA_INTEGER,	GL_SHORT},
-	{GL_RGBA32UI,			GL_RGBA_INTEGER,	GL_UNSIGNED_INT},
-	{GL_RGBA32I,			GL_RGBA_INTEGER,	GL_INT},
-	{GL_RGB10_A2UI,		GL_RGBA_INTEGER,	GL_UNSIGNED_INT_2_10_10_10_REV},
-	{GL_RGB8UI,			GL_RGB_INTEGER,	GL_UNSIGNED_BYTE},
-	{GL_RGB8I,				GL_RGB_INTEGER,	GL_BYTE},
-	{GL_RGB16UI,			GL_RGB_INTEGER,	GL_UNSIGNED_SHORT},
-	{GL_RGB16I,			GL_RGB_INTEGER,	GL_SHORT},
-	{GL_RGB32UI,			GL_RGB_INTEGER,	GL_UNSIGNED_INT},
-	{GL_RGB32I,			GL_RGB_INTEGER,	GL_INT},
-	{GL_RG8UI,				GL_RG_INTEGER,		GL_UNSIGNED_BYTE},
-	{GL_RG8I,				GL_RG_INTEGER,		GL_BYTE},
-	{GL_RG16UI,			GL_RG_INTEGER,		GL_UNSIGNED_SHORT},
-	{GL_RG16I,				GL_RG_INTEGER,		GL_SHORT},
-	{GL_RG32UI,			GL_RG_INTEGER,		GL_UNSIGNED_INT},
-	{GL_RG32I,				GL_RG_INTEGER,		GL_INT},
-	{GL_R8UI,				GL_RED_INTEGER,	GL_UNSIGNED_BYTE},
-	{GL_R8I,				GL_RED_INTEGER,	GL_BYTE},
-	{GL_R16UI,				GL_RED_INTEGER,	GL_UNSIGNED_SHORT},
-	{GL_R16I,				GL_RED_INTEGER,	GL_SHORT},
-	{GL_R32UI,				GL_RED_INTEGER,	GL_UNSIGNED_INT},
-	{GL_R32I,				GL_RED_INTEGER,	GL_INT},
-	{GL_DEPTH_COMPONENT24,GL_DEPTH_COMPONENT,GL_UNSIGNED_INT},
-	{GL_DEPTH_COMPONENT16,GL_DEPTH_COMPONENT,GL_UNSIGNED_INT},
-	{GL_DEPTH_COMPONENT16,GL_DEPTH_COMPONENT,GL_UNSIGNED_SHORT},
-	{GL_DEPTH_COMPONENT32F,GL_DEPTH_COMPONENT,GL_FLOAT},
-	{GL_DEPTH24_STENCIL8,GL_DEPTH_STENCIL,	GL_UNSIGNED_INT_24_8},
-	{GL_DEPTH32F_STENCIL8,GL_DEPTH_STENCIL,	GL_FLOAT_32_UNSIGNED_INT_24_8_REV},
-};
-
-static const Format format_core[] = {
-	{GL_RGB,			GL_RGB,			GL_UNSIGNED_BYTE_3_3_2},
-	{GL_RGB,			GL_RGB,			GL_UNSIGNED_BYTE_2_3_3_REV},
-	{GL_RGB,			GL_RGB,			GL_UNSIGNED_SHORT_5_6_5},
-	{GL_RGB,			GL_RGB,			GL_UNSIGNED_SHORT_5_6_5_REV},
-	{GL_RGB,			GL_RGB,			GL_UNSIGNED_INT_10F_11F_11F_REV},
-	{GL_RGB,			GL_RGB,			GL_UNSIGNED_INT_5_9_9_9_REV},
-	{GL_RGBA,			GL_RGBA,		GL_UNSIGNED_SHORT_4_4_4_4},
-	{GL_RGBA,			GL_RGBA,		GL_UNSIGNED_SHORT_4_4_4_4_REV},
-	{GL_BGRA,			GL_BGRA,		GL_UNSIGNED_SHORT_4_4_4_4_REV},
-	{GL_BGRA,			GL_BGRA,		GL_UNSIGNED_SHORT_4_4_4_4},
-	{GL_RGBA,			GL_RGBA,		GL_UNSIGNED_SHORT_5_5_5_1},
-	{GL_BGRA,			GL_BGRA,		GL_UNSIGNED_SHORT_5_5_5_1},
-	{GL_RGBA,			GL_RGBA,		GL_UNSIGNED_SHORT_1_5_5_5_REV},
-	{GL_BGRA,			GL_BGRA,		GL_UNSIGNED_SHORT_1_5_5_5_REV},
-	{GL_RGBA,			GL_RGBA,		GL_UNSIGNED_INT_8_8_8_8},
-	{GL_BGRA,			GL_BGRA,		GL_UNSIGNED_INT_8_8_8_8},
-	{GL_RGBA,			GL_RGBA,		GL_UNSIGNED_INT_8_8_8_8_REV},
-	{GL_BGRA,			GL_BGRA,		GL_UNSIGNED_INT_8_8_8_8_REV},
-	{GL_RGBA,			GL_RGBA,		GL_UNSIGNED_INT_10_10_10_2},
-	{GL_BGRA,			GL_BGRA,		GL_UNSIGNED_INT_10_10_10_2},
-	{GL_RGBA,			GL_RGBA,		GL_UNSIGNED_INT_2_10_10_10_REV},
-	{GL_BGRA,			GL_BGRA,		GL_UNSIGNED_INT_2_10_10_10_REV},
-};
-
-static const Format format_core_int[] = {
-	{GL_RGB_INTEGER,	GL_RGB_INTEGER,GL_UNSIGNED_BYTE_3_3_2},
-	{GL_RGB_INTEGER,	GL_RGB_INTEGER,GL_UNSIGNED_BYTE_2_3_3_REV},
-	{GL_RGB_INTEGER,	GL_RGB_INTEGER,GL_UNSIGNED_SHORT_5_6_5},
-	{GL_RGB_INTEGER,	GL_RGB_INTEGER,GL_UNSIGNED_SHORT_5_6_5_REV},
-	{GL_RGBA_INTEGER,	GL_RGBA_INTEGER,GL_UNSIGNED_SHORT_4_4_4_4},
-	{GL_RGBA_INTEGER,	GL_RGBA_INTEGER,GL_UNSIGNED_SHORT_4_4_4_4_REV},
-	{GL_BGRA_INTEGER,	GL_BGRA_INTEGER,GL_UNSIGNED_SHORT_4_4_4_4_REV},
-	{GL_BGRA_INTEGER,	GL_BGRA_INTEGER,GL_UNSIGNED_SHORT_4_4_4_4},
-	{GL_RGBA_INTEGER,GL_RGBA_INTEGER,GL_UNSIGNED_SHORT_5_5_5_1},
-	{GL_BGRA_INTEGER,GL_BGRA_INTEGER,GL_UNSIGNED_SHORT_5_5_5_1},
-	{GL_RGBA_INTEGER,GL_RGBA_INTEGER,GL_UNSIGNED_SHORT_1_5_5_5_REV},
-	{GL_BGRA_INTEGER,GL_BGRA_INTEGER,GL_UNSIGNED_SHORT_1_5_5_5_REV},
-	{GL_RGBA_INTEGER,GL_RGBA_INTEGER,GL_UNSIGNED_INT_8_8_8_8},
-	{GL_BGRA_INTEGER,GL_BGRA_INTEGER,GL_UNSIGNED_INT_8_8_8_8},
-	{GL_RGBA_INTEGER,GL_RGBA_INTEGER,GL_UNSIGNED_INT_8_8_8_8_REV},
-	{GL_BGRA_INTEGER,GL_BGRA_INTEGER,GL_UNSIGNED_INT_8_8_8_8_REV},
-	{GL_RGBA_INTEGER,GL_RGBA_INTEGER,GL_UNSIGNED_INT_10_10_10_2},
-	{GL_BGRA_INTEGER,GL_BGRA_INTEGER,GL_UNSIGNED_INT_10_10_10_2},
-	{GL_RGBA_INTEGER,GL_RGBA_INTEGER,GL_UNSIGNED_INT_2_10_10_10_REV},
-	{GL_BGRA_INTEGER,GL_BGRA_INTEGER,GL_UNSIGNED_INT_2_10_10_10_REV},
-	{GL_DEPTH_STENCIL,GL_DEPTH_STENCIL,GL_UNSIGNED_INT_24_8},
-	{GL_DEPTH_STENCIL,GL_DEPTH_STENCIL,GL_FLOAT_32_UNSIGNED_INT_24_8_REV}
-};
-
-static const Format formats_EXT_texture_type_2_10_10_10_REV[] = {
-	{GL_RGBA,GL_RGBA,GL_UNSIGNED_INT_2_10_10_10_REV_EXT},
-	{GL_RGB,GL_RGB,GL_UNSIGNED_INT_2_10_10_10_REV_EXT}
-};
-
-static const Format formats_OES_required_internalformat[] = {
-	{GL_RGB8_OES,GL_RGB,GL_UNSIGNED_INT_2_10_10_10_REV_EXT},
-	{GL_RGB565,GL_RGB,GL_UNSIGNED_INT_2_10_10_10_REV_EXT}
-};
-
 const static Format *cur_format;
 static uint32_t *readpixels;
 static unsigned width, height, xoffset;
@@ -278,7 +132,7 @@ perf_pbo_variant(void)
    double base_rate[12];
    const Format *r32f = NULL;
 
-   for (unsigned i = 0; i < ARRAY_SIZE(format_es); i++) {
+   for (unsigned i = 0; i < num_format_es; i++) {
       if (format_es[i].internal_format == GL_R32F) {
          r32f = &format_es[i];
          break;
@@ -291,7 +145,7 @@ perf_pbo_variant(void)
       xoffset = 0;
       cur_format = r32f;
       base_rate[pot] = perf_run(pbo_download, 0);
-      for (unsigned i = 0; i < ARRAY_SIZE(format_es); i++) {
+      for (unsigned i = 0; i < num_format_es; i++) {
          cur_format = &format_es[i];
          if (cur_format == r32f)
             continue;
@@ -0,0 +1,605 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Measure shader compile and link latency over the shader_test and
+ * glslparsertest corpus.
+ *
+ * The GLSL sections are extracted from each .shader_test file using the
+ * same section names as shader_runner, while glslparsertest files
+ * (.vert, .tesc, .tese, .geom, .frag, .comp) are compiled as a single
+ * stage. Every program is compiled and linked N times serially, N times
+ * in flight at once with KHR_parallel_shader_compile, and reloaded N
+ * times with glProgramBinary. A comment with the iteration number is
+ * prepended to every source so that the driver's shader cache doesn't
+ * short-circuit the compiles.
+ *
+ * Files that fail to compile or link in the current context (missing
+ * extensions, expected compile failures, ...) are skipped.
+ *
+ * Usage: shader-compile [-core] [-iterations N] [-list FILE] [-quiet]
+ *                       [FILES...]
+ */
+
+#include <stdbool.h>
+#include "piglit-util-gl.h"
+#include "../shaders/parser_utils.h"
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 10;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-core")) {
+			config.supports_gl_compat_version = 0;
+			config.supports_gl_core_version = 32;
+		}
+	}
+
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+PIGLIT_GL_TEST_CONFIG_END
+
+#define MAX_STAGES 6
+
+enum mode {
+	MODE_SERIAL,
+	MODE_PARALLEL,
+	MODE_BINARY,
+	NUM_MODES,
+};
+
+static const char *mode_names[NUM_MODES] = {
+	"serial",
+	"parallel",
+	"binary",
+};
+
+struct stage_source {
+	GLenum type;
+	const char *src;
+	int len;
+};
+
+struct program_source {
+	const char *filename;
+	char *text;
+	unsigned num_stages;
+	struct stage_source stages[MAX_STAGES];
+	/* glslparsertest files are only compiled, not linked. */
+	bool link;
+};
+
+struct shader_result {
+	const char *filename;
+	/* Median latency of each mode in milliseconds, or < 0 if the mode
+	 * wasn't measured. */
+	double ms[NUM_MODES];
+};
+
+static const char passthrough_vertex_shader_source[] =
+	"#if __VERSION__ >= 130\n"
+	"in vec4 piglit_vertex;\n"
+	"#else\n"
+	"attribute vec4 piglit_vertex;\n"
+	"#endif\n"
+	"void main() { gl_Position = piglit_vertex; }\n"
+	;
+
+static unsigned iterations = 10;
+static bool quiet;
+static bool has_parallel, has_binary;
+
+/* Incremented for every compile so that each source is unique. */
+static unsigned bust_counter;
+
+static const struct {
+	const char *section;
+	GLenum type;
+} sections[] = {
+	{ "[vertex shader]", GL_VERTEX_SHADER },
+	{ "[tessellation control shader]", GL_TESS_CONTROL_SHADER },
+	{ "[tessellation evaluation shader]", GL_TESS_EVALUATION_SHADER },
+	{ "[geometry shader]", GL_GEOMETRY_SHADER },
+	{ "[fragment shader]", GL_FRAGMENT_SHADER },
+	{ "[compute shader]", GL_COMPUTE_SHADER },
+};
+
+static const struct {
+	const char *suffix;
+	GLenum type;
+} parser_test_suffixes[] = {
+	{ ".vert", GL_VERTEX_SHADER },
+	{ ".tesc", GL_TESS_CONTROL_SHADER },
+	{ ".tese", GL_TESS_EVALUATION_SHADER },
+	{ ".geom", GL_GEOMETRY_SHADER },
+	{ ".frag", GL_FRAGMENT_SHADER },
+	{ ".comp", GL_COMPUTE_SHADER },
+};
+
+static bool
+has_suffix(const char *s, const char *suffix)
+{
+	size_t len = strlen(s), suffix_len = strlen(suffix);
+
+	return len >= suffix_len && !strcmp(s + len - suffix_len, suffix);
+}
+
+static void
+add_stage(struct program_source *p, GLenum type, const char *start,
+	  const char *end)
+{
+	if (p->num_stages == MAX_STAGES)
+		return;
+
+	p->stages[p->num_stages].type = type;
+	p->stages[p->num_stages].src = start;
+	p->stages[p->num_stages].len = end - start;
+	p->num_stages++;
+}
+
+/**
+ * Split a shader_test into its GLSL stages. Returns false if the test
+ * uses something that can't be compiled on its own, like SPIR-V, ARB
+ * assembly programs or shader includes.
+ */
+static bool
+load_shader_test(struct program_source *p)
+{
+	const char *line = p->text;
+	const char *section_start = NULL;
+	GLenum section_type = GL_NONE;
+
+	p->link = true;
+
+	while (line[0] != '\0') {
+		if (line[0] == '[') {
+			if (section_start)
+				add_stage(p, section_type, section_start, line);
+			section_start = NULL;
+
+			if (parse_str(line, "[test]", NULL))
+				return p->num_stages > 0;
+
+			if (parse_str(line, "[vertex shader passthrough]", NULL)) {
+				const char *src = passthrough_vertex_shader_source;
+
+				add_stage(p, GL_VERTEX_SHADER, src,
+					  src + strlen(src));
+			} else if (parse_str(line, "[vertex program]", NULL) ||
+				   parse_str(line, "[fragment program]", NULL) ||
+				   parse_str(line, "[shader include]", NULL)) {
+				return false;
+			}
+
+			for (unsigned i = 0; i < ARRAY_SIZE(sections); i++) {
+				if (parse_str(line, sections[i].section, NULL)) {
+					section_type = sections[i].type;
+					section_start = strchrnul(line, '\n');
+					if (section_start[0] != '\0')
+						section_start++;
+				}
+			}
+		}
+
+		line = strchrnul(line, '\n');
+		if (line[0] != '\0')
+			line++;
+	}
+
+	if (section_start)
+		add_stage(p, section_type, section_start, line);
+
+	return p->num_stages > 0;
+}
+
+/**
+ * A glslparsertest file is a single shader with a config block in a
+ * comment. Tests that are expected to fail compilation are skipped.
+ */
+static bool
+load_parser_test(struct program_source *p, GLenum type)
+{
+	const char *expect = strstr(p->text, "expect_result:");
+
+	if (expect) {
+		const char *word;
+
+		parse_word(expect + strlen("expect_result:"), &word, NULL);
+		if (strncmp(word, "pass", 4) != 0)
+			return false;
+	}
+
+	p->link = false;
+	add_stage(p, type, p->text, p->text + strlen(p->text));
+	return true;
+}
+
+static bool
+load_program(struct program_source *p, const char *filename)
+{
+	unsigned size;
+
+	memset(p, 0, sizeof(*p));
+	p->filename = filename;
+	p->text = piglit_load_text_file(filename, &size);
+	if (!p->text) {
+		fprintf(stderr, "could not read file \"%s\"\n", filename);
+		return false;
+	}
+
+	if (has_suffix(filename, ".shader_test"))
+		return load_shader_test(p);
+
+	for (unsigned i = 0; i < ARRAY_SIZE(parser_test_suffixes); i++) {
+		if (has_suffix(filename, parser_test_suffixes[i].suffix))
+			return load_parser_test(p, parser_test_suffixes[i].type);
+	}
+
+	return false;
+}
+
+/**
+ * Start compiling (and linking) a program. Returns the program, or the
+ * shader for compile-only sources. The result isn't waited for.
+ */
+static GLuint
+start_compile(const struct program_source *p)
+{
+	char bust[64];
+	GLuint prog = 0;
+
+	snprintf(bust, sizeof(bust), "/* shader-compile %u */", bust_counter++);
+
+	if (p->link)
+		prog = glCreateProgram();
+
+	for (unsigned i = 0; i < p->num_stages; i++) {
+		const GLchar *strings[2] = { bust, p->stages[i].src };
+		const GLint lengths[2] = { -1, p->stages[i].len };
+		GLuint shader = glCreateShader(p->stages[i].type);
+
+		glShaderSource(shader, 2, strings, lengths);
+		glCompileShader(shader);
+
+		if (!p->link)
+			return shader;
+
+		glAttachShader(prog, shader);
+		glDeleteShader(shader);
+	}
+
+	glLinkProgram(prog);
+	return prog;
+}
+
+static bool
+finish_compile(const struct program_source *p, GLuint obj)
+{
+	GLint ok;
+
+	if (p->link) {
+		glGetProgramiv(obj, GL_LINK_STATUS, &ok);
+		glDeleteProgram(obj);
+	} else {
+		glGetShaderiv(obj, GL_COMPILE_STATUS, &ok);
+		glDeleteShader(obj);
+	}
+	return ok;
+}
+
+static bool
+is_complete(const struct program_source *p, GLuint obj)
+{
+	GLint done;
+
+	if (p->link)
+		glGetProgramiv(obj, GL_COMPLETION_STATUS_KHR, &done);
+	else
+		glGetShaderiv(obj, GL_COMPLETION_STATUS_KHR, &done);
+	return done;
+}
+
+static int
+cmp_double(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static double
+percentile(double *values, unsigned count, double p)
+{
+	qsort(values, count, sizeof(double), cmp_double);
+	return values[(unsigned)((count - 1) * p + 0.5)];
+}
+
+static double
+measure_serial(const struct program_source *p, double *times)
+{
+	for (unsigned i = 0; i < iterations; i++) {
+		int64_t start = piglit_time_get_nano();
+
+		if (!finish_compile(p, start_compile(p)))
+			return -1;
+
+		times[i] = (piglit_time_get_nano() - start) / 1000000.0;
+	}
+	return percentile(times, iterations, 0.5);
+}
+
+/**
+ * Put all iterations in flight at once and poll for completion. The
+ * reported latency is the total time divided by the number of
+ * iterations.
+ */
+static double
+measure_parallel(const struct program_source *p, GLuint *objs)
+{
+	int64_t start = piglit_time_get_nano();
+	unsigned remaining = iterations;
+	bool ok = true;
+
+	for (unsigned i = 0; i < iterations; i++)
+		objs[i] = start_compile(p);
+
+	while (remaining) {
+		for (unsigned i = 0; i < iterations; i++) {
+			if (objs[i] && is_complete(p, objs[i])) {
+				ok &= finish_compile(p, objs[i]);
+				objs[i] = 0;
+				remaining--;
+			}
+		}
+	}
+
+	if (!ok)
+		return -1;
+	return (piglit_time_get_nano() - start) / 1000000.0 / iterations;
+}
+
+static double
+measure_binary(const struct program_source *p, double *times)
+{
+	GLuint prog;
+	GLint length, ok;
+	GLenum format;
+	void *binary;
+
+	if (!p->link)
+		return -1;
+
+	prog = start_compile(p);
+	glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+	glGetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (!ok || length <= 0) {
+		glDeleteProgram(prog);
+		return -1;
+	}
+
+	binary = malloc(length);
+	glGetProgramBinary(prog, length, NULL, &format, binary);
+	glDeleteProgram(prog);
+
+	for (unsigned i = 0; i < iterations; i++) {
+		int64_t start = piglit_time_get_nano();
+
+		prog = glCreateProgram();
+		glProgramBinary(prog, format, binary, length);
+		glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+		glDeleteProgram(prog);
+
+		times[i] = (piglit_time_get_nano() - start) / 1000000.0;
+		if (!ok) {
+			free(binary);
+			return -1;
+		}
+	}
+
+	free(binary);
+	return percentile(times, iterations, 0.5);
+}
+
+static bool
+measure(const char *filename, struct shader_result *r)
+{
+	struct program_source p;
+	double *times;
+	GLuint *objs;
+
+	r->filename = filename;
+	for (unsigned m = 0; m < NUM_MODES; m++)
+		r->ms[m] = -1;
+
+	if (!load_program(&p, filename)) {
+		free(p.text);
+		return false;
+	}
+
+	times = malloc(iterations * sizeof(double));
+	objs = malloc(iterations * sizeof(GLuint));
+
+	if (has_parallel)
+		glMaxShaderCompilerThreadsKHR(0);
+	r->ms[MODE_SERIAL] = measure_serial(&p, times);
+
+	if (r->ms[MODE_SERIAL] >= 0 && has_parallel) {
+		glMaxShaderCompilerThreadsKHR(0xffffffff);
+		r->ms[MODE_PARALLEL] = measure_parallel(&p, objs);
+	}
+	if (r->ms[MODE_SERIAL] >= 0 && has_binary)
+		r->ms[MODE_BINARY] = measure_binary(&p, times);
+
+	free(times);
+	free(objs);
+	free(p.text);
+
+	/* Don't let a failed compile leak GL errors into the next file. */
+	while (glGetError() != GL_NO_ERROR)
+		;
+
+	return r->ms[MODE_SERIAL] >= 0;
+}
+
+static void
+add_file(char ***files, unsigned *num_files, const char *filename)
+{
+	*files = realloc(*files, (*num_files + 1) * sizeof(char *));
+	(*files)[(*num_files)++] = strdup(filename);
+}
+
+static void
+add_list(char ***files, unsigned *num_files, const char *list)
+{
+	char line[4096];
+	FILE *f = fopen(list, "r");
+
+	if (!f) {
+		fprintf(stderr, "could not read file \"%s\"\n", list);
+		piglit_report_result(PIGLIT_FAIL);
+	}
+
+	while (fgets(line, sizeof(line), f)) {
+		line[strcspn(line, "\r\n")] = '\0';
+		if (line[0] != '\0' && line[0] != '#')
+			add_file(files, num_files, line);
+	}
+	fclose(f);
+}
+
+static void
+print_percentiles(const struct shader_result *results, unsigned count)
+{
+	double *values = malloc(count * sizeof(double));
+
+	printf("\n%-10s %8s %10s %10s %10s %10s %10s\n", "mode", "shaders",
+	       "p50 ms", "p90 ms", "p99 ms", "max ms", "total s");
+
+	for (unsigned m = 0; m < NUM_MODES; m++) {
+		unsigned n = 0;
+		double total = 0;
+
+		for (unsigned i = 0; i < count; i++) {
+			if (results[i].ms[m] >= 0) {
+				values[n++] = results[i].ms[m];
+				total += results[i].ms[m];
+			}
+		}
+		if (!n)
+			continue;
+
+		printf("%-10s %8u %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+		       mode_names[m], n,
+		       percentile(values, n, 0.5),
+		       percentile(values, n, 0.9),
+		       percentile(values, n, 0.99),
+		       percentile(values, n, 1),
+		       total / 1000);
+	}
+
+	free(values);
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	struct shader_result *results;
+	char **files = NULL;
+	unsigned num_files = 0, num_measured = 0;
+	GLint num_formats = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-core")) {
+			continue;
+		} else if (!strcmp(argv[i], "-quiet")) {
+			quiet = true;
+		} else if (!strcmp(argv[i], "-iterations") && i + 1 < argc) {
+			iterations = MAX2(atoi(argv[++i]), 1);
+		} else if (!strcmp(argv[i], "-list") && i + 1 < argc) {
+			add_list(&files, &num_files, argv[++i]);
+		} else if (argv[i][0] == '-') {
+			fprintf(stderr, "shader-compile [-core] "
+				"[-iterations N] [-list FILE] [-quiet] "
+				"[FILES...]\n");
+			exit(1);
+		} else {
+			add_file(&files, &num_files, argv[i]);
+		}
+	}
+
+	if (!num_files) {
+		fprintf(stderr, "No shader files given\n");
+		exit(1);
+	}
+
+	has_parallel =
+		piglit_is_extension_supported("GL_KHR_parallel_shader_compile");
+	if (piglit_is_extension_supported("GL_ARB_get_program_binary"))
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+	has_binary = num_formats > 0;
+
+	printf("%u files, %u iterations, parallel compile: %s, "
+	       "program binary: %s\n", num_files, iterations,
+	       has_parallel ? "yes" : "no", has_binary ? "yes" : "no");
+
+	results = calloc(num_files, sizeof(*results));
+
+	if (!quiet)
+		printf("%10s %10s %10s  %s\n", "serial ms", "parallel ms",
+		       "binary ms", "file");
+
+	for (unsigned i = 0; i < num_files; i++) {
+		struct shader_result *r = &results[num_measured];
+
+		if (!measure(files[i], r))
+			continue;
+		num_measured++;
+
+		if (!quiet) {
+			for (unsigned m = 0; m < NUM_MODES; m++) {
+				if (r->ms[m] >= 0)
+					printf("%10.3f ", r->ms[m]);
+				else
+					printf("%10s ", "-");
+			}
+			printf(" %s\n", r->filename);
+		}
+	}
+
+	printf("\n%u of %u files measured, %u skipped\n", num_measured,
+	       num_files, num_files - num_measured);
+	if (num_measured)
+		print_percentiles(results, num_measured);
+
+	for (unsigned i = 0; i < num_files; i++)
+		free(files[i]);
+	free(files);
+	free(results);
+
+	exit(0);
+}
+
+/** Called from test harness/main */
+enum piglit_result
+piglit_display(void)
+{
+	return PIGLIT_FAIL;
+}
@@ -0,0 +1,374 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Measure the CPU-visible latency of fence and query round trips.
+ *
+ * Each test is sampled many times and reported as a min/median/p99
+ * distribution, both with an idle GPU and with a few full-screen passes of
+ * an expensive fragment shader queued (and flushed) before the measured
+ * operation. glFinish is included as a reference point for the loaded
+ * case.
+ *
+ * If the context was created through EGL, EGL_KHR_fence_sync round trips
+ * are measured too.
+ */
+
+#include "piglit-util-gl.h"
+#ifdef PIGLIT_HAS_EGL
+#include "piglit-util-egl.h"
+#endif
+
+static int selected_test_index = -1;
+static double duration = 1;
+static unsigned load_passes = 4;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_core_version = 32;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-test")) {
+			if (i == argc - 1) {
+				fprintf(stderr, "-test requires an argument\n");
+				exit(1);
+			}
+
+			const char *testnum = argv[i + 1];
+			char *endptr;
+			selected_test_index = strtol(testnum, &endptr, 10);
+
+			if (endptr != argv[i + 1] + strlen(testnum)) {
+				fprintf(stderr,
+					"Failed to parse test number '%s'\n", testnum);
+				exit(1);
+			}
+
+			printf("Running only test %d\n", selected_test_index);
+			i++;
+		}
+		if (!strcmp(argv[i], "-duration")) {
+			if (i == argc - 1) {
+				fprintf(stderr, "-duration requires an argument\n");
+				exit(1);
+			}
+
+			duration = strtod(argv[i + 1], NULL);
+			printf("Duration forced to %.2f seconds\n", duration);
+			i++;
+		}
+		if (!strcmp(argv[i], "-load")) {
+			if (i == argc - 1) {
+				fprintf(stderr, "-load requires an argument\n");
+				exit(1);
+			}
+
+			load_passes = strtoul(argv[i + 1], NULL, 10);
+			i++;
+		}
+
+		if (!strcmp(argv[i], "-help")) {
+			fprintf(stderr, "sync-latency [-test TESTNUM] "
+				"[-duration SECS] [-load PASSES]\n");
+			exit(1);
+		}
+	}
+
+	config.window_width = 512;
+	config.window_height = 512;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+PIGLIT_GL_TEST_CONFIG_END
+
+#define MIN_SAMPLES 10
+#define MAX_SAMPLES 100000
+
+/* Timeout for glClientWaitSync, to catch hangs. */
+#define WAIT_TIMEOUT_NS 10000000000ull
+
+/* Measure one round trip and return its duration in nanoseconds. */
+typedef int64_t (*latency_func)(void);
+
+static bool loaded;
+static GLuint load_prog, query;
+static int64_t *samples;
+
+static const char *load_vs =
+	"#version 150\n"
+	"in vec4 piglit_vertex;\n"
+	"void main() { gl_Position = piglit_vertex; }\n";
+
+static const char *load_fs =
+	"#version 150\n"
+	"out vec4 color;\n"
+	"void main() {\n"
+	"	vec4 c = gl_FragCoord;\n"
+	"	for (int i = 0; i < 64; i++)\n"
+	"		c = sin(c) * 1.0001 + c * 0.5;\n"
+	"	color = c;\n"
+	"}\n";
+
+/**
+ * Queue and flush the rendering load, so that the measured operation
+ * waits behind it.
+ */
+static void
+queue_load(void)
+{
+	if (!loaded)
+		return;
+
+	glUseProgram(load_prog);
+	for (unsigned i = 0; i < load_passes; i++)
+		piglit_draw_rect(-1, -1, 2, 2);
+	glFlush();
+}
+
+static int64_t
+finish(void)
+{
+	queue_load();
+
+	int64_t start = piglit_time_get_nano();
+	glFinish();
+	return piglit_time_get_nano() - start;
+}
+
+static int64_t
+fence_wait(void)
+{
+	queue_load();
+
+	int64_t start = piglit_time_get_nano();
+	GLsync sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	GLenum status = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT,
+					 WAIT_TIMEOUT_NS);
+	int64_t end = piglit_time_get_nano();
+
+	glDeleteSync(sync);
+	if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED)
+		piglit_report_result(PIGLIT_FAIL);
+	return end - start;
+}
+
+static int64_t
+fence_poll(void)
+{
+	queue_load();
+
+	int64_t start = piglit_time_get_nano();
+	GLsync sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	GLenum status = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+
+	while (status == GL_TIMEOUT_EXPIRED)
+		status = glClientWaitSync(sync, 0, 0);
+
+	int64_t end = piglit_time_get_nano();
+
+	glDeleteSync(sync);
+	if (status == GL_WAIT_FAILED)
+		piglit_report_result(PIGLIT_FAIL);
+	return end - start;
+}
+
+static int64_t
+timestamp_result(void)
+{
+	GLuint64 result;
+
+	queue_load();
+
+	int64_t start = piglit_time_get_nano();
+	glQueryCounter(query, GL_TIMESTAMP);
+	glGetQueryObjectui64v(query, GL_QUERY_RESULT, &result);
+	return piglit_time_get_nano() - start;
+}
+
+static int64_t
+time_elapsed_result(void)
+{
+	GLuint64 result;
+
+	queue_load();
+
+	int64_t start = piglit_time_get_nano();
+	glBeginQuery(GL_TIME_ELAPSED, query);
+	glEndQuery(GL_TIME_ELAPSED);
+	glGetQueryObjectui64v(query, GL_QUERY_RESULT, &result);
+	return piglit_time_get_nano() - start;
+}
+
+static int64_t
+timestamp_poll(void)
+{
+	GLuint available = 0;
+	GLuint64 result;
+
+	queue_load();
+
+	int64_t start = piglit_time_get_nano();
+	glQueryCounter(query, GL_TIMESTAMP);
+	glFlush();
+	while (!available)
+		glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE,
+				    &available);
+	glGetQueryObjectui64v(query, GL_QUERY_RESULT, &result);
+	return piglit_time_get_nano() - start;
+}
+
+#ifdef PIGLIT_HAS_EGL
+static EGLDisplay egl_dpy = EGL_NO_DISPLAY;
+static PFNEGLCREATESYNCKHRPROC peglCreateSyncKHR;
+static PFNEGLCLIENTWAITSYNCKHRPROC peglClientWaitSyncKHR;
+static PFNEGLDESTROYSYNCKHRPROC peglDestroySyncKHR;
+
+static bool
+init_egl_fence(void)
+{
+	egl_dpy = eglGetCurrentDisplay();
+	if (egl_dpy == EGL_NO_DISPLAY ||
+	    !piglit_is_egl_extension_supported(egl_dpy, "EGL_KHR_fence_sync"))
+		return false;
+
+	peglCreateSyncKHR = (PFNEGLCREATESYNCKHRPROC)
+		eglGetProcAddress("eglCreateSyncKHR");
+	peglClientWaitSyncKHR = (PFNEGLCLIENTWAITSYNCKHRPROC)
+		eglGetProcAddress("eglClientWaitSyncKHR");
+	peglDestroySyncKHR = (PFNEGLDESTROYSYNCKHRPROC)
+		eglGetProcAddress("eglDestroySyncKHR");
+
+	return peglCreateSyncKHR && peglClientWaitSyncKHR &&
+	       peglDestroySyncKHR;
+}
+
+static int64_t
+egl_fence_wait(void)
+{
+	queue_load();
+
+	int64_t start = piglit_time_get_nano();
+	EGLSyncKHR sync = peglCreateSyncKHR(egl_dpy, EGL_SYNC_FENCE_KHR,
+					    NULL);
+	EGLint status = peglClientWaitSyncKHR(egl_dpy, sync,
+					      EGL_SYNC_FLUSH_COMMANDS_BIT_KHR,
+					      WAIT_TIMEOUT_NS);
+	int64_t end = piglit_time_get_nano();
+
+	peglDestroySyncKHR(egl_dpy, sync);
+	if (status != EGL_CONDITION_SATISFIED_KHR)
+		piglit_report_result(PIGLIT_FAIL);
+	return end - start;
+}
+#endif
+
+static int
+cmp_int64(const void *a, const void *b)
+{
+	int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+
+	return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static void
+perf_run(const char *name, latency_func f, bool supported)
+{
+	static unsigned test_index;
+	test_index++;
+
+	if (selected_test_index != -1 && test_index != selected_test_index)
+		return;
+
+	if (!supported) {
+		printf(" %2u, %-45s %-6s, not supported\n",
+		       test_index, name, loaded ? "loaded" : "idle");
+		return;
+	}
+
+	/* Warm up and drain anything that is still queued. */
+	f();
+	glFinish();
+
+	int64_t end = piglit_time_get_nano() + (int64_t)(duration * 1e9);
+	unsigned n = 0;
+
+	while (n < MAX_SAMPLES &&
+	       (n < MIN_SAMPLES || piglit_time_get_nano() < end))
+		samples[n++] = f();
+
+	qsort(samples, n, sizeof(samples[0]), cmp_int64);
+
+	printf(" %2u, %-45s %-6s, %10.1f, %10.1f, %10.1f, %7u\n",
+	       test_index, name, loaded ? "loaded" : "idle",
+	       samples[0] / 1000.0,
+	       samples[n / 2] / 1000.0,
+	       samples[(unsigned)((n - 1) * 0.99)] / 1000.0,
+	       n);
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	bool has_timer_query = piglit_get_gl_version() >= 33 ||
+		piglit_is_extension_supported("GL_ARB_timer_query");
+	bool has_egl_fence = false;
+
+	load_prog = piglit_build_simple_program(load_vs, load_fs);
+	glGenQueries(1, &query);
+	samples = malloc(MAX_SAMPLES * sizeof(samples[0]));
+
+#ifdef PIGLIT_HAS_EGL
+	has_egl_fence = init_egl_fence();
+#endif
+
+	puts("  #, Test name                                     , GPU   ,     min us,  median us,     p99 us, samples");
+
+	for (loaded = false; ; loaded = true) {
+		perf_run("glFinish", finish, true);
+		perf_run("FenceSync -> ClientWaitSync", fence_wait, true);
+		perf_run("FenceSync -> ClientWaitSync(timeout 0) poll",
+			 fence_poll, true);
+		perf_run("QueryCounter -> GetQueryObject(RESULT)",
+			 timestamp_result, has_timer_query);
+		perf_run("TIME_ELAPSED -> GetQueryObject(RESULT)",
+			 time_elapsed_result, has_timer_query);
+		perf_run("QueryCounter -> RESULT_AVAILABLE poll",
+			 timestamp_poll, has_timer_query);
+		perf_run("eglCreateSyncKHR -> eglClientWaitSyncKHR",
+#ifdef PIGLIT_HAS_EGL
+			 egl_fence_wait,
+#else
+			 NULL,
+#endif
+			 has_egl_fence);
+
+		if (loaded)
+			break;
+	}
+
+	free(samples);
+	exit(0);
+}
+
+/** Called from test harness/main */
+enum piglit_result
+piglit_display(void)
+{
+	return PIGLIT_FAIL;
+}
@@ -0,0 +1,371 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Measure texture upload throughput.
+ *
+ * glTexSubImage2D/3D is swept over the format tables shared with
+ * pbobench, from client memory, from a PBO and from a persistently mapped
+ * PBO, for a few sizes and for aligned and unaligned source data. The
+ * result is reported in MB/s, along with the ratio against the client
+ * memory upload of the same combination.
+ */
+
+#include "common.h"
+#include "formats.h"
+#include <stdbool.h>
+#include "piglit-util-gl.h"
+
+static bool color = true;
+static bool gpu_time;
+static int selected_test_index = -1;
+static double duration = 0.5;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	/* Unsized and luminance/alpha formats are in the tables. */
+	config.supports_gl_compat_version = 30;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-nocolor")) {
+			color = false;
+		}
+		if (!strcmp(argv[i], "-gpu")) {
+			gpu_time = true;
+		}
+		if (!strcmp(argv[i], "-test")) {
+			if (i == argc - 1) {
+				fprintf(stderr, "-test requires an argument\n");
+				exit(1);
+			}
+
+			const char *testnum = argv[i + 1];
+			char *endptr;
+			selected_test_index = strtol(testnum, &endptr, 10);
+
+			if (endptr != argv[i + 1] + strlen(testnum)) {
+				fprintf(stderr,
+					"Failed to parse test number '%s'\n", testnum);
+				exit(1);
+			}
+
+			printf("Running only test %d\n", selected_test_index);
+			i++;
+		}
+		if (!strcmp(argv[i], "-duration")) {
+			if (i == argc - 1) {
+				fprintf(stderr, "-duration requires an argument\n");
+				exit(1);
+			}
+
+			duration = strtod(argv[i + 1], NULL);
+			printf("Duration forced to %.2f seconds\n", duration);
+			i++;
+		}
+
+		if (!strcmp(argv[i], "-help")) {
+			fprintf(stderr, "teximage [-test TESTNUM] [-duration SECS] "
+				"[-gpu] [-nocolor]\n");
+			exit(1);
+		}
+	}
+
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+PIGLIT_GL_TEST_CONFIG_END
+
+enum source {
+	SOURCE_CLIENT,
+	SOURCE_PBO,
+	SOURCE_PERSISTENT_PBO,
+	NUM_SOURCES
+};
+
+static const char *source_names[NUM_SOURCES] = {
+	"client",
+	"PBO",
+	"persistent PBO",
+};
+
+struct layout {
+	const char *name;
+	GLint alignment;
+	/* Subtracted from the width to get rows which aren't a multiple of
+	 * the pixel size. */
+	unsigned width_delta;
+	/* Offset of the source data from the start of the buffer. 8 is
+	 * valid for every type but isn't aligned to a cache line. */
+	unsigned offset;
+};
+
+static const struct layout layouts[] = {
+	{"aligned",	4, 0, 0},
+	{"unaligned",	1, 1, 8},
+};
+
+static const Format *cur_format;
+static const struct layout *cur_layout;
+static enum source cur_source;
+static GLenum cur_target;
+static unsigned width, height, depth;
+static GLuint tex, pbo, persistent_pbo;
+static uint8_t *client_data;
+static bool has_persistent;
+
+/* Enough for 1024x1024 and 128x128x128 RGBA32F, plus offsets. */
+#define BUF_LEN (32 * 1024 * 1024 + 4096)
+
+#define COLOR_RESET	"\033[0m"
+#define COLOR_RED	"\033[31m"
+#define COLOR_GREEN	"\033[1;32m"
+#define COLOR_YELLOW	"\033[1;33m"
+#define COLOR_CYAN	"\033[1;36m"
+
+static void
+upload(unsigned count)
+{
+	const void *src;
+	unsigned i;
+
+	if (cur_source == SOURCE_CLIENT)
+		src = client_data + cur_layout->offset;
+	else
+		src = (const void *)(uintptr_t)cur_layout->offset;
+
+	for (i = 0; i < count; i++) {
+		if (cur_target == GL_TEXTURE_3D) {
+			glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0,
+					width, height, depth,
+					cur_format->format, cur_format->type,
+					src);
+		} else {
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height,
+					cur_format->format, cur_format->type,
+					src);
+		}
+	}
+}
+
+/* Size of one upload in the source buffer, including row padding. */
+static unsigned
+image_size(void)
+{
+	unsigned row = width * perf_format_pixel_size(cur_format);
+
+	row = ALIGN(row, (unsigned)cur_layout->alignment);
+	return row * height * depth;
+}
+
+/**
+ * Allocate the texture for the current combination.
+ *
+ * Returns false if the driver doesn't support the combination.
+ */
+static bool
+setup_texture(void)
+{
+	/* Drain errors from previous combinations. */
+	while (glGetError() != GL_NO_ERROR)
+		;
+
+	if (tex)
+		glDeleteTextures(1, &tex);
+	glGenTextures(1, &tex);
+	glBindTexture(cur_target, tex);
+	glTexParameteri(cur_target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(cur_target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	if (cur_target == GL_TEXTURE_3D) {
+		glTexImage3D(GL_TEXTURE_3D, 0, cur_format->internal_format,
+			     width, height, depth, 0,
+			     cur_format->format, cur_format->type, NULL);
+	} else {
+		glTexImage2D(GL_TEXTURE_2D, 0, cur_format->internal_format,
+			     width, height, 0,
+			     cur_format->format, cur_format->type, NULL);
+	}
+
+	return glGetError() == GL_NO_ERROR;
+}
+
+static void
+setup_source(void)
+{
+	switch (cur_source) {
+	case SOURCE_CLIENT:
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		break;
+	case SOURCE_PBO:
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+		break;
+	case SOURCE_PERSISTENT_PBO:
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, persistent_pbo);
+		break;
+	default:
+		assert(0);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, cur_layout->alignment);
+}
+
+/**
+ * Measure the current combination. Unsupported combinations still take a
+ * test number, so that the numbers don't depend on the driver.
+ */
+static double
+perf_run(double base_rate, bool supported)
+{
+	static unsigned test_index;
+	test_index++;
+
+	if (selected_test_index != -1 && test_index != selected_test_index)
+		return 0;
+
+	if (!supported || image_size() + cur_layout->offset > BUF_LEN)
+		return 0;
+
+	setup_source();
+
+	/* Make sure the upload itself is valid before timing it. */
+	upload(1);
+	if (glGetError() != GL_NO_ERROR)
+		return 0;
+
+	double rate = gpu_time ? perf_measure_gpu_rate(upload, duration) :
+				 perf_measure_cpu_rate(upload, duration);
+	double mbps = rate * width * height * depth *
+		      perf_format_pixel_size(cur_format) / 1000000.0;
+	double ratio = base_rate ? rate / base_rate : 1;
+
+	const char *ratio_color = base_rate == 0 ? COLOR_RESET :
+		ratio > 0.7 ? COLOR_GREEN :
+		ratio > 0.4 ? COLOR_YELLOW : COLOR_RED;
+
+	char size[32];
+	if (cur_target == GL_TEXTURE_3D)
+		snprintf(size, sizeof(size), "%ux%ux%u", width, height, depth);
+	else
+		snprintf(size, sizeof(size), "%ux%u", width, height);
+
+	printf(" %4u, %-22s %-34s %-12s %-9s %-14s %s%8.1f%s, %s%.1f%%%s\n",
+	       test_index,
+	       piglit_get_gl_enum_name(cur_format->internal_format),
+	       piglit_get_gl_enum_name(cur_format->type),
+	       size, cur_layout->name, source_names[cur_source],
+	       color ? COLOR_CYAN : "",
+	       mbps,
+	       color ? COLOR_RESET : "",
+	       color ? ratio_color : "",
+	       100 * ratio,
+	       color ? COLOR_RESET : "");
+	return rate;
+}
+
+static void
+perf_format_table(const Format *table, unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		cur_format = &table[i];
+
+		bool supported = setup_texture();
+		double base_rate = 0;
+
+		for (unsigned s = 0; s < NUM_SOURCES; s++) {
+			cur_source = s;
+			double rate = perf_run(base_rate, supported &&
+					       (s != SOURCE_PERSISTENT_PBO ||
+						has_persistent));
+			if (s == SOURCE_CLIENT)
+				base_rate = rate;
+		}
+	}
+}
+
+static void
+perf_sweep(GLenum target, const unsigned *sizes, unsigned num_sizes)
+{
+	cur_target = target;
+
+	for (unsigned i = 0; i < num_sizes; i++) {
+		for (unsigned l = 0; l < ARRAY_SIZE(layouts); l++) {
+			cur_layout = &layouts[l];
+			width = sizes[i] - cur_layout->width_delta;
+			height = sizes[i];
+			depth = target == GL_TEXTURE_3D ? sizes[i] : 1;
+
+			perf_format_table(format_es, num_format_es);
+			perf_format_table(format_es_int, num_format_es_int);
+			perf_format_table(format_core, num_format_core);
+		}
+	}
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	static const unsigned sizes_2d[] = {64, 256, 1024};
+	static const unsigned sizes_3d[] = {32, 128};
+
+	piglit_require_gl_version(30);
+	piglit_require_extension("GL_ARB_pixel_buffer_object");
+	if (gpu_time)
+		piglit_require_extension("GL_ARB_timer_query");
+	has_persistent = piglit_is_extension_supported("GL_ARB_buffer_storage");
+
+	/* The pattern keeps float and half-float sources normal and finite,
+	 * so that special values don't end up on slow paths. */
+	client_data = malloc(BUF_LEN);
+	for (unsigned i = 0; i < BUF_LEN; i++)
+		client_data[i] = 0x30 + (i % 16);
+
+	glGenBuffers(1, &pbo);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, BUF_LEN, client_data,
+		     GL_STREAM_DRAW);
+
+	if (has_persistent) {
+		const GLbitfield flags = GL_MAP_WRITE_BIT |
+					 GL_MAP_PERSISTENT_BIT |
+					 GL_MAP_COHERENT_BIT;
+		void *map;
+
+		glGenBuffers(1, &persistent_pbo);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, persistent_pbo);
+		glBufferStorage(GL_PIXEL_UNPACK_BUFFER, BUF_LEN, NULL, flags);
+		map = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, BUF_LEN,
+				       flags);
+		memcpy(map, client_data, BUF_LEN);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	puts("    #, Internal format,       Type,                              "
+	     "Size,        Layout,   Source,           MB/s, vs client");
+	perf_sweep(GL_TEXTURE_2D, sizes_2d, ARRAY_SIZE(sizes_2d));
+	perf_sweep(GL_TEXTURE_3D, sizes_3d, ARRAY_SIZE(sizes_3d));
+
+	free(client_data);
+	exit(0);
+}
+
+/** Called from test harness/main */
+enum piglit_result
+piglit_display(void)
+{
+	return PIGLIT_FAIL;
+}
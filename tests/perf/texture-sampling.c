@@ -0,0 +1,404 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Measure texture sampling throughput.
+ *
+ * Full-screen quads are drawn into a 1024x1024 framebuffer. Every fragment
+ * does TAPS lookups from the texture, with neighbouring texel offsets so
+ * they can't be merged. Texture coordinates are derived from the
+ * fragment position so that every target is sampled at the same number
+ * of texels per pixel:
+ * - nearest and linear: 1 texel per pixel, base level only
+ * - trilinear: 1.5 texels per pixel, between two mip levels
+ * - anisotropic: 16 texels per pixel in x and 1 in y, 16x anisotropy
+ *
+ * The matrix covers 2D uncompressed and compressed formats, then 3D,
+ * cube map and 2D array targets, and finally texelFetch versus texture().
+ * Compressed textures are filled with random blocks, because only the
+ * decode cost matters here. GPU time is measured with timer queries and
+ * reported as texel lookups per second.
+ */
+
+#include "common.h"
+#include <stdbool.h>
+#include "piglit-util-gl.h"
+
+static int selected_test_index = -1;
+static double duration = 1;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_core_version = 32;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-test")) {
+			if (i == argc - 1) {
+				fprintf(stderr, "-test requires an argument\n");
+				exit(1);
+			}
+
+			const char *testnum = argv[i + 1];
+			char *endptr;
+			selected_test_index = strtol(testnum, &endptr, 10);
+
+			if (endptr != argv[i + 1] + strlen(testnum)) {
+				fprintf(stderr,
+					"Failed to parse test number '%s'\n", testnum);
+				exit(1);
+			}
+
+			printf("Running only test %d\n", selected_test_index);
+			i++;
+		}
+		if (!strcmp(argv[i], "-duration")) {
+			if (i == argc - 1) {
+				fprintf(stderr, "-duration requires an argument\n");
+				exit(1);
+			}
+
+			duration = strtod(argv[i + 1], NULL);
+			printf("Duration forced to %.2f seconds\n", duration);
+			i++;
+		}
+
+		if (!strcmp(argv[i], "-help")) {
+			fprintf(stderr, "texture-sampling [-test TESTNUM] "
+				"[-duration SECS]\n");
+			exit(1);
+		}
+	}
+
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+PIGLIT_GL_TEST_CONFIG_END
+
+#define FB_SIZE 1024
+#define TAPS 8
+
+enum filter {
+	FILTER_NEAREST,
+	FILTER_LINEAR,
+	FILTER_TRILINEAR,
+	FILTER_ANISO,
+	NUM_FILTERS,
+};
+
+static const struct {
+	const char *name;
+	GLenum min_filter;
+	GLenum mag_filter;
+	float texels_per_pixel[2];
+} filters[NUM_FILTERS] = {
+	{ "nearest", GL_NEAREST, GL_NEAREST, { 1, 1 } },
+	{ "linear", GL_LINEAR, GL_LINEAR, { 1, 1 } },
+	{ "trilinear", GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, { 1.5, 1.5 } },
+	{ "aniso 16x", GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, { 16, 1 } },
+};
+
+struct tex_format {
+	GLenum internalformat;
+	const char *name;
+	/* Bytes per 4x4 block for compressed formats, 0 otherwise. */
+	unsigned block_bytes;
+	/* Extension required if the GL version isn't enough, or NULL. */
+	const char *ext;
+	unsigned gl_version;
+};
+
+static const struct tex_format tex_formats[] = {
+	{ GL_RGBA8, "RGBA8", 0, NULL, 0 },
+	{ GL_RGBA16F, "RGBA16F", 0, NULL, 0 },
+	{ GL_RGBA32F, "RGBA32F", 0, NULL, 0 },
+	{ GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, "DXT1", 8,
+	  "GL_EXT_texture_compression_s3tc", 0 },
+	{ GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, "DXT5", 16,
+	  "GL_EXT_texture_compression_s3tc", 0 },
+	{ GL_COMPRESSED_RED_RGTC1, "RGTC1", 8, NULL, 0 },
+	{ GL_COMPRESSED_RGBA_BPTC_UNORM, "BPTC", 16,
+	  "GL_ARB_texture_compression_bptc", 42 },
+	{ GL_COMPRESSED_RGBA8_ETC2_EAC, "ETC2_EAC", 16,
+	  "GL_ARB_ES3_compatibility", 43 },
+};
+
+static const struct {
+	GLenum target;
+	const char *name;
+	const char *sampler;
+	/* Width and height; depth or layers for 3D and arrays. */
+	unsigned size, depth;
+	/* GLSL expressions for texture() and texelFetch() coordinates, given
+	 * the normalized coordinate "c", the fragment coordinate "p" and
+	 * the tap index "i".
+	 */
+	const char *coord;
+	const char *fetch_coord;
+} targets[] = {
+	{ GL_TEXTURE_2D, "2D", "sampler2D", 1024, 1,
+	  "c",
+	  "ivec2(p) & ivec2(1023)" },
+	{ GL_TEXTURE_3D, "3D", "sampler3D", 128, 128,
+	  "vec3(c, (float(i) + 0.5) / float(TAPS))",
+	  "ivec3(ivec2(p) & ivec2(127), i)" },
+	/* Fold c into [-1, 1], so every lookup stays on the +X face. */
+	{ GL_TEXTURE_CUBE_MAP, "cube", "samplerCube", 512, 1,
+	  "vec3(1.0, 1.0 - 2.0 * abs(mod(c, 2.0) - 1.0))",
+	  NULL },
+	{ GL_TEXTURE_2D_ARRAY, "2D array", "sampler2DArray", 1024, TAPS,
+	  "vec3(c, float(i))",
+	  "ivec3(ivec2(p) & ivec2(1023), i)" },
+};
+
+static GLuint fbo, vao;
+static unsigned char *random_data;
+static bool has_aniso;
+
+/* Largest upload: the 2D array with TAPS layers of RGBA8. */
+#define RANDOM_DATA_SIZE (1024 * 1024 * TAPS * 4)
+
+static const char *vs_text =
+	"#version 150\n"
+	"in vec4 piglit_vertex;\n"
+	"void main() { gl_Position = piglit_vertex; }\n";
+
+static GLuint
+build_program(unsigned t, bool fetch)
+{
+	char fs[2048];
+
+	snprintf(fs, sizeof(fs),
+		 "#version 150\n"
+		 "#define TAPS %u\n"
+		 "uniform %s tex;\n"
+		 "uniform vec2 scale;\n"
+		 "out vec4 color;\n"
+		 "void main() {\n"
+		 "	vec4 sum = vec4(0.0);\n"
+		 "	for (int i = 0; i < TAPS; i++) {\n"
+		 "		vec2 p = gl_FragCoord.xy + vec2(i, 0);\n"
+		 "		vec2 c = p * scale;\n"
+		 "		sum += %s(tex, %s%s);\n"
+		 "	}\n"
+		 "	color = sum;\n"
+		 "}\n",
+		 TAPS, targets[t].sampler,
+		 fetch ? "texelFetch" : "texture",
+		 fetch ? targets[t].fetch_coord : targets[t].coord,
+		 fetch ? ", 0" : "");
+
+	return piglit_build_simple_program(vs_text, fs);
+}
+
+static unsigned
+num_levels(unsigned size)
+{
+	unsigned levels = 1;
+
+	while (size > 1) {
+		size /= 2;
+		levels++;
+	}
+	return levels;
+}
+
+static void
+upload_compressed(const struct tex_format *f, unsigned size)
+{
+	for (unsigned l = 0; l < num_levels(size); l++) {
+		unsigned w = MAX2(size >> l, 1);
+		unsigned blocks = (w + 3) / 4;
+
+		glCompressedTexImage2D(GL_TEXTURE_2D, l, f->internalformat,
+				       w, w, 0, blocks * blocks * f->block_bytes,
+				       random_data);
+	}
+}
+
+static GLuint
+create_texture(unsigned t, const struct tex_format *f)
+{
+	GLenum target = targets[t].target;
+	unsigned size = targets[t].size, depth = targets[t].depth;
+	GLuint tex;
+
+	glGenTextures(1, &tex);
+	glBindTexture(target, tex);
+
+	if (f->block_bytes) {
+		/* Compressed formats are only measured in 2D. */
+		upload_compressed(f, size);
+	} else if (target == GL_TEXTURE_CUBE_MAP) {
+		for (unsigned face = 0; face < 6; face++) {
+			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0,
+				     f->internalformat, size, size, 0,
+				     GL_RGBA, GL_UNSIGNED_BYTE, random_data);
+		}
+		glGenerateMipmap(target);
+	} else if (target == GL_TEXTURE_2D) {
+		glTexImage2D(target, 0, f->internalformat, size, size, 0,
+			     GL_RGBA, GL_UNSIGNED_BYTE, random_data);
+		glGenerateMipmap(target);
+	} else {
+		glTexImage3D(target, 0, f->internalformat, size, size, depth,
+			     0, GL_RGBA, GL_UNSIGNED_BYTE, random_data);
+		glGenerateMipmap(target);
+	}
+
+	return tex;
+}
+
+static void
+set_filter(GLenum target, enum filter filter)
+{
+	glTexParameteri(target, GL_TEXTURE_MIN_FILTER,
+			filters[filter].min_filter);
+	glTexParameteri(target, GL_TEXTURE_MAG_FILTER,
+			filters[filter].mag_filter);
+	if (has_aniso) {
+		glTexParameterf(target, GL_TEXTURE_MAX_ANISOTROPY,
+				filter == FILTER_ANISO ? 16 : 1);
+	}
+}
+
+static void
+draw(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++)
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
+static bool
+format_supported(const struct tex_format *f)
+{
+	if (!f->ext)
+		return true;
+	if (f->gl_version && piglit_get_gl_version() >= f->gl_version)
+		return true;
+	return piglit_is_extension_supported(f->ext);
+}
+
+static void
+perf_run(unsigned t, const struct tex_format *f, enum filter filter,
+	 bool fetch)
+{
+	static unsigned test_index;
+	test_index++;
+
+	if (selected_test_index != -1 && test_index != selected_test_index)
+		return;
+
+	const char *lookup = fetch ? "texelFetch" : filters[filter].name;
+	bool supported = format_supported(f) &&
+			 (filter != FILTER_ANISO || has_aniso);
+
+	if (!supported) {
+		printf(" %3u, %-8s %-9s %-10s, not supported\n", test_index,
+		       targets[t].name, f->name, lookup);
+		return;
+	}
+
+	GLuint prog = build_program(t, fetch);
+	GLuint tex = create_texture(t, f);
+
+	glUseProgram(prog);
+	glUniform2f(glGetUniformLocation(prog, "scale"),
+		    filters[filter].texels_per_pixel[0] / targets[t].size,
+		    filters[filter].texels_per_pixel[1] / targets[t].size);
+	set_filter(targets[t].target, filter);
+
+	if (!piglit_check_gl_error(GL_NO_ERROR))
+		piglit_report_result(PIGLIT_FAIL);
+
+	double rate = perf_measure_gpu_rate(draw, duration);
+
+	printf(" %3u, %-8s %-9s %-10s, %10.1f\n", test_index,
+	       targets[t].name, f->name, lookup,
+	       rate * FB_SIZE * FB_SIZE * TAPS / 1000000.0);
+
+	glDeleteTextures(1, &tex);
+	glDeleteProgram(prog);
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	static const float verts[4][2] = {
+		{ -1, -1 }, { 1, -1 }, { -1, 1 }, { 1, 1 },
+	};
+	GLuint rb, vbo;
+
+	if (piglit_get_gl_version() < 33)
+		piglit_require_extension("GL_ARB_timer_query");
+
+	has_aniso = piglit_is_extension_supported("GL_EXT_texture_filter_anisotropic") ||
+		    piglit_is_extension_supported("GL_ARB_texture_filter_anisotropic");
+
+	random_data = malloc(RANDOM_DATA_SIZE);
+	for (unsigned i = 0; i < RANDOM_DATA_SIZE; i++)
+		random_data[i] = rand();
+
+	glGenRenderbuffers(1, &rb);
+	glBindRenderbuffer(GL_RENDERBUFFER, rb);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, FB_SIZE, FB_SIZE);
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+				  GL_RENDERBUFFER, rb);
+	glViewport(0, 0, FB_SIZE, FB_SIZE);
+
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
+	glVertexAttribPointer(PIGLIT_ATTRIB_POS, 2, GL_FLOAT, GL_FALSE, 0,
+			      NULL);
+	glEnableVertexAttribArray(PIGLIT_ATTRIB_POS);
+
+	puts("   #, Target   Format    Lookup    , Mtexels/s");
+
+	/* 2D: all formats and filters. */
+	for (unsigned f = 0; f < ARRAY_SIZE(tex_formats); f++) {
+		for (unsigned filter = 0; filter < NUM_FILTERS; filter++)
+			perf_run(0, &tex_formats[f], filter, false);
+	}
+
+	/* Other targets with RGBA8. */
+	for (unsigned t = 1; t < ARRAY_SIZE(targets); t++) {
+		for (unsigned filter = 0; filter < NUM_FILTERS; filter++)
+			perf_run(t, &tex_formats[0], filter, false);
+	}
+
+	/* texelFetch, to be compared with the nearest results above. */
+	for (unsigned t = 0; t < ARRAY_SIZE(targets); t++) {
+		if (targets[t].fetch_coord)
+			perf_run(t, &tex_formats[0], FILTER_NEAREST, true);
+	}
+
+	free(random_data);
+	exit(0);
+}
+
+/** Called from test harness/main */
+enum piglit_result
+piglit_display(void)
+{
+	return PIGLIT_FAIL;
+}
@@ -52,6 +52,12 @@ Optionally, in piglit.conf one could set also the following:
 [replay]:gfxrecon-replay_bin -- Path to the gfxrecon-replay (GFXReconstruct) executable.
 [replay]:gfxrecon-replay_extra_args -- Space-separated list of extra command line arguments for gfxrecon-replay.
 [replay]:loop_times -- Number of times to replay the last frame in profile mode
+[replay]:baseline -- Frame times baseline file to check profile mode against.
+[replay]:cache_dir -- Directory of the content addressed cache of downloaded traces.
+[replay]:cache_size -- Size budget of the trace cache, in MiB.
+[replay]:warmup_frames -- Number of frames dropped as warmup in profile mode.
+[replay]:warn_threshold -- Median frame time growth percentage to warn about.
+[replay]:fail_threshold -- Median frame time growth percentage to fail on.
 
 Alternatively (or in addition, since environment variables have precedence),
 one could set:
@@ -65,6 +71,12 @@ PIGLIT_REPLAY_GFXRECON_INFO_BINARY -- environment equivalent of [replay]:gfxreco
 PIGLIT_REPLAY_GFXRECON_REPLAY_BINARY -- environment equivalent of [replay]:gfxrecon-replay_bin
 PIGLIT_REPLAY_GFXRECON_REPLAY_EXTRA_ARGS -- environment equivalent of [replay]:gfxrecon-replay_extra_args
 PIGLIT_REPLAY_LOOP_TIMES -- environment equivalent of [replay]:loop_times
+PIGLIT_REPLAY_BASELINE -- environment equivalent of [replay]:baseline
+PIGLIT_REPLAY_CACHE_DIR -- environment equivalent of [replay]:cache_dir
+PIGLIT_REPLAY_CACHE_SIZE -- environment equivalent of [replay]:cache_size
+PIGLIT_REPLAY_WARMUP_FRAMES -- environment equivalent of [replay]:warmup_frames
+PIGLIT_REPLAY_WARN_THRESHOLD -- environment equivalent of [replay]:warn_threshold
+PIGLIT_REPLAY_FAIL_THRESHOLD -- environment equivalent of [replay]:fail_threshold
 
 """
 
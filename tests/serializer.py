@@ -19,9 +19,15 @@
 # OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 # SOFTWARE.
 
-"""Script for taking profiles in python format and serializing them to XML."""
+"""Script for taking profiles in python format and serializing them.
+
+Profiles are written in the indexed format when the output file name ends
+in .pidx, and as gzip'd XML otherwise. Several outputs can be given, to
+write the same profile in both formats.
+"""
 
 import argparse
+import collections
 import gzip
 import os
 import sys
@@ -35,7 +41,10 @@ from framework.test.piglit_test import (
 )
 from framework.test.shader_test import ShaderTest, MultiShaderTest
 from framework.test.glsl_parser_test import GLSLParserTest
-from framework.profile import load_test_profile
+from framework.profile import (
+    load_test_profile, INDEX_HEADER, INDEX_MAGIC, INDEX_VERSION, _U32, _U32x2,
+    _I64, _F64,
+)
 from framework.options import OPTIONS
 
 
@@ -44,20 +53,22 @@ def parser():
     parser = argparse.ArgumentParser()
     parser.add_argument('name')
     parser.add_argument('input')
-    parser.add_argument('output')
+    parser.add_argument('output', nargs='+')
     parser.add_argument('--no-process-isolation', action='store_true')
     parser.add_argument('--glsl-arb-compat', action='store_true')
     args = parser.parse_args()
     return args
 
 
-def _serialize_skips(test, elem):
+def _skips(test):
+    """Return the skip conditions of a test as a dict of options."""
     elems = [
         ('require_shader', 'shader_version'),
         ('require_api', 'api'),
         ('require_version', 'api_version'),
         ('require_extensions', 'extensions'),
     ]
+    options = collections.OrderedDict()
     for e, f in elems:
         value = getattr(test, e, None)
 
@@ -67,7 +78,81 @@ def _serialize_skips(test, elem):
         if not value:
             value = getattr(test, f, None)
         if value:
-            et.SubElement(elem, 'option', name=f, value=repr(value))
+            options[f] = value
+    return options
+
+
+def describe(test):
+    """Return the serialized type of a test and the options to rebuild it.
+
+    The options are the keyword arguments framework.profile.make_test passes
+    to the test's constructor. Returns None for tests that can't be
+    serialized.
+    """
+    options = collections.OrderedDict()
+    if isinstance(test, PiglitGLTest):
+        type_ = 'gl'
+        if test.require_platforms:
+            options['require_platforms'] = test.require_platforms
+        if test.exclude_platforms:
+            options['exclude_platforms'] = test.exclude_platforms
+        options.update(_skips(test))
+    elif isinstance(test, BuiltInConstantsTest):
+        type_ = 'gl_builtin'
+    elif isinstance(test, GLSLParserTest):
+        type_ = 'glsl_parser'
+        options.update(_skips(test))
+    elif isinstance(test, ASMParserTest):
+        options['type_'] = test.command[1]
+        options['filename'] = test.filename
+        return 'asm_parser', options
+    elif isinstance(test, ShaderTest):
+        type_ = 'shader'
+        options.update(_skips(test))
+    elif isinstance(test, MultiShaderTest):
+        options['prog'] = test.prog
+        options['files'] = test.files
+        options['subtests'] = test.subtests
+        options['skips'] = [_skips(s) for s in test.skips]
+        return 'multi_shader', options
+    elif isinstance(test, CLProgramTester):
+        options['filename'] = test.filename
+        return 'cl_prog', options
+    elif isinstance(test, PiglitCLTest):
+        options['command'] = test._command
+        return 'cl', options
+    elif isinstance(test, VkRunnerTest):
+        options['filename'] = test.filename
+        return 'vkrunner', options
+    else:
+        return None
+
+    options['command'] = test._command
+    options['run_concurrent'] = test.run_concurrent
+    if test.cwd:
+        options['cwd'] = test.cwd
+    if test.env:
+        options['env'] = test.env
+    return type_, options
+
+
+def _serialize_xml(root, name, type_, options):
+    elem = et.SubElement(root, 'Test', type=type_, name=name)
+    for k, v in options.items():
+        if k == 'skips':
+            skips = et.SubElement(elem, 'Skips')
+            for s in v:
+                skip = et.SubElement(skips, 'Skip')
+                for sk, sv in s.items():
+                    et.SubElement(skip, 'option', name=sk, value=repr(sv))
+        elif k == 'env':
+            env = et.SubElement(elem, 'environment')
+            for ek, ev in v.items():
+                et.SubElement(env, 'env', name=ek, value=ev)
+        elif k == 'cwd':
+            et.SubElement(elem, 'option', name=k, value=v)
+        else:
+            et.SubElement(elem, 'option', name=k, value=repr(v))
 
 
 def serializer(name, profile, outfile):
@@ -76,66 +161,9 @@ def serializer(name, profile, outfile):
     root = et.Element('PiglitTestList', count=str(len(profile)),
                       name=name)
     for name, test in profile.itertests():
-        if isinstance(test, PiglitGLTest):
-            elem = et.SubElement(root, 'Test', type='gl', name=name)
-            if test.require_platforms:
-                et.SubElement(elem, 'option', name='require_platforms',
-                              value=repr(test.require_platforms))
-            if test.exclude_platforms:
-                et.SubElement(elem, 'option', name='exclude_platforms',
-                              value=repr(test.exclude_platforms))
-            _serialize_skips(test, elem)
-        elif isinstance(test, BuiltInConstantsTest):
-            elem = et.SubElement(root, 'Test', type='gl_builtin', name=name)
-        elif isinstance(test, GLSLParserTest):
-            elem = et.SubElement(root, 'Test', type='glsl_parser', name=name)
-            _serialize_skips(test, elem)
-        elif isinstance(test, ASMParserTest):
-            elem = et.SubElement(root, 'Test', type='asm_parser', name=name)
-            et.SubElement(elem, 'option', name='type_',
-                          value=repr(test.command[1]))
-            et.SubElement(elem, 'option', name='filename',
-                          value=repr(test.filename))
-            continue
-        elif isinstance(test, ShaderTest):
-            elem = et.SubElement(root, 'Test', type='shader', name=name)
-            _serialize_skips(test, elem)
-        elif isinstance(test, MultiShaderTest):
-            elem = et.SubElement(root, 'Test', type='multi_shader', name=name)
-            et.SubElement(elem, 'option', name='prog', value=repr(test.prog))
-            et.SubElement(elem, 'option', name='files', value=repr(test.files))
-            et.SubElement(elem, 'option', name='subtests', value=repr(test.subtests))
-            skips = et.SubElement(elem, 'Skips')
-            for s in test.skips:
-                skip = et.SubElement(skips, 'Skip')
-                _serialize_skips(s, skip)
-            continue
-        elif isinstance(test, CLProgramTester):
-            elem = et.SubElement(root, 'Test', type='cl_prog', name=name)
-            et.SubElement(elem, 'option', name='filename',
-                          value=repr(test.filename))
-            continue
-        elif isinstance(test, PiglitCLTest):
-            elem = et.SubElement(root, 'Test', type='cl', name=name)
-            et.SubElement(elem, 'option', name='command', value=repr(test._command))
-            continue
-        elif isinstance(test, VkRunnerTest):
-            elem = et.SubElement(root, 'Test', type='vkrunner', name=name)
-            et.SubElement(elem, 'option', name='filename',
-                          value=repr(test.filename))
-            continue
-        else:
-            continue
-
-        et.SubElement(elem, 'option', name='command', value=repr(test._command))
-        et.SubElement(elem, 'option', name='run_concurrent',
-                      value=repr(test.run_concurrent))
-        if test.cwd:
-            et.SubElement(elem, 'option', name='cwd', value=test.cwd)
-        if test.env:
-            env = et.SubElement(elem, 'environment')
-            for k, v in test.env.items():
-                et.SubElement(env, 'env', name=k, value=v)
+        desc = describe(test)
+        if desc is not None:
+            _serialize_xml(root, name, *desc)
 
     tree = et.ElementTree(root)
     reproducible_mtime = None
@@ -145,13 +173,126 @@ def serializer(name, profile, outfile):
         tree.write(f, encoding='utf-8', xml_declaration=True)
 
 
+class IndexWriter(object):
+    """Builds a profile in the indexed format read by
+    framework.profile.IndexedProfile.
+
+    Every string is interned in a single table and referenced by id, and
+    the options of each test are stored as tagged values, so loading needs
+    neither XML parsing nor ast.literal_eval.
+    """
+
+    def __init__(self):
+        self.__ids = {}
+        self.__strings = []
+        self.__records = bytearray()
+        self.__index = []
+
+    def intern(self, string):
+        try:
+            return self.__ids[string]
+        except KeyError:
+            id_ = self.__ids[string] = len(self.__strings)
+            self.__strings.append(string.encode('utf-8'))
+            return id_
+
+    def __encode(self, value, out):
+        # bool has to be checked before int, since it's a subclass of it.
+        if isinstance(value, str):
+            out += b's' + _U32.pack(self.intern(value))
+        elif value is True:
+            out += b'T'
+        elif value is False:
+            out += b'F'
+        elif value is None:
+            out += b'N'
+        elif isinstance(value, int):
+            out += b'i' + _I64.pack(value)
+        elif isinstance(value, float):
+            out += b'f' + _F64.pack(value)
+        elif isinstance(value, dict):
+            out += b'd' + _U32.pack(len(value))
+            for k, v in value.items():
+                self.__encode(k, out)
+                self.__encode(v, out)
+        else:
+            if isinstance(value, list):
+                tag = b'l'
+            elif isinstance(value, tuple):
+                tag = b't'
+            elif isinstance(value, (set, frozenset)):
+                # Keep the output reproducible, set order depends on the
+                # hash seed.
+                tag = b'e'
+                value = sorted(value, key=repr)
+            else:
+                raise TypeError(
+                    'Cannot serialize {!r} in an indexed profile'.format(value))
+            out += tag + _U32.pack(len(value))
+            for v in value:
+                self.__encode(v, out)
+
+    def add(self, name, type_, options):
+        # make_test always passes an environment to the constructor.
+        options = collections.OrderedDict(options)
+        options.setdefault('env', {})
+
+        self.__index.append((name.encode('utf-8'), len(self.__records)))
+        self.__records += _U32x2.pack(self.intern(name), self.intern(type_))
+        self.__encode(options, self.__records)
+
+    def write(self, name, f):
+        name_id = self.intern(name)
+
+        str_offsets = INDEX_HEADER.size
+        offset = str_offsets + (len(self.__strings) + 1) * 4
+        offsets = bytearray()
+        for s in self.__strings:
+            offsets += _U32.pack(offset)
+            offset += len(s)
+        offsets += _U32.pack(offset)
+
+        index = offset
+        records = index + len(self.__index) * 8
+
+        f.write(INDEX_HEADER.pack(INDEX_MAGIC, INDEX_VERSION,
+                                  len(self.__index), len(self.__strings),
+                                  str_offsets, index, records, name_id))
+        f.write(offsets)
+        for s in self.__strings:
+            f.write(s)
+        for key, rec in sorted(self.__index):
+            f.write(_U32x2.pack(self.__ids[key.decode('utf-8')],
+                                records + rec))
+        f.write(self.__records)
+
+
+def index_serializer(name, profile, outfile):
+    """Take each test in the profile and write it out as an indexed profile."""
+    writer = IndexWriter()
+    for test_name, test in profile.itertests():
+        desc = describe(test)
+        if desc is not None:
+            writer.add(test_name, *desc)
+
+    # Write to a temporary file first, so that an interrupted build doesn't
+    # leave a truncated profile behind.
+    with open(outfile + '.tmp', 'wb') as f:
+        writer.write(name, f)
+    os.replace(outfile + '.tmp', outfile)
+
+
 def main():
     args = parser()
     OPTIONS.process_isolation = not args.no_process_isolation
     if args.glsl_arb_compat:
         os.environ['PIGLIT_FORCE_GLSLPARSER_DESKTOP'] = 'true'
     profile = load_test_profile(args.input, python=True)
-    serializer(args.name, profile, args.output)
+    for output in args.output:
+        if output.endswith('.pidx'):
+            index_serializer(args.name, profile, output)
+        else:
+            serializer(args.name, profile, output)
 
 
 if __name__ == '__main__':
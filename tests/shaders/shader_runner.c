@@ -24,12 +24,15 @@
 #include <stdbool.h>
 #include <string.h>
 #include <ctype.h>
+#include <errno.h>
+#include <limits.h>
 
 #include "piglit-util.h"
 #include "piglit-util-gl.h"
 #include "piglit-vbo.h"
 #include "piglit-framework-gl/piglit_gl_framework.h"
 #include "piglit-subprocess.h"
+#include "piglit-blob-cache.h"
 
 #include "shader_runner_gles_workarounds.h"
 #include "parser_utils.h"
@@ -45,6 +48,8 @@ static struct piglit_gl_test_config current_config;
 static void
 get_required_config(const char *script_name, bool spirv,
 		    struct piglit_gl_test_config *config);
+static const char *
+first_stdin_script(void);
 static GLenum
 decode_drawing_mode(const char *mode_str);
 
@@ -62,7 +67,11 @@ PIGLIT_GL_TEST_CONFIG_BEGIN
 	 * [require] section, so it will be handled later.
 	 */
 	if (argc > 1) {
-		get_required_config(argv[1], spirv_replaces_glsl, &config);
+		const char *script_name = argv[1];
+
+		if (strcmp(script_name, "-") == 0)
+			script_name = first_stdin_script();
+		get_required_config(script_name, spirv_replaces_glsl, &config);
 	} else {
 		config.supports_gl_compat_version = 10;
 	}
@@ -188,6 +197,28 @@ static bool ignore_missing_uniforms = false;
 
 static bool report_subtests = false;
 
+/**
+ * Test script read from stdin, when shader_runner is given "-" instead
+ * of a file name.
+ *
+ * The scripts come as a stream, each of them preceded by a line holding
+ * its size in bytes and its name:
+ *
+ *     <size> <name>\n
+ *     <size bytes of shader_test script>
+ *
+ * The name is only used to report the result of the script, as if it
+ * were the path of the file holding it.  The scripts are run one after
+ * the other in a single session, like multiple files given on the
+ * command line.
+ */
+static struct {
+	bool enabled;
+	char name[4096];
+	char *text;
+	unsigned size;
+} stdin_script;
+
 struct specialization_list {
 	size_t buffer_size;
 	size_t n_entries;
@@ -1808,12 +1839,103 @@ process_specialization(enum states state, const char *line)
 	return PIGLIT_FAIL;
 }
 
+/**
+ * Read the next script of the stream on stdin into stdin_script.
+ *
+ * Returns false at the end of the stream.
+ */
+static bool
+read_stdin_script(void)
+{
+	char header[sizeof(stdin_script.name) + 32];
+	unsigned long size;
+	char *name, *end;
+
+	free(stdin_script.text);
+	stdin_script.text = NULL;
+
+	if (fgets(header, sizeof(header), stdin) == NULL)
+		return false;
+
+	errno = 0;
+	size = strtoul(header, &name, 10);
+	end = strchr(header, '\n');
+	if (name == header || name[0] != ' ' || errno != 0 ||
+	    size >= UINT_MAX || end == NULL || end == name + 1 ||
+	    (size_t)(end - (name + 1)) >= sizeof(stdin_script.name)) {
+		fprintf(stderr, "Invalid script header on stdin: %s\n",
+			header);
+		piglit_report_result(PIGLIT_FAIL);
+	}
+	*end = '\0';
+	strcpy(stdin_script.name, name + 1);
+
+	stdin_script.text = malloc(size + 1);
+	if (stdin_script.text == NULL) {
+		fprintf(stderr, "%s: malloc failed.\n", __func__);
+		piglit_report_result(PIGLIT_FAIL);
+	}
+	if (fread(stdin_script.text, 1, size, stdin) != size) {
+		fprintf(stderr, "Script \"%s\" truncated on stdin\n",
+			stdin_script.name);
+		piglit_report_result(PIGLIT_FAIL);
+	}
+	stdin_script.text[size] = '\0';
+	stdin_script.size = size;
+
+	return true;
+}
+
+/**
+ * Start reading scripts from stdin, and return the name of the first
+ * one.
+ *
+ * When the GL context is recreated for a script, this is called again
+ * and returns the script which is still pending.
+ */
+static const char *
+first_stdin_script(void)
+{
+	stdin_script.enabled = true;
+
+	if (stdin_script.text == NULL && !read_stdin_script()) {
+		printf("No test scripts on stdin\n");
+		piglit_report_result(PIGLIT_SKIP);
+	}
+
+	return stdin_script.name;
+}
+
+/**
+ * Load the text of a test script, which is either the script read from
+ * stdin or the named file.  The caller owns the returned copy.
+ */
+static char *
+load_test_script(const char *script_name, unsigned *size)
+{
+	char *text;
+
+	if (!stdin_script.enabled)
+		return piglit_load_text_file(script_name, size);
+
+	if (stdin_script.text == NULL)
+		return NULL;
+
+	text = malloc(stdin_script.size + 1);
+	if (text == NULL)
+		return NULL;
+	memcpy(text, stdin_script.text, stdin_script.size + 1);
+	*size = stdin_script.size;
+
+	return text;
+}
+
 static enum piglit_result
 process_test_script(const char *script_name)
 {
 	unsigned text_size;
 	unsigned line_num;
-	char *text = piglit_load_text_file(script_name, &text_size);
+	char *text = load_test_script(script_name, &text_size);
 	enum states state = none;
 	const char *line = text;
 	enum piglit_result result;
@@ -2004,7 +2126,7 @@ parse_required_config(struct requirement_parse_results *results,
 		      const char *script_name)
 {
 	unsigned text_size;
-	char *text = piglit_load_text_file(script_name, &text_size);
+	char *text = load_test_script(script_name, &text_size);
 	const char *line = text;
 	bool in_requirement_section = false;
 
@@ -5519,12 +5641,12 @@ static enum piglit_result
 init_test(const char *file)
 {
 	enum piglit_result result;
+	int64_t start = piglit_time_get_nano();
 
 	result = process_test_script(file);
-	if (result != PIGLIT_PASS)
-		return result;
-
-	result = link_and_use_shaders();
+	if (result == PIGLIT_PASS)
+		result = link_and_use_shaders();
+	piglit_blob_cache_add_compile_time(piglit_time_get_nano() - start);
 	if (result != PIGLIT_PASS)
 		return result;
 
@@ -5635,7 +5757,8 @@ piglit_init(int argc, char **argv)
 		force_no_names = true;
 
 	if (argc < 2) {
-		printf("usage: shader_runner <test.shader_test> [-glsl] [-force-no-names]\n");
+		printf("usage: shader_runner <test.shader_test> [-glsl] [-force-no-names]\n"
+		       "       shader_runner - [-glsl] [-force-no-names] < scripts\n");
 		exit(1);
 	}
 
@@ -5711,14 +5834,29 @@ piglit_init(int argc, char **argv)
 		}
 	}
 
+	piglit_blob_cache_init(argv[1]);
+
 	/* Run multiple tests per session. */
-	if (argc > 2) {
+	if (argc > 2 || stdin_script.enabled) {
 		char testname[4096], *ext;
 		int i, j;
 		enum piglit_result all = PIGLIT_PASS;
 
-		for (i = 1; i < argc; i++) {
-			const char *hit, *filename = argv[i];
+		for (i = 1; ; i++) {
+			const char *hit, *filename;
+
+			if (stdin_script.enabled) {
+				/* The first script was read when choosing
+				 * the GL config.
+				 */
+				if (i > 1 && !read_stdin_script())
+					break;
+				filename = stdin_script.name;
+			} else if (i < argc) {
+				filename = argv[i];
+			} else {
+				break;
+			}
 
 			memcpy(piglit_tolerance, default_piglit_tolerance,
 			       sizeof(piglit_tolerance));
@@ -5730,8 +5868,12 @@ piglit_init(int argc, char **argv)
 			memset(specializations, 0, sizeof(specializations));
 
 			/* Re-initialize the GL context if a different GL config is required. */
-			if (!validate_current_gl_context(filename))
-				recreate_gl_context(argv[0], argc - i, argv + i);
+			if (!validate_current_gl_context(filename)) {
+				if (stdin_script.enabled)
+					recreate_gl_context(argv[0], 1, argv + 1);
+				else
+					recreate_gl_context(argv[0], argc - i, argv + i);
+			}
 
 			/* Clear global variables to defaults. */
 			test_start = NULL;
@@ -0,0 +1,458 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Measure the cost of handing images and buffers from a Vulkan producer
+ * to a GL consumer through EXT_external_objects.
+ *
+ * For every format and size, each frame is a full round trip: GL signals
+ * the Vulkan wait semaphore and releases the shared object, Vulkan clears
+ * the image and signals back, GL waits on the semaphore and then reads
+ * every texel of the shared object. The image test copies the imported
+ * texture with glCopyImageSubData; the buffer test has Vulkan copy the
+ * image into an exported buffer that GL uploads from as a pixel unpack
+ * buffer.
+ *
+ * Sync latency is the time from the GL signal until the GL wait has
+ * retired, and is reported as a min/median/p99 distribution. Frames/s and
+ * MB/s include the consumer reads.
+ */
+
+#include <piglit-util-gl.h>
+#include "interop.h"
+#include "params.h"
+#include "helpers.h"
+
+static int selected_test_index = -1;
+static double duration = 1;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 30;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+	config.khr_no_error_support = PIGLIT_HAS_ERRORS;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-test")) {
+			if (i == argc - 1) {
+				fprintf(stderr, "-test requires an argument\n");
+				exit(1);
+			}
+
+			const char *testnum = argv[i + 1];
+			char *endptr;
+			selected_test_index = strtol(testnum, &endptr, 10);
+
+			if (endptr != argv[i + 1] + strlen(testnum)) {
+				fprintf(stderr, "Failed to parse test number '%s'\n",
+					testnum);
+				exit(1);
+			}
+
+			printf("Running only test %d\n", selected_test_index);
+			i++;
+		}
+		if (!strcmp(argv[i], "-duration")) {
+			if (i == argc - 1) {
+				fprintf(stderr, "-duration requires an argument\n");
+				exit(1);
+			}
+
+			duration = strtod(argv[i + 1], NULL);
+			printf("Duration forced to %.2f seconds\n", duration);
+			i++;
+		}
+		if (!strcmp(argv[i], "-help")) {
+			fprintf(stderr, "ext_external_objects-vk-interop-bandwidth "
+				"[-test TESTNUM] [-duration SECS]\n");
+			exit(1);
+		}
+	}
+
+PIGLIT_GL_TEST_CONFIG_END
+
+#define MIN_SAMPLES 10
+#define MAX_SAMPLES 100000
+
+struct interop_format {
+	const char *name;
+	VkFormat vk_format;
+	GLenum internal_format;
+	GLenum format;
+	GLenum type;
+	unsigned cpp;
+};
+
+static const struct interop_format formats[] = {
+	{ "RGBA8", VK_FORMAT_R8G8B8A8_UNORM,
+	  GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4 },
+	{ "RGBA16F", VK_FORMAT_R16G16B16A16_SFLOAT,
+	  GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 8 },
+	{ "RGBA32F", VK_FORMAT_R32G32B32A32_SFLOAT,
+	  GL_RGBA32F, GL_RGBA, GL_FLOAT, 16 },
+};
+
+static const unsigned sizes[] = { 64, 256, 1024, 2048 };
+
+/* Objects shared for one format and size. */
+struct interop_target {
+	const struct interop_format *format;
+	unsigned size;
+
+	struct vk_image_att color_att;
+	struct vk_image_att depth_att;
+	struct vk_renderer rnd;
+	struct vk_buf bo;
+
+	GLuint gl_tex_mem_obj;
+	GLuint gl_bo_mem_obj;
+	GLuint gl_tex;
+	GLuint gl_bo;
+	GLuint gl_dst_tex;
+};
+
+typedef void (*frame_func)(struct interop_target *t, int64_t *sync_ns);
+
+static struct vk_ctx vk_core;
+static struct vk_semaphores vk_sem;
+static struct gl_ext_semaphores gl_sem;
+static bool vk_initialized;
+static bool sem_initialized;
+
+static char *vs_src;
+static char *fs_src;
+static unsigned int vs_sz;
+static unsigned int fs_sz;
+
+static int64_t *samples;
+static unsigned frame_count;
+
+static VkBufferUsageFlagBits vk_bo_usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+					   VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+					   VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT;
+
+/**
+ * Let Vulkan clear the shared image, waiting on the GL release and
+ * signalling GL when it is done.
+ */
+static void
+vk_produce(struct interop_target *t)
+{
+	struct vk_image_att images[] = { t->color_att, t->depth_att };
+	float color[4] = { 0.0, 0.0, 0.0, 1.0 };
+
+	/* Vary the contents so that no frame can be elided. */
+	color[frame_count++ % 3] = 1.0;
+
+	vk_clear_color(&vk_core, 0, &t->rnd, color, 4, &vk_sem,
+		       true, true, images, ARRAY_SIZE(images),
+		       0, 0, t->size, t->size);
+
+	/* The helpers record into a single command buffer, which has to
+	 * retire before it is recorded again.
+	 */
+	vkQueueWaitIdle(vk_core.queue);
+}
+
+static void
+image_frame(struct interop_target *t, int64_t *sync_ns)
+{
+	GLenum layout = gl_get_layout_from_vk(color_in_layout);
+	int64_t start = piglit_time_get_nano();
+
+	glSignalSemaphoreEXT(gl_sem.gl_frame_ready, 0, NULL, 1,
+			     &t->gl_tex, &layout);
+	glFlush();
+
+	vk_produce(t);
+
+	layout = gl_get_layout_from_vk(color_end_layout);
+	glWaitSemaphoreEXT(gl_sem.vk_frame_done, 0, NULL, 1,
+			   &t->gl_tex, &layout);
+	glFinish();
+	*sync_ns = piglit_time_get_nano() - start;
+
+	glCopyImageSubData(t->gl_tex, GL_TEXTURE_2D, 0, 0, 0, 0,
+			   t->gl_dst_tex, GL_TEXTURE_2D, 0, 0, 0, 0,
+			   t->size, t->size, 1);
+	glFinish();
+}
+
+static void
+buffer_frame(struct interop_target *t, int64_t *sync_ns)
+{
+	int64_t start = piglit_time_get_nano();
+
+	glSignalSemaphoreEXT(gl_sem.gl_frame_ready, 1, &t->gl_bo, 0,
+			     NULL, NULL);
+	glFlush();
+
+	vk_produce(t);
+	vk_copy_image_to_buffer(&vk_core, &t->color_att, &t->bo,
+				t->size, t->size);
+
+	glWaitSemaphoreEXT(gl_sem.vk_frame_done, 1, &t->gl_bo, 0,
+			   NULL, NULL);
+	glFinish();
+	*sync_ns = piglit_time_get_nano() - start;
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, t->gl_bo);
+	glBindTexture(GL_TEXTURE_2D, t->gl_dst_tex);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, t->size, t->size,
+			t->format->format, t->format->type, 0);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glFinish();
+}
+
+static void
+destroy_target(struct interop_target *t)
+{
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDeleteTextures(1, &t->gl_tex);
+	glDeleteTextures(1, &t->gl_dst_tex);
+	glDeleteBuffers(1, &t->gl_bo);
+	glDeleteMemoryObjectsEXT(1, &t->gl_tex_mem_obj);
+	glDeleteMemoryObjectsEXT(1, &t->gl_bo_mem_obj);
+
+	vk_destroy_renderer(&vk_core, &t->rnd);
+	vk_destroy_ext_image(&vk_core, &t->color_att.obj);
+	vk_destroy_ext_image(&vk_core, &t->depth_att.obj);
+	vk_destroy_ext_bo(&vk_core, &t->bo);
+
+	memset(t, 0, sizeof(*t));
+}
+
+/**
+ * Create the Vulkan image and buffer for one format and size and import
+ * them into GL. Returns false if the combination is not supported.
+ */
+static bool
+create_target(const struct interop_format *format, unsigned size,
+	      struct interop_target *t)
+{
+	memset(t, 0, sizeof(*t));
+	t->format = format;
+	t->size = size;
+
+	if (!vk_fill_ext_image_props(&vk_core, size, size, d,
+				     num_samples, num_levels, num_layers,
+				     format->vk_format, color_tiling,
+				     color_in_layout, color_end_layout,
+				     true, &t->color_att.props) ||
+	    !vk_create_ext_image(&vk_core, &t->color_att.props,
+				 &t->color_att.obj))
+		goto fail;
+
+	if (!vk_fill_ext_image_props(&vk_core, size, size, d,
+				     num_samples, num_levels, num_layers,
+				     depth_format, depth_tiling,
+				     depth_in_layout, depth_end_layout,
+				     false, &t->depth_att.props) ||
+	    !vk_create_ext_image(&vk_core, &t->depth_att.props,
+				 &t->depth_att.obj))
+		goto fail;
+
+	if (!vk_create_renderer(&vk_core, vs_src, vs_sz, fs_src, fs_sz,
+				false, false,
+				&t->color_att, &t->depth_att, 0, &t->rnd))
+		goto fail;
+
+	if (!vk_create_ext_buffer(&vk_core, size * size * format->cpp,
+				  vk_bo_usage, &t->bo))
+		goto fail;
+
+	if (!gl_create_mem_obj_from_vk_mem(&vk_core, &t->color_att.obj.mobj,
+					   &t->gl_tex_mem_obj) ||
+	    !gl_gen_tex_from_mem_obj(&t->color_att.props,
+				     format->internal_format,
+				     t->gl_tex_mem_obj, 0, &t->gl_tex))
+		goto fail;
+
+	if (!gl_create_mem_obj_from_vk_mem(&vk_core, &t->bo.mobj,
+					   &t->gl_bo_mem_obj) ||
+	    !gl_gen_buf_from_mem_obj(t->gl_bo_mem_obj, GL_PIXEL_UNPACK_BUFFER,
+				     t->bo.mobj.mem_sz, 0, &t->gl_bo))
+		goto fail;
+
+	glGenTextures(1, &t->gl_dst_tex);
+	glBindTexture(GL_TEXTURE_2D, t->gl_dst_tex);
+	glTexStorage2D(GL_TEXTURE_2D, 1, format->internal_format, size, size);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	if (glGetError() == GL_NO_ERROR)
+		return true;
+
+fail:
+	destroy_target(t);
+	return false;
+}
+
+static int
+cmp_int64(const void *a, const void *b)
+{
+	int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+
+	return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static unsigned test_index;
+
+static void
+perf_skip(const char *name, const struct interop_format *format,
+	  unsigned size)
+{
+	test_index++;
+
+	if (selected_test_index != -1 && test_index != selected_test_index)
+		return;
+
+	char dims[20];
+
+	snprintf(dims, sizeof(dims), "%ux%u", size, size);
+	printf(" %3u, %-6s, %-8s, %-9s, not supported\n",
+	       test_index, name, format->name, dims);
+}
+
+static void
+perf_run(const char *name, struct interop_target *t, frame_func f)
+{
+	test_index++;
+
+	if (selected_test_index != -1 && test_index != selected_test_index)
+		return;
+
+	char size[20];
+	int64_t sync_ns;
+
+	/* Warm up, so that first-use costs are not measured. */
+	f(t, &sync_ns);
+
+	int64_t start = piglit_time_get_nano();
+	int64_t end = start + (int64_t)(duration * 1e9);
+	unsigned n = 0;
+
+	while (n < MAX_SAMPLES &&
+	       (n < MIN_SAMPLES || piglit_time_get_nano() < end))
+		f(t, &samples[n++]);
+
+	double secs = (piglit_time_get_nano() - start) / 1e9;
+	double bytes = (double)t->size * t->size * t->format->cpp;
+
+	qsort(samples, n, sizeof(samples[0]), cmp_int64);
+
+	snprintf(size, sizeof(size), "%ux%u", t->size, t->size);
+	printf(" %3u, %-6s, %-8s, %-9s, %9.1f, %9.1f, %11.1f, %11.1f, %11.1f\n",
+	       test_index, name, t->format->name, size,
+	       n / secs, n * bytes / secs / (1024 * 1024),
+	       samples[0] / 1000.0,
+	       samples[n / 2] / 1000.0,
+	       samples[(unsigned)((n - 1) * 0.99)] / 1000.0);
+}
+
+static void
+cleanup(void)
+{
+	if (sem_initialized) {
+		glDeleteSemaphoresEXT(1, &gl_sem.gl_frame_ready);
+		glDeleteSemaphoresEXT(1, &gl_sem.vk_frame_done);
+		vk_destroy_semaphores(&vk_core, &vk_sem);
+	}
+
+	free(vs_src);
+	free(fs_src);
+	free(samples);
+
+	if (vk_initialized)
+		vk_cleanup_ctx(&vk_core);
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	piglit_require_extension("GL_ARB_texture_storage");
+	piglit_require_extension("GL_ARB_copy_image");
+	piglit_require_extension("GL_ARB_pixel_buffer_object");
+	piglit_require_extension("GL_EXT_memory_object");
+	piglit_require_extension("GL_EXT_memory_object_fd");
+	piglit_require_extension("GL_EXT_semaphore");
+	piglit_require_extension("GL_EXT_semaphore_fd");
+
+	atexit(cleanup);
+
+	if (!vk_init_ctx_for_rendering(&vk_core)) {
+		fprintf(stderr, "Failed to create Vulkan context.\n");
+		piglit_report_result(PIGLIT_SKIP);
+	}
+	vk_initialized = true;
+
+	if (!vk_check_gl_compatibility(&vk_core)) {
+		fprintf(stderr, "Mismatch in driver/device UUID\n");
+		piglit_report_result(PIGLIT_SKIP);
+	}
+
+	if (!(vs_src = load_shader(VK_BANDS_VERT, &vs_sz)) ||
+	    !(fs_src = load_shader(VK_BANDS_FRAG, &fs_sz))) {
+		fprintf(stderr, "Failed to load the Vulkan shaders.\n");
+		piglit_report_result(PIGLIT_FAIL);
+	}
+
+	if (!vk_create_semaphores(&vk_core, &vk_sem)) {
+		fprintf(stderr, "Failed to create semaphores.\n");
+		piglit_report_result(PIGLIT_FAIL);
+	}
+
+	if (!gl_create_semaphores_from_vk(&vk_core, &vk_sem, &gl_sem)) {
+		fprintf(stderr, "Failed to import semaphores from Vulkan.\n");
+		piglit_report_result(PIGLIT_FAIL);
+	}
+	sem_initialized = true;
+
+	samples = malloc(MAX_SAMPLES * sizeof(samples[0]));
+
+	puts("   #, Object, Format  , Size     ,  frames/s,      MB/s, sync min us, "
+	     "sync med us, sync p99 us");
+
+	for (unsigned i = 0; i < ARRAY_SIZE(formats); i++) {
+		for (unsigned j = 0; j < ARRAY_SIZE(sizes); j++) {
+			struct interop_target t;
+
+			if (!create_target(&formats[i], sizes[j], &t)) {
+				perf_skip("image", &formats[i], sizes[j]);
+				perf_skip("buffer", &formats[i], sizes[j]);
+				continue;
+			}
+
+			perf_run("image", &t, image_frame);
+			perf_run("buffer", &t, buffer_frame);
+
+			destroy_target(&t);
+		}
+	}
+
+	exit(0);
+}
+
+/** Called from test harness/main */
+enum piglit_result
+piglit_display(void)
+{
+	return PIGLIT_FAIL;
+}
@@ -108,10 +108,36 @@
  *   On others (e.g. i965), this is an important corner case to test.
  */
 
+#include <typeinfo>
+
 #include "common.h"
 using namespace piglit_util_fbo;
 using namespace piglit_util_test_pattern;
 
+/**
+ * The reference image drawn by the most recent Test.
+ *
+ * The reference image doesn't depend on the sample count, so when a test
+ * runs several sample counts in one process (e.g. "all_samples") the
+ * supersampled reference is only rendered and read back once.  The image is
+ * kept both in an fbo, so that it can still be shown in the window, and as
+ * float data (linearized for sRGB tests) for measure_accuracy().
+ */
+struct reference_image {
+	const std::type_info *pattern;
+	const std::type_info *manifest_program;
+	bool srgb;
+	bool combine_depth_stencil;
+	int pattern_width;
+	int pattern_height;
+	int supersample_factor;
+
+	Fbo fbo;
+	float *data;
+};
+
+static struct reference_image *cached_reference = NULL;
+
 void
 DownsampleProg::compile(int supersample_factor)
 {
@@ -264,7 +290,8 @@ Test::Test(TestPattern *pattern, ManifestProgram *manifest_program,
 	  supersample_factor(0),
 	  srgb(srgb),
 	  downsample_prog(),
-	  filter_mode(GL_NONE)
+	  filter_mode(GL_NONE),
+	  combine_depth_stencil(false)
 {
 }
 
@@ -283,6 +310,7 @@ Test::init(int num_samples, bool small, bool combine_depth_stencil,
 	this->pattern_height = pattern_height;
 	this->supersample_factor = supersample_factor;
 	this->filter_mode = filter_mode;
+	this->combine_depth_stencil = combine_depth_stencil;
 
 	FboConfig test_fbo_config(0,
 				  small ? 16 : pattern_width,
@@ -456,12 +484,37 @@ Test::draw_to_default_framebuffer()
 	draw_pattern(0, 0, pattern_width, pattern_height);
 }
 
+/**
+ * Whether \c ref holds the reference image this test would draw.
+ */
+bool
+Test::reference_matches(const struct reference_image *ref) const
+{
+	const std::type_info *manifest =
+		manifest_program ? &typeid(*manifest_program) : NULL;
+
+	return ref != NULL &&
+		*ref->pattern == typeid(*pattern) &&
+		(ref->manifest_program == NULL) == (manifest == NULL) &&
+		(manifest == NULL || *ref->manifest_program == *manifest) &&
+		ref->srgb == srgb &&
+		ref->combine_depth_stencil == combine_depth_stencil &&
+		ref->pattern_width == pattern_width &&
+		ref->pattern_height == pattern_height &&
+		ref->supersample_factor == supersample_factor;
+}
+
 /**
  * Draw the entire test image, rendering it a piece at a time.
  */
 void
 Test::draw_reference_image()
 {
+	if (reference_matches(cached_reference)) {
+		show(&cached_reference->fbo, pattern_width, 0);
+		return;
+	}
+
 	int downsampled_width =
 		supersample_fbo.config.width / supersample_factor;
 	int downsampled_height =
@@ -486,6 +539,96 @@ Test::draw_reference_image()
 			     pattern_width + x_offset, y_offset);
 		}
 	}
+
+	if (cached_reference) {
+		delete [] cached_reference->data;
+		delete cached_reference;
+	}
+
+	cached_reference = new reference_image();
+	cached_reference->pattern = &typeid(*pattern);
+	cached_reference->manifest_program =
+		manifest_program ? &typeid(*manifest_program) : NULL;
+	cached_reference->srgb = srgb;
+	cached_reference->combine_depth_stencil = combine_depth_stencil;
+	cached_reference->pattern_width = pattern_width;
+	cached_reference->pattern_height = pattern_height;
+	cached_reference->supersample_factor = supersample_factor;
+	cached_reference->data = NULL;
+
+	FboConfig config(0, pattern_width, pattern_height);
+	config.combine_depth_stencil = false;
+	config.depth_internalformat = GL_NONE;
+	config.stencil_internalformat = GL_NONE;
+	cached_reference->fbo.setup(config);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, piglit_winsys_fbo);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, cached_reference->fbo.handle);
+	glBlitFramebuffer(pattern_width, 0,
+			  2 * pattern_width, pattern_height,
+			  0, 0, pattern_width, pattern_height,
+			  GL_COLOR_BUFFER_BIT, GL_NEAREST);
+}
+
+/**
+ * Accumulate the squared error between the reference and test images into
+ * the unlit, partially lit and totally lit statistics, depending on the
+ * value of each reference component.
+ *
+ * Each of the four components of a pixel accumulates into its own lane and
+ * the classification is done with selects rather than branches, so the
+ * compiler can vectorize the inner loop without reassociating the sums.
+ * Partial sums are kept in float for one row of pixels at a time and then
+ * folded into the double precision totals.
+ */
+static void
+accumulate_error(const float *ref, const float *test, int width, int height,
+		 Stats *unlit, Stats *partially_lit, Stats *totally_lit)
+{
+	for (int y = 0; y < height; ++y) {
+		float sum[3][4] = { { 0 } };
+		int count[3][4] = { { 0 } };
+		const float *ref_row = ref + 4 * y * width;
+		const float *test_row = test + 4 * y * width;
+
+		for (int x = 0; x < width; ++x) {
+			for (int c = 0; c < 4; ++c) {
+				const float r = ref_row[4 * x + c];
+				const float e = test_row[4 * x + c] - r;
+				const float e2 = e * e;
+				const bool is_unlit = r <= 0.0;
+				const bool is_lit = r >= 1.0;
+				const bool is_partial = !is_unlit && !is_lit;
+
+				sum[0][c] += is_unlit ? e2 : 0.0f;
+				sum[1][c] += is_partial ? e2 : 0.0f;
+				sum[2][c] += is_lit ? e2 : 0.0f;
+				count[0][c] += is_unlit;
+				count[1][c] += is_partial;
+				count[2][c] += is_lit;
+			}
+		}
+
+		Stats *stats[3] = { unlit, partially_lit, totally_lit };
+		for (int i = 0; i < 3; ++i) {
+			for (int c = 0; c < 4; ++c)
+				stats[i]->record_sum(count[i][c], sum[i][c]);
+		}
+	}
+}
+
+/**
+ * When testing sRGB, compare pixels linearly so that the measured error is
+ * comparable to the non-sRGB case.
+ */
+static void
+linearize_srgb(float *data, int num_pixels)
+{
+	for (int i = 0; i < num_pixels; ++i) {
+		for (int c = 0; c < 3; ++c)
+			data[4 * i + c] =
+				piglit_srgb_to_linear(data[4 * i + c]);
+	}
 }
 
 /**
@@ -504,40 +647,40 @@ Test::measure_accuracy()
 			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, piglit_winsys_fbo);
 			glViewport(0, 0, piglit_width, piglit_height);
 
-	float *reference_data = new float[pattern_width * pattern_height * 4];
-	glReadPixels(pattern_width, 0, pattern_width, pattern_height, GL_RGBA,
-		     GL_FLOAT, reference_data);
+	const int num_pixels = pattern_width * pattern_height;
+	const float *reference_data;
+	float *uncached_reference_data = NULL;
+	if (reference_matches(cached_reference) &&
+	    cached_reference->data != NULL) {
+		reference_data = cached_reference->data;
+	} else {
+		float *data = new float[num_pixels * 4];
+		glReadPixels(pattern_width, 0, pattern_width, pattern_height,
+			     GL_RGBA, GL_FLOAT, data);
+		if (srgb)
+			linearize_srgb(data, num_pixels);
+
+		if (reference_matches(cached_reference))
+			cached_reference->data = data;
+		else
+			uncached_reference_data = data;
+		reference_data = data;
+	}
 
-	float *test_data = new float[pattern_width * pattern_height * 4];
+	float *test_data = new float[num_pixels * 4];
 	glReadPixels(0, 0, pattern_width, pattern_height, GL_RGBA,
 		     GL_FLOAT, test_data);
+	if (srgb)
+		linearize_srgb(test_data, num_pixels);
 
 	Stats unlit_stats;
 	Stats partially_lit_stats;
 	Stats totally_lit_stats;
-	for (int y = 0; y < pattern_height; ++y) {
-		for (int x = 0; x < pattern_width; ++x) {
-			for (int c = 0; c < 4; ++c) {
-				int pixel_pos = 4*(y*pattern_width + x) + c;
-				float ref = reference_data[pixel_pos];
-				float test = test_data[pixel_pos];
-				/* When testing sRGB, compare pixels
-				 * linearly so that the measured error
-				 * is comparable to the non-sRGB case.
-				 */
-				if (srgb && c < 3) {
-					ref = piglit_srgb_to_linear(ref);
-					test = piglit_srgb_to_linear(test);
-				}
-				if (ref <= 0.0)
-					unlit_stats.record(test - ref);
-				else if (ref >= 1.0)
-					totally_lit_stats.record(test - ref);
-				else
-					partially_lit_stats.record(test - ref);
-			}
-		}
-	}
+	accumulate_error(reference_data, test_data,
+			 pattern_width, pattern_height,
+			 &unlit_stats, &partially_lit_stats, &totally_lit_stats);
+	delete [] uncached_reference_data;
+	delete [] test_data;
 
 	double error_threshold;
 	if (test_resolve) {
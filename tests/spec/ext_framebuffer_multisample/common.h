@@ -78,6 +78,12 @@ public:
 		sum_squared_error += error * error;
 	}
 
+	void record_sum(int n, double squared_error)
+	{
+		count += n;
+		sum_squared_error += squared_error;
+	}
+
 	void summarize();
 
 	bool is_perfect();
@@ -119,6 +125,7 @@ private:
 	void downsample_color(int downsampled_width, int downsampled_height);
 	void show(piglit_util_fbo::Fbo *src_fbo, int x_offset, int y_offset);
 	void draw_pattern(int x_offset, int y_offset, int width, int height);
+	bool reference_matches(const struct reference_image *ref) const;
 
 	/** The test pattern to draw. */
 	piglit_util_test_pattern::TestPattern *pattern;
@@ -179,6 +186,8 @@ private:
 	 * Filter mode to use when downsampling the image
 	 */
 	GLenum filter_mode;
+
+	bool combine_depth_stencil;
 };
 
 Test *
@@ -557,7 +557,9 @@ struct wrap_mode {
 #define TEXTURE_SIZE(npot)  ((npot) ? SIZE_NPOT : SIZE_POT)
 #define BIAS_INT(npot)      (TEXTURE_SIZE(npot)+2)
 #define BIAS(npot)          (BIAS_INT(npot) / (double)TEXTURE_SIZE(npot))
-#define TILE_SIZE(npot)     ((BIAS_INT(npot)*2 + TEXTURE_SIZE(npot)) * TEXEL_SIZE)
+#define TILE_TEXELS(npot)   (BIAS_INT(npot)*2 + TEXTURE_SIZE(npot))
+#define MAX_TILE_TEXELS     (SIZEMAX*3 + 4)
+#define TILE_SIZE(npot)     (TILE_TEXELS(npot) * TEXEL_SIZE)
 
 /* Test parameters and state. */
 static GLuint texture_id;
@@ -608,46 +610,25 @@ static int get_int_format_bits(const struct format_desc *format)
 	       maxbits >= 10 ? 10 : 8;
 }
 
-static void sample_nearest(int x, int y, int z,
-			   GLenum wrap_mode, GLenum filter,
-			   unsigned char pixel[4],
-			   const struct format_desc *format,
-			   GLboolean npot, GLboolean texswizzle,
-			   int bits)
+/* Apply the wrap mode to a texel coordinate along one axis.
+ *
+ * Wrapping is separable, so the tile reference is built from one table
+ * of wrapped coordinates per axis. *outside is set if the coordinate
+ * lies in the border. */
+static int wrap_coord(int coord, GLenum wrap_mode, GLenum filter,
+		      GLboolean npot, GLboolean *outside)
 {
-	unsigned sample_border = 0;
-	float border_factor = 0;
-	int coords[3] = {x, y, z};
-	unsigned i;
-	float result[4];
-	int *iresult = (int*)result;
-	unsigned *uiresult = (unsigned*)result;
+	const int size = TEXTURE_SIZE(npot);
 
-	/* Zero coords according to the texture target. */
-	switch (texture_target) {
-	case GL_TEXTURE_1D:
-		coords[1] = 0;
-		/* Fall through. */
-
-	case GL_TEXTURE_2D:
-	case GL_TEXTURE_RECTANGLE:
-		coords[2] = 0;
-	}
+	*outside = GL_FALSE;
 
-	if (texture_offset) {
-		coords[0] -= 3;
-		if (texture_target != GL_TEXTURE_1D)
-			coords[1] += 3;
-	}
 	/* Handle clamp mirroring. */
 	switch (wrap_mode) {
 	case GL_MIRROR_CLAMP_EXT:
 	case GL_MIRROR_CLAMP_TO_EDGE_EXT:
 	case GL_MIRROR_CLAMP_TO_BORDER_EXT:
-		for (i = 0; i < 3; i++) {
-			if (coords[i] < 0) {
-				coords[i] = -coords[i] - 1;
-			}
+		if (coord < 0) {
+			coord = -coord - 1;
 		}
 	}
 
@@ -661,37 +642,13 @@ static void sample_nearest(int x, int y, int z,
 
 	case GL_CLAMP_TO_BORDER:
 	case GL_MIRROR_CLAMP_TO_BORDER_EXT:
-		sample_border = 0;
-		for (i = 0; i < 3; i++) {
-			if (coords[i] >= TEXTURE_SIZE(npot) || coords[i] < 0) {
-				sample_border++;
-			}
-		}
-	}
-
-	/* Figure out what the border factor is. */
-	switch (wrap_mode) {
-	case GL_CLAMP:
-	case GL_MIRROR_CLAMP_EXT:
-		if (filter == GL_LINEAR) {
-			const double factor[] = {0, 0.5, 0.75, 0.875};
-			border_factor = factor[sample_border];
-		}
-		break;
-	case GL_CLAMP_TO_BORDER:
-	case GL_MIRROR_CLAMP_TO_BORDER_EXT:
-		if (sample_border) {
-			border_factor = 1;
-		}
-		break;
+		*outside = coord >= size || coord < 0;
 	}
 
 	/* Handle wrapping. */
 	switch (wrap_mode) {
 	case GL_REPEAT:
-		for (i = 0; i < 3; i++) {
-			coords[i] = (coords[i] + TEXTURE_SIZE(npot)*10) % TEXTURE_SIZE(npot);
-		}
+		coord = (coord + size*10) % size;
 		break;
 
 	case GL_CLAMP:
@@ -700,20 +657,51 @@ static void sample_nearest(int x, int y, int z,
 	case GL_MIRROR_CLAMP_TO_BORDER_EXT:
 	case GL_CLAMP_TO_EDGE:
 	case GL_MIRROR_CLAMP_TO_EDGE_EXT:
-		for (i = 0; i < 3; i++) {
-			coords[i] = coords[i] >= TEXTURE_SIZE(npot) ? TEXTURE_SIZE(npot)-1 :
-								coords[i] < 0 ? 0 : coords[i];
-		}
+		coord = coord >= size ? size-1 : coord < 0 ? 0 : coord;
 		break;
 
 	case GL_MIRRORED_REPEAT:
-		for (i = 0; i < 3; i++) {
-			coords[i] = (coords[i] + TEXTURE_SIZE(npot)*10) % (TEXTURE_SIZE(npot) * 2);
-			if (coords[i] >= TEXTURE_SIZE(npot))
-				coords[i] = 2*TEXTURE_SIZE(npot) - coords[i] - 1;
+		coord = (coord + size*10) % (size * 2);
+		if (coord >= size)
+			coord = 2*size - coord - 1;
+		break;
+	}
+
+	return coord;
+}
+
+/* Figure out what the border factor is, given the number of coordinates
+ * which lie in the border. */
+static float get_border_factor(GLenum wrap_mode, GLenum filter,
+			       unsigned sample_border)
+{
+	switch (wrap_mode) {
+	case GL_CLAMP:
+	case GL_MIRROR_CLAMP_EXT:
+		if (filter == GL_LINEAR) {
+			const double factor[] = {0, 0.5, 0.75, 0.875};
+			return factor[sample_border];
+		}
+		break;
+	case GL_CLAMP_TO_BORDER:
+	case GL_MIRROR_CLAMP_TO_BORDER_EXT:
+		if (sample_border) {
+			return 1;
 		}
 		break;
 	}
+	return 0;
+}
+
+static void sample_texel(const int coords[3], float border_factor,
+			 unsigned char pixel[4],
+			 const struct format_desc *format,
+			 GLboolean texswizzle, int bits)
+{
+	unsigned i;
+	float result[4];
+	int *iresult = (int*)result;
+	unsigned *uiresult = (unsigned*)result;
 
 	/* Sample the pixel. */
 	if (format->depth) {
@@ -783,6 +771,136 @@ static void sample_nearest(int x, int y, int z,
 	}
 }
 
+/* Compute the expected color of every texel of a tile in one pass.
+ * Tile texel (a,b) corresponds to texture coordinate
+ * (a - BIAS_INT, b - BIAS_INT), and all slices of a 3D texture are
+ * the same, so only slice 0 is sampled. */
+static void compute_expected_tile(unsigned char *expected,
+				  GLenum wrap_mode, GLenum filter,
+				  const struct format_desc *format,
+				  GLboolean npot, GLboolean texswizzle,
+				  int bits)
+{
+	const int tile = TILE_TEXELS(npot);
+	int wrapped_x[MAX_TILE_TEXELS], wrapped_y[MAX_TILE_TEXELS];
+	GLboolean outside_x[MAX_TILE_TEXELS], outside_y[MAX_TILE_TEXELS];
+	GLboolean outside_z;
+	int coords[3];
+	float border_factor[4];
+	int a, b;
+	unsigned i;
+
+	for (a = 0; a < tile; a++) {
+		int x = a - BIAS_INT(npot);
+		int y = a - BIAS_INT(npot);
+
+		/* Zero coords according to the texture target. */
+		if (texture_target == GL_TEXTURE_1D)
+			y = 0;
+
+		if (texture_offset) {
+			x -= 3;
+			if (texture_target != GL_TEXTURE_1D)
+				y += 3;
+		}
+
+		wrapped_x[a] = wrap_coord(x, wrap_mode, filter, npot,
+					  &outside_x[a]);
+		wrapped_y[a] = wrap_coord(y, wrap_mode, filter, npot,
+					  &outside_y[a]);
+	}
+	coords[2] = wrap_coord(0, wrap_mode, filter, npot, &outside_z);
+
+	for (i = 0; i < ARRAY_SIZE(border_factor); i++)
+		border_factor[i] = get_border_factor(wrap_mode, filter, i);
+
+	for (b = 0; b < tile; b++) {
+		coords[1] = wrapped_y[b];
+		for (a = 0; a < tile; a++) {
+			coords[0] = wrapped_x[a];
+			sample_texel(coords,
+				     border_factor[outside_x[a] + outside_y[b] +
+						   outside_z],
+				     &expected[(b * tile + a) * 4],
+				     format, texswizzle, bits);
+		}
+	}
+}
+
+/* Expected tiles are cached between formats. Many formats share the
+ * same channel layout and produce identical texel data, so the tile only
+ * needs to be recomputed when something it depends on changes. */
+#define EXPECTED_CACHE_SIZE 64
+
+static struct expected_tile {
+	GLboolean valid;
+	uint64_t image_hash;
+	GLenum wrap_mode, filter;
+	GLboolean npot, texswizzle;
+	int type, bits, depth, stencil, srgb;
+	unsigned char texels[MAX_TILE_TEXELS * MAX_TILE_TEXELS * 4];
+} expected_cache[EXPECTED_CACHE_SIZE];
+
+/* FNV-1a hash of the texel data and border color the reference is
+ * computed from. */
+static uint64_t hash_image(const struct format_desc *format)
+{
+	const unsigned char *bytes = (const unsigned char*)image;
+	size_t size = size_x * size_y * size_z *
+		      (format->depth || format->stencil ? 1 : 4) *
+		      sizeof(image[0]);
+	uint64_t hash = 0xcbf29ce484222325ull;
+	size_t i;
+
+	for (i = 0; i < size; i++)
+		hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+
+	bytes = (const unsigned char*)border_real;
+	for (i = 0; i < sizeof(border_real); i++)
+		hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+
+	return hash;
+}
+
+static const unsigned char *
+get_expected_tile(uint64_t image_hash, GLenum wrap_mode, GLenum filter,
+		  const struct format_desc *format,
+		  GLboolean npot, GLboolean texswizzle, int bits)
+{
+	uint64_t key = image_hash ^ (wrap_mode * 31 + filter) ^
+		       (npot << 1 | texswizzle);
+	struct expected_tile *entry =
+		&expected_cache[key % EXPECTED_CACHE_SIZE];
+
+	if (entry->valid &&
+	    entry->image_hash == image_hash &&
+	    entry->wrap_mode == wrap_mode &&
+	    entry->filter == filter &&
+	    entry->npot == npot &&
+	    entry->texswizzle == texswizzle &&
+	    entry->type == format->type &&
+	    entry->bits == bits &&
+	    entry->depth == format->depth &&
+	    entry->stencil == format->stencil &&
+	    entry->srgb == format->srgb)
+		return entry->texels;
+
+	compute_expected_tile(entry->texels, wrap_mode, filter, format,
+			      npot, texswizzle, bits);
+	entry->valid = GL_TRUE;
+	entry->image_hash = image_hash;
+	entry->wrap_mode = wrap_mode;
+	entry->filter = filter;
+	entry->npot = npot;
+	entry->texswizzle = texswizzle;
+	entry->type = format->type;
+	entry->bits = bits;
+	entry->depth = format->depth;
+	entry->stencil = format->stencil;
+	entry->srgb = format->srgb;
+	return entry->texels;
+}
+
 GLboolean probe_pixel_rgba(unsigned char *pixels, unsigned stride,
 			   unsigned *pixels_deltamax,
 			   unsigned x, unsigned y, unsigned char *expected,
@@ -811,6 +929,51 @@ GLboolean probe_pixel_rgba(unsigned char *pixels, unsigned stride,
 	return GL_FALSE;
 }
 
+/* Compare the center of every texel of a tile against the expected tile.
+ * Only the first failing texel is reported. */
+static GLboolean probe_tile(unsigned char *pixels, int x0, int y0,
+			    const unsigned char *expected, GLboolean npot,
+			    unsigned *pixels_deltamax,
+			    const char *filter, const char *wrapmode)
+{
+	const int tile = TILE_TEXELS(npot);
+	int a, b;
+	unsigned i;
+
+	for (b = 0; b < tile; b++) {
+		unsigned y = y0 + TEXEL_SIZE*b + TEXEL_SIZE/2;
+		const unsigned char *row = &pixels[(y * piglit_width + x0 +
+						    TEXEL_SIZE/2) * 4];
+		const unsigned char *exp_row = &expected[b * tile * 4];
+		unsigned mismatch = 0;
+
+		for (a = 0; a < tile; a++) {
+			for (i = 0; i < 4; i++) {
+				int delta = abs((int)row[a*TEXEL_SIZE*4 + i] -
+						(int)exp_row[a*4 + i]);
+				mismatch |= delta > pixels_deltamax[i];
+			}
+		}
+
+		if (!mismatch)
+			continue;
+
+		/* Find and report the first failing texel of the row. */
+		for (a = 0; a < tile; a++) {
+			unsigned char texel[4];
+
+			memcpy(texel, &exp_row[a*4], sizeof(texel));
+			if (!probe_pixel_rgba(pixels, piglit_width,
+					      pixels_deltamax,
+					      x0 + TEXEL_SIZE*a + TEXEL_SIZE/2, y,
+					      texel, a, b, filter, wrapmode))
+				return GL_FALSE;
+		}
+	}
+
+	return GL_TRUE;
+}
+
 static void update_swizzle(GLboolean texswizzle)
 {
 	GLint iden[4] = {GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA};
@@ -1002,13 +1165,12 @@ static GLboolean probe_pixels(const struct format_desc *format, GLboolean npot,
 	GLboolean pass = GL_TRUE;
 	int num_filters = format->type == FLOAT_TYPE ? 2 : 1;
 	int bits = get_int_format_bits(format);
+	uint64_t image_hash = hash_image(format);
 
 	pixels = malloc(piglit_width * piglit_height * 4);
 	glReadPixels(0, 0, piglit_width, piglit_height,
 		     GL_RGBA, GL_UNSIGNED_BYTE, pixels);
 
-	/* make slices different for 3D textures */
-
 	/* Loop over min/mag filters. */
 	for (i = 0; i < num_filters; i++) {
 		GLenum filter = i ? GL_LINEAR : GL_NEAREST;
@@ -1058,9 +1220,8 @@ static GLboolean probe_pixels(const struct format_desc *format, GLboolean npot,
 
 		/* Loop over all wrap modes. */
 		for (j = 0; wrap_modes[j].mode != 0; j++) {
-			unsigned char expected[4];
+			const unsigned char *expected;
 			int x0, y0;
-			int a, b;
 
 			test_to_xy(j, i, npot, &x0, &y0);
 
@@ -1070,30 +1231,15 @@ static GLboolean probe_pixels(const struct format_desc *format, GLboolean npot,
 			if (skip_test(wrap_modes[j].mode, filter))
 				continue;
 
-			for (b = 0; b < (TEXTURE_SIZE(npot) + BIAS_INT(npot)*2); b++) {
-				for (a = 0; a < (TEXTURE_SIZE(npot) + BIAS_INT(npot)*2); a++) {
-					double x = x0 + TEXEL_SIZE*(a+0.5);
-					double y = y0 + TEXEL_SIZE*(b+0.5);
-
-					sample_nearest(a - BIAS_INT(npot), b - BIAS_INT(npot),
-						       0, /* the slices are the same */
-						       wrap_modes[j].mode, filter, expected,
-						       format, npot, texswizzle, bits);
-
-					const char *name =
-						piglit_get_gl_enum_name(
-							wrap_modes[j].mode);
-					if (!probe_pixel_rgba(pixels, piglit_width, deltamax_swizzled,
-							      x, y, expected, a, b,
-							      sfilter, name)) {
-						pass = GL_FALSE;
-						goto tile_done;
-					}
-				}
-			}
+			expected = get_expected_tile(image_hash,
+						     wrap_modes[j].mode, filter,
+						     format, npot, texswizzle,
+						     bits);
 
-tile_done:
-			;
+			if (!probe_tile(pixels, x0, y0, expected, npot,
+					deltamax_swizzled, sfilter,
+					piglit_get_gl_enum_name(wrap_modes[j].mode)))
+				pass = GL_FALSE;
 		}
 	}
 
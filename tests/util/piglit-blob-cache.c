@@ -0,0 +1,343 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file piglit-blob-cache.c
+ *
+ * File-backed EGL_ANDROID_blob_cache, see piglit-blob-cache.h.
+ *
+ * Each blob is kept in its own file, named after a hash of its key and
+ * holding a small header, the key and the value.  The key is compared on
+ * lookup, so hash collisions are only misses.  Files are written under a
+ * temporary name and renamed, so tests running concurrently with the same
+ * directory never see partial blobs.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#ifdef PIGLIT_HAS_PTHREADS
+#include <pthread.h>
+#endif
+
+#include "piglit-blob-cache.h"
+
+#define BLOB_MAGIC "PBC1"
+
+struct blob_header {
+	char magic[4];
+	uint32_t key_size;
+	uint32_t value_size;
+};
+
+static char *cache_dir;
+static char *cache_name;
+static EGLDisplay cache_dpy = EGL_NO_DISPLAY;
+static struct piglit_blob_cache_stats cache_stats;
+static unsigned tmp_serial;
+
+#ifdef PIGLIT_HAS_PTHREADS
+/* The driver may call the cache functions from its own threads. */
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define cache_lock() pthread_mutex_lock(&cache_mutex)
+#define cache_unlock() pthread_mutex_unlock(&cache_mutex)
+#else
+#define cache_lock()
+#define cache_unlock()
+#endif
+
+/** FNV-1a hash of a key. */
+static uint64_t
+hash_key(const void *key, EGLsizeiANDROID key_size)
+{
+	const unsigned char *bytes = key;
+	uint64_t hash = 0xcbf29ce484222325ull;
+	EGLsizeiANDROID i;
+
+	for (i = 0; i < key_size; i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+static char *
+blob_path(const void *key, EGLsizeiANDROID key_size)
+{
+	char *path;
+
+	if (asprintf(&path, "%s/%016" PRIx64 "-%ld", cache_dir,
+		     hash_key(key, key_size), (long) key_size) < 0)
+		return NULL;
+
+	return path;
+}
+
+static void
+set_blob(const void *key, EGLsizeiANDROID key_size,
+	 const void *value, EGLsizeiANDROID value_size)
+{
+	struct blob_header header;
+	char *path, *tmp_path = NULL;
+	FILE *f;
+	bool ok;
+
+	if (key_size < 0 || value_size < 0 ||
+	    key_size > UINT32_MAX || value_size > UINT32_MAX)
+		return;
+
+	memcpy(header.magic, BLOB_MAGIC, sizeof(header.magic));
+	header.key_size = key_size;
+	header.value_size = value_size;
+
+	cache_lock();
+
+	path = blob_path(key, key_size);
+	if (path == NULL ||
+	    asprintf(&tmp_path, "%s.%ld.%u.tmp", path, (long) getpid(),
+		     tmp_serial++) < 0) {
+		tmp_path = NULL;
+		goto out;
+	}
+
+	f = fopen(tmp_path, "wb");
+	if (f == NULL)
+		goto out;
+	ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+	     fwrite(key, 1, key_size, f) == (size_t) key_size &&
+	     fwrite(value, 1, value_size, f) == (size_t) value_size;
+	ok = fclose(f) == 0 && ok;
+
+	if (ok && rename(tmp_path, path) == 0)
+		cache_stats.stores++;
+	else
+		unlink(tmp_path);
+
+out:
+	cache_unlock();
+	free(tmp_path);
+	free(path);
+}
+
+/**
+ * Read the value stored for key, following the contract of
+ * EGLGetBlobFuncANDROID: the value is only written if it fits in
+ * value_size bytes, but its size is returned regardless.
+ */
+static EGLsizeiANDROID
+get_blob(const void *key, EGLsizeiANDROID key_size,
+	 void *value, EGLsizeiANDROID value_size)
+{
+	struct blob_header header;
+	EGLsizeiANDROID size = 0;
+	void *stored_key = NULL;
+	char *path;
+	FILE *f = NULL;
+
+	cache_lock();
+
+	path = blob_path(key, key_size);
+	if (path == NULL || key_size < 0 || value_size < 0)
+		goto out;
+
+	f = fopen(path, "rb");
+	if (f == NULL)
+		goto out;
+
+	if (fread(&header, sizeof(header), 1, f) != 1 ||
+	    memcmp(header.magic, BLOB_MAGIC, sizeof(header.magic)) != 0 ||
+	    header.key_size != (uint32_t) key_size)
+		goto out;
+
+	stored_key = malloc(key_size);
+	if (stored_key == NULL ||
+	    fread(stored_key, 1, key_size, f) != (size_t) key_size ||
+	    memcmp(stored_key, key, key_size) != 0)
+		goto out;
+
+	if (header.value_size > (uint64_t) value_size) {
+		/* Too big for the caller, which gets nothing usable. */
+		size = header.value_size;
+		goto out;
+	}
+
+	if (fread(value, 1, header.value_size, f) == header.value_size) {
+		size = header.value_size;
+		cache_stats.hits++;
+		cache_unlock();
+		goto done;
+	}
+
+out:
+	cache_stats.misses++;
+	cache_unlock();
+done:
+	if (f != NULL)
+		fclose(f);
+	free(stored_key);
+	free(path);
+	return size;
+}
+
+/** Write str as a JSON string. */
+static void
+write_json_string(FILE *f, const char *str)
+{
+	fputc('"', f);
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\')
+			fprintf(f, "\\%c", *str);
+		else if ((unsigned char) *str < 0x20)
+			fprintf(f, "\\u%04x", *str);
+		else
+			fputc(*str, f);
+	}
+	fputc('"', f);
+}
+
+static void
+report_stats(void)
+{
+	struct piglit_blob_cache_stats stats;
+	const char *stats_file = getenv("PIGLIT_BLOB_CACHE_STATS");
+
+	piglit_blob_cache_get_stats(&stats);
+
+	printf("piglit: info: blob cache: %u hits, %u misses, %u stores, "
+	       "%.3f ms compiling\n",
+	       stats.hits, stats.misses, stats.stores,
+	       stats.compile_time_ns / 1000000.0);
+
+	if (stats_file != NULL && stats_file[0] != '\0') {
+		FILE *f = fopen(stats_file, "a");
+
+		if (f == NULL) {
+			fprintf(stderr, "blob cache: cannot open %s: %s\n",
+				stats_file, strerror(errno));
+			return;
+		}
+
+		fprintf(f, "{\"name\": ");
+		write_json_string(f, cache_name);
+		fprintf(f, ", \"hits\": %u, \"misses\": %u, \"stores\": %u, "
+			"\"compile_time_ns\": %" PRId64 "}\n",
+			stats.hits, stats.misses, stats.stores,
+			stats.compile_time_ns);
+		fclose(f);
+	}
+}
+
+bool
+piglit_blob_cache_attach(EGLDisplay dpy, const char *dir, const char *name)
+{
+	PFNEGLSETBLOBCACHEFUNCSANDROIDPROC set_blob_cache_funcs;
+	EGLint error;
+
+	if (!piglit_is_egl_extension_supported(dpy, "EGL_ANDROID_blob_cache")) {
+		printf("piglit: info: blob cache: "
+		       "EGL_ANDROID_blob_cache not supported\n");
+		return false;
+	}
+
+	if (mkdir(dir, 0777) != 0 && errno != EEXIST) {
+		fprintf(stderr, "blob cache: cannot create %s: %s\n",
+			dir, strerror(errno));
+		return false;
+	}
+
+	set_blob_cache_funcs = (PFNEGLSETBLOBCACHEFUNCSANDROIDPROC)
+		eglGetProcAddress("eglSetBlobCacheFuncsANDROID");
+	if (set_blob_cache_funcs == NULL)
+		return false;
+
+	cache_lock();
+	if (cache_dir == NULL || strcmp(cache_dir, dir) != 0) {
+		free(cache_dir);
+		cache_dir = strdup(dir);
+	}
+	cache_unlock();
+
+	set_blob_cache_funcs(dpy, set_blob, get_blob);
+	error = eglGetError();
+
+	/* The functions can only be set once for each display, which
+	 * is expected when the test attaches the cache again to the same
+	 * display, for instance after recreating its context.
+	 */
+	if (error != EGL_SUCCESS &&
+	    !(error == EGL_BAD_PARAMETER && dpy == cache_dpy)) {
+		fprintf(stderr, "blob cache: eglSetBlobCacheFuncsANDROID "
+			"failed with %s\n", piglit_get_egl_error_name(error));
+		return false;
+	}
+
+	if (cache_name == NULL) {
+		cache_name = strdup(name);
+		atexit(report_stats);
+	}
+	cache_dpy = dpy;
+
+	return true;
+}
+
+bool
+piglit_blob_cache_init(const char *name)
+{
+	const char *dir = getenv("PIGLIT_BLOB_CACHE_DIR");
+	EGLDisplay dpy;
+
+	if (dir == NULL || dir[0] == '\0')
+		return false;
+
+	dpy = eglGetCurrentDisplay();
+	if (dpy == EGL_NO_DISPLAY) {
+		printf("piglit: info: blob cache: no current EGL display\n");
+		return false;
+	}
+
+	return piglit_blob_cache_attach(dpy, dir, name);
+}
+
+void
+piglit_blob_cache_add_compile_time(int64_t time_ns)
+{
+	if (cache_dpy == EGL_NO_DISPLAY)
+		return;
+
+	cache_lock();
+	cache_stats.compile_time_ns += time_ns;
+	cache_unlock();
+}
+
+void
+piglit_blob_cache_get_stats(struct piglit_blob_cache_stats *stats)
+{
+	cache_lock();
+	*stats = cache_stats;
+	cache_unlock();
+}
@@ -0,0 +1,119 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file piglit-blob-cache.h
+ *
+ * File-backed cache for EGL_ANDROID_blob_cache.
+ *
+ * When the PIGLIT_BLOB_CACHE_DIR environment variable names a directory,
+ * piglit_blob_cache_init() registers cache functions with the current EGL
+ * display that keep each blob the driver stores in a file of that
+ * directory.  Compiled shaders then survive from one test process to the
+ * next: running a set of tests twice, starting with an empty directory,
+ * measures cold and warm compiles.
+ *
+ * The hits, misses and stores of the cache, and the time the test spent
+ * compiling and linking shaders, are printed when the process exits.  If
+ * PIGLIT_BLOB_CACHE_STATS names a file, they are also appended to it as a
+ * line of JSON, so the numbers of a whole run can be summed up.
+ *
+ * Without EGL support, these functions do nothing.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef PIGLIT_HAS_EGL
+#include "piglit-util-egl.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct piglit_blob_cache_stats {
+	/** Lookups which found a blob. */
+	unsigned hits;
+	/** Lookups which found nothing usable. */
+	unsigned misses;
+	/** Blobs written to the cache. */
+	unsigned stores;
+	/** Time reported by piglit_blob_cache_add_compile_time(). */
+	int64_t compile_time_ns;
+};
+
+#ifdef PIGLIT_HAS_EGL
+
+/**
+ * \brief Attach a blob cache kept in \a dir to \a dpy.
+ *
+ * The directory is created if needed.  \a name identifies the test in the
+ * statistics.  Return false, after printing why, if the cache could not be
+ * attached.
+ */
+bool
+piglit_blob_cache_attach(EGLDisplay dpy, const char *dir, const char *name);
+
+/**
+ * \brief Attach a blob cache to the current EGL display if
+ * PIGLIT_BLOB_CACHE_DIR is set.
+ *
+ * This must be called before the test compiles any shader.  Return true if
+ * a cache is attached.
+ */
+bool
+piglit_blob_cache_init(const char *name);
+
+/**
+ * \brief Account \a time_ns nanoseconds of shader compilation.
+ *
+ * Only counted while a cache is attached.
+ */
+void
+piglit_blob_cache_add_compile_time(int64_t time_ns);
+
+/**
+ * \brief Get the statistics of the attached cache.
+ */
+void
+piglit_blob_cache_get_stats(struct piglit_blob_cache_stats *stats);
+
+#else
+
+static inline bool
+piglit_blob_cache_init(const char *name)
+{
+	return false;
+}
+
+static inline void
+piglit_blob_cache_add_compile_time(int64_t time_ns)
+{
+}
+
+#endif /* PIGLIT_HAS_EGL */
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
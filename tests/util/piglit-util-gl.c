@@ -2636,6 +2636,232 @@ piglit_miptree_texture()
 	return tex;
 }
 
+/**
+ * Fill \c n consecutive texels of \c texel_size bytes with \c texel.
+ *
+ * The first texel is written directly and the filled region is then doubled
+ * with memcpy, so a span costs log2(n) wide copies rather than one small copy
+ * per texel.
+ */
+static void
+fill_texels(void *dst, const void *texel, size_t texel_size, int n)
+{
+	uint8_t *p = dst;
+	int filled;
+
+	if (n <= 0)
+		return;
+
+	memcpy(p, texel, texel_size);
+	for (filled = 1; filled < n; filled *= 2)
+		memcpy(p + filled * texel_size, p,
+		       MIN2(filled, n - filled) * texel_size);
+}
+
+/**
+ * Fill a w x h image with four solid quadrants.
+ *
+ * Only the first row of each half is built texel by texel, every other row
+ * is a copy of the row above it.
+ */
+static void
+fill_quadrants(void *data, size_t texel_size, int w, int h,
+	       const void *tl, const void *tr,
+	       const void *bl, const void *br)
+{
+	const size_t row_size = w * texel_size;
+	uint8_t *row = data;
+	int y;
+
+	for (y = 0; y < h; y++, row += row_size) {
+		if (y == 0 || y == h / 2) {
+			const bool top = y < h / 2;
+
+			fill_texels(row, top ? tl : bl, texel_size, w / 2);
+			fill_texels(row + (w / 2) * texel_size,
+				    top ? tr : br, texel_size, w - w / 2);
+		} else {
+			memcpy(row, row - row_size, row_size);
+		}
+	}
+}
+
+/**
+ * Return the index into the {red, green, blue} colors that a compressed
+ * rgbw image of the given size is filled with, or -1 if the image has
+ * quadrants.
+ */
+static int
+rgbw_image_solid_color(GLenum internalFormat, int w, int h)
+{
+	const int size = w > h ? w : h;
+
+	switch (internalFormat) {
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+	case GL_COMPRESSED_RGB_FXT1_3DFX:
+	case GL_COMPRESSED_RGBA_FXT1_3DFX:
+	case GL_COMPRESSED_RED_RGTC1:
+	case GL_COMPRESSED_SIGNED_RED_RGTC1:
+	case GL_COMPRESSED_RG_RGTC2:
+	case GL_COMPRESSED_SIGNED_RG_RGTC2:
+	case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+	case GL_COMPRESSED_RGBA_BPTC_UNORM:
+	case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+	case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+	case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+		if (size == 4)
+			return 0;
+		else if (size == 2)
+			return 1;
+		else if (size == 1)
+			return 2;
+		break;
+	default:
+		break;
+	}
+
+	return -1;
+}
+
+static void
+rgbw_image_fill(GLfloat *data, int solid_color, int w, int h,
+		GLboolean alpha, GLenum basetype)
+{
+	float colors[4][4] = {
+		{1.0, 0.0, 0.0, 0.0},	/* red */
+		{0.0, 1.0, 0.0, 0.25},	/* green */
+		{0.0, 0.0, 1.0, 0.5},	/* blue */
+		{1.0, 1.0, 1.0, 1.0},	/* white */
+	};
+	int c, x;
+
+	for (c = 0; c < 4; c++) {
+		if (!alpha)
+			colors[c][3] = 1.0;
+
+		for (x = 0; x < 4; x++) {
+			switch (basetype) {
+			case GL_UNSIGNED_NORMALIZED:
+				break;
+			case GL_SIGNED_NORMALIZED:
+				colors[c][x] = colors[c][x] * 2 - 1;
+				break;
+			case GL_FLOAT:
+				colors[c][x] = colors[c][x] * 10 - 5;
+				break;
+			default:
+				assert(0);
+			}
+		}
+	}
+
+	if (solid_color >= 0)
+		fill_texels(data, colors[solid_color], sizeof(colors[0]),
+			    w * h);
+	else
+		fill_quadrants(data, sizeof(colors[0]), w, h,
+			       colors[0], colors[1], colors[2], colors[3]);
+}
+
+/**
+ * \name Cache of generated rgbw images.
+ *
+ * Texturing tests ask for the same rgbw pattern over and over, often once
+ * per internal format with an identical size. Images are kept for the life of
+ * the process, up to RGBW_IMAGE_CACHE_BUDGET bytes, and the least recently
+ * used entries are evicted first.
+ * \{
+ */
+#define RGBW_IMAGE_CACHE_ENTRIES 32
+#define RGBW_IMAGE_CACHE_BUDGET (4 * 1024 * 1024)
+
+static struct rgbw_image_cache_entry {
+	int w, h;
+	int solid_color;
+	GLboolean alpha;
+	GLenum basetype;
+	GLfloat *data;
+	unsigned last_use;
+} rgbw_image_cache[RGBW_IMAGE_CACHE_ENTRIES];
+static size_t rgbw_image_cache_size;
+static unsigned rgbw_image_cache_clock;
+
+/**
+ * Return the cached rgbw image, generating it if necessary.
+ *
+ * The returned data is owned by the cache. NULL is returned if the image is
+ * too large to be cached, or on allocation failure.
+ */
+static const GLfloat *
+rgbw_image_cached(GLenum internalFormat, int w, int h,
+		  GLboolean alpha, GLenum basetype)
+{
+	const int solid_color = rgbw_image_solid_color(internalFormat, w, h);
+	const size_t size = (size_t) w * h * 4 * sizeof(GLfloat);
+	struct rgbw_image_cache_entry *entry = NULL;
+	int i;
+
+	for (i = 0; i < RGBW_IMAGE_CACHE_ENTRIES; i++) {
+		struct rgbw_image_cache_entry *e = &rgbw_image_cache[i];
+
+		if (e->data && e->w == w && e->h == h &&
+		    e->solid_color == solid_color && e->alpha == alpha &&
+		    e->basetype == basetype) {
+			e->last_use = ++rgbw_image_cache_clock;
+			return e->data;
+		}
+	}
+
+	if (size > RGBW_IMAGE_CACHE_BUDGET)
+		return NULL;
+
+	/* Evict least recently used entries until there is room. */
+	for (;;) {
+		struct rgbw_image_cache_entry *lru = NULL;
+
+		entry = NULL;
+		for (i = 0; i < RGBW_IMAGE_CACHE_ENTRIES; i++) {
+			struct rgbw_image_cache_entry *e = &rgbw_image_cache[i];
+
+			if (!e->data)
+				entry = e;
+			else if (!lru || e->last_use < lru->last_use)
+				lru = e;
+		}
+
+		if (entry &&
+		    rgbw_image_cache_size + size <= RGBW_IMAGE_CACHE_BUDGET)
+			break;
+
+		rgbw_image_cache_size -= (size_t) lru->w * lru->h * 4 *
+					 sizeof(GLfloat);
+		free(lru->data);
+		lru->data = NULL;
+	}
+
+	entry->data = malloc(size);
+	if (!entry->data)
+		return NULL;
+
+	rgbw_image_fill(entry->data, solid_color, w, h, alpha, basetype);
+	entry->w = w;
+	entry->h = h;
+	entry->solid_color = solid_color;
+	entry->alpha = alpha;
+	entry->basetype = basetype;
+	entry->last_use = ++rgbw_image_cache_clock;
+	rgbw_image_cache_size += size;
+
+	return entry->data;
+}
+/** \} */
+
 /**
  * Generates an image of the given size with quadrants of red, green,
  * blue and white.
@@ -2654,109 +2880,30 @@ GLfloat *
 piglit_rgbw_image(GLenum internalFormat, int w, int h,
 		  GLboolean alpha, GLenum basetype)
 {
-	float red[4]   = {1.0, 0.0, 0.0, 0.0};
-	float green[4] = {0.0, 1.0, 0.0, 0.25};
-	float blue[4]  = {0.0, 0.0, 1.0, 0.5};
-	float white[4] = {1.0, 1.0, 1.0, 1.0};
+	const size_t size = (size_t) w * h * 4 * sizeof(GLfloat);
+	const GLfloat *cached;
 	GLfloat *data;
-	int x, y;
-
-	if (!alpha) {
-		red[3] = 1.0;
-		green[3] = 1.0;
-		blue[3] = 1.0;
-		white[3] = 1.0;
-	}
-
-	switch (basetype) {
-	case GL_UNSIGNED_NORMALIZED:
-		break;
 
-	case GL_SIGNED_NORMALIZED:
-		for (x = 0; x < 4; x++) {
-			red[x] = red[x] * 2 - 1;
-			green[x] = green[x] * 2 - 1;
-			blue[x] = blue[x] * 2 - 1;
-			white[x] = white[x] * 2 - 1;
-		}
-		break;
+	data = malloc(size);
 
-	case GL_FLOAT:
-		for (x = 0; x < 4; x++) {
-			red[x] = red[x] * 10 - 5;
-			green[x] = green[x] * 10 - 5;
-			blue[x] = blue[x] * 10 - 5;
-			white[x] = white[x] * 10 - 5;
-		}
-		break;
-
-	default:
-		assert(0);
-	}
-
-	data = malloc(w * h * 4 * sizeof(GLfloat));
-
-	for (y = 0; y < h; y++) {
-		for (x = 0; x < w; x++) {
-			const int size = w > h ? w : h;
-			const float *color;
-
-			if (x < w / 2 && y < h / 2)
-				color = red;
-			else if (y < h / 2)
-				color = green;
-			else if (x < w / 2)
-				color = blue;
-			else
-				color = white;
-
-			switch (internalFormat) {
-			case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
-			case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
-			case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
-			case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
-			case GL_COMPRESSED_RGB_FXT1_3DFX:
-			case GL_COMPRESSED_RGBA_FXT1_3DFX:
-			case GL_COMPRESSED_RED_RGTC1:
-			case GL_COMPRESSED_SIGNED_RED_RGTC1:
-			case GL_COMPRESSED_RG_RGTC2:
-			case GL_COMPRESSED_SIGNED_RG_RGTC2:
-			case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
-			case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
-			case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
-			case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
-			case GL_COMPRESSED_RGBA_BPTC_UNORM:
-			case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
-			case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
-			case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
-				if (size == 4)
-					color = red;
-				else if (size == 2)
-					color = green;
-				else if (size == 1)
-					color = blue;
-				break;
-			default:
-				break;
-			}
-
-			memcpy(data + (y * w + x) * 4, color,
-			       4 * sizeof(float));
-		}
-	}
+	cached = rgbw_image_cached(internalFormat, w, h, alpha, basetype);
+	if (cached)
+		memcpy(data, cached, size);
+	else
+		rgbw_image_fill(data,
+				rgbw_image_solid_color(internalFormat, w, h),
+				w, h, alpha, basetype);
 
 	return data;
 }
 
-GLubyte *
-piglit_rgbw_image_ubyte(int w, int h, GLboolean alpha)
+static void
+rgbw_image_ubyte_fill(GLubyte *data, int w, int h, GLboolean alpha)
 {
 	GLubyte red[4]   = {255, 0, 0, 0};
 	GLubyte green[4] = {0, 255, 0, 64};
 	GLubyte blue[4]  = {0, 0, 255, 128};
 	GLubyte white[4] = {255, 255, 255, 255};
-	GLubyte *data;
-	int x, y;
 
 	if (!alpha) {
 		red[3] = 255;
@@ -2765,25 +2912,16 @@ piglit_rgbw_image_ubyte(int w, int h, GLboolean alpha)
 		white[3] = 255;
 	}
 
-	data = malloc(w * h * 4 * sizeof(GLubyte));
+	fill_quadrants(data, sizeof(red), w, h, red, green, blue, white);
+}
 
-	for (y = 0; y < h; y++) {
-		for (x = 0; x < w; x++) {
-			const GLubyte *color;
-
-			if (x < w / 2 && y < h / 2)
-				color = red;
-			else if (y < h / 2)
-				color = green;
-			else if (x < w / 2)
-				color = blue;
-			else
-				color = white;
+GLubyte *
+piglit_rgbw_image_ubyte(int w, int h, GLboolean alpha)
+{
+	GLubyte *data;
 
-			memcpy(data + (y * w + x) * 4, color,
-			       4 * sizeof(GLubyte));
-		}
-	}
+	data = malloc(w * h * 4 * sizeof(GLubyte));
+	rgbw_image_ubyte_fill(data, w, h, alpha);
 
 	return data;
 }
@@ -2803,6 +2941,7 @@ piglit_rgbw_texture(GLenum internalFormat, int w, int h, GLboolean mip,
 	int size, level;
 	GLuint tex;
 	GLenum teximage_type;
+	void *staging = NULL;
 
 	switch (basetype) {
 	case GL_UNSIGNED_NORMALIZED:
@@ -2835,19 +2974,34 @@ piglit_rgbw_texture(GLenum internalFormat, int w, int h, GLboolean mip,
 	}
 
 	for (level = 0, size = w > h ? w : h; size > 0; level++, size >>= 1) {
-		void *data;
+		const void *data = NULL;
 
-		if (teximage_type == GL_UNSIGNED_BYTE)
-			data = piglit_rgbw_image_ubyte(w, h, alpha);
-		else
-			data = piglit_rgbw_image(internalFormat, w, h,
-			                         alpha, basetype);
+		if (teximage_type == GL_FLOAT)
+			data = rgbw_image_cached(internalFormat, w, h,
+						 alpha, basetype);
+
+		/*
+		 * Levels that aren't cached are built in a single staging
+		 * buffer sized for level 0 and reused for the smaller levels.
+		 */
+		if (!data) {
+			if (!staging)
+				staging = malloc(w * h * 4 * sizeof(GLfloat));
+
+			if (teximage_type == GL_UNSIGNED_BYTE)
+				rgbw_image_ubyte_fill(staging, w, h, alpha);
+			else
+				rgbw_image_fill(staging,
+						rgbw_image_solid_color(
+							internalFormat, w, h),
+						w, h, alpha, basetype);
+			data = staging;
+		}
 
 		glTexImage2D(GL_TEXTURE_2D, level,
 			     internalFormat,
 			     w, h, 0,
 			     GL_RGBA, teximage_type, data);
-		free(data);
 
 		if (!mip)
 			break;
@@ -2858,6 +3012,7 @@ piglit_rgbw_texture(GLenum internalFormat, int w, int h, GLboolean mip,
 			h >>= 1;
 	}
 
+	free(staging);
 	return tex;
 }
 
@@ -3024,6 +3179,7 @@ piglit_depth_texture(GLenum target, GLenum internalformat, int w, int h, int d,
 	float *f = NULL, *f2 = NULL;
 	unsigned int  *i = NULL;
 	int size, x, y, level, layer;
+	size_t texel_size;
 	GLuint tex;
 	GLenum type, format;
 
@@ -3058,19 +3214,25 @@ piglit_depth_texture(GLenum target, GLenum internalformat, int w, int h, int d,
 		type = GL_FLOAT;
 		f = data;
 	}
+	texel_size = f2 ? 2 * sizeof(float) : sizeof(float);
 
 	for (level = 0, size = w > h ? w : h; size > 0; level++, size >>= 1) {
-		for (y = 0; y < h; y++) {
-			for (x = 0; x < w; x++) {
-				float val = (float)(x) / (w - 1);
-				if (f)
-					f[y * w + x] = val;
-				else if (f2)
-					f2[(y * w + x)*2] = val;
-				else if (i)
-					i[y * w + x] = 0xffffff00 * val;
-			}
+		/*
+		 * Every row holds the same gradient, so build the first one
+		 * and replicate it.
+		 */
+		for (x = 0; x < w; x++) {
+			float val = (float)(x) / (w - 1);
+			if (f)
+				f[x] = val;
+			else if (f2)
+				f2[x * 2] = val;
+			else if (i)
+				i[x] = 0xffffff00 * val;
 		}
+		for (y = 1; y < h; y++)
+			memcpy((uint8_t *) data + y * w * texel_size, data,
+			       w * texel_size);
 
 		switch (target) {
 		case GL_TEXTURE_1D:
@@ -3170,24 +3332,26 @@ piglit_array_texture(GLenum target, GLenum internalformat,
 				     w, h, d, 0, format, type, NULL);
 		}
 
-		for (layer = 0; layer < d; layer++) {
-			/* Set whole layer to one color */
-			for (i = 0; i < w * h; i++) {
-				memcpy(data + 4 * i,
-				       color_wheel[layer %
-						   ARRAY_SIZE(color_wheel)],
-				       sizeof(color_wheel[0]));
-			}
-
-			if (target == GL_TEXTURE_1D_ARRAY) {
-				glTexSubImage2D(target, level,
-						0, layer, w, 1,
-						format, type, data);
-			}
-			else {
-				glTexSubImage3D(target, level,
-						0, 0, layer, w, h, 1,
-						format, type, data);
+		/*
+		 * Fill the staging buffer once per color and upload every
+		 * layer using that color from it.
+		 */
+		for (i = 0; i < MIN2(d, (int) ARRAY_SIZE(color_wheel)); i++) {
+			fill_texels(data, color_wheel[i],
+				    sizeof(color_wheel[0]), w * h);
+
+			for (layer = i; layer < d;
+			     layer += ARRAY_SIZE(color_wheel)) {
+				if (target == GL_TEXTURE_1D_ARRAY) {
+					glTexSubImage2D(target, level,
+							0, layer, w, 1,
+							format, type, data);
+				}
+				else {
+					glTexSubImage3D(target, level,
+							0, 0, layer, w, h, 1,
+							format, type, data);
+				}
 			}
 		}
 
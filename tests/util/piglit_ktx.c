@@ -26,6 +26,16 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "config.h"
+#if defined(HAVE_FCNTL_H) && defined(HAVE_SYS_STAT_H) && defined(HAVE_SYS_TYPES_H) && defined(HAVE_UNISTD_H) && !defined(_WIN32)
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <sys/mman.h>
+# include <fcntl.h>
+# include <unistd.h>
+# define USE_MMAP
+#endif
+
 #include "piglit_ktx.h"
 #include "piglit-util-gl.h"
 
@@ -68,6 +78,22 @@ struct piglit_ktx {
 	/** \brief The raw KTX data. */
 	void *data;
 
+	/**
+	 * \brief Length of the mapping if data was mmap'd, otherwise 0.
+	 *
+	 * This is kept separately from piglit_ktx_info::size because that is
+	 * trimmed to the actual data size once the images are parsed.
+	 */
+	size_t mapped_size;
+
+	/**
+	 * \brief Whether the images are being sourced from a pixel unpack
+	 * buffer holding a copy of data.
+	 *
+	 * Only set during piglit_ktx_load_texture().
+	 */
+	bool upload_from_pbo;
+
 	/**
 	 * \brief Array of images.
 	 *
@@ -99,8 +125,14 @@ piglit_ktx_destroy(struct piglit_ktx *self)
 	if (self->images != NULL)
 		free(self->images);
 
-	if (self->data)
-		free(self->data);
+	if (self->data) {
+#ifdef USE_MMAP
+		if (self->mapped_size != 0)
+			munmap(self->data, self->mapped_size);
+		else
+#endif
+			free(self->data);
+	}
 
 	free(self);
 }
@@ -422,6 +454,41 @@ piglit_ktx_parse_data(struct piglit_ktx *self)
 	return ok;
 }
 
+#ifdef USE_MMAP
+/**
+ * \brief Map the file rather than copying it to the heap.
+ *
+ * Return false if the file could not be mapped, in which case the caller
+ * falls back to reading it with stdio.
+ */
+static bool
+piglit_ktx_map_file(struct piglit_ktx *self, const char *filename)
+{
+	struct stat st;
+	void *map;
+	int fd;
+
+	fd = open(filename, O_RDONLY);
+	if (fd == -1)
+		return false;
+
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		return false;
+	}
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return false;
+
+	self->data = map;
+	self->mapped_size = st.st_size;
+	self->info.size = st.st_size;
+	return true;
+}
+#endif
+
 struct piglit_ktx*
 piglit_ktx_read_file(const char *filename)
 {
@@ -437,6 +504,13 @@ piglit_ktx_read_file(const char *filename)
 	if (self == NULL)
 		goto out_of_memory;
 
+#ifdef USE_MMAP
+	if (piglit_ktx_map_file(self, filename)) {
+		ok = piglit_ktx_parse_data(self);
+		goto end;
+	}
+#endif
+
 	file = fopen(filename, "rb");
 	if (file == NULL)
 		goto bad_open;
@@ -453,10 +527,6 @@ piglit_ktx_read_file(const char *filename)
 	if (self->data == NULL)
 		goto out_of_memory;
 
-	/*
-	 * On Unix, one should mmap() here rather than copy. But this code
-	 * needs to support Windows too.
-	 */
 	size_read = fread(self->data, 1, self->info.size, file);
 	if (size_read < self->info.size)
 		goto bad_read;
@@ -503,6 +573,13 @@ ktx_file_read_bytes(const void *bytes , size_t size)
 		return NULL;
 	}
 
+	self->data = malloc(size);
+	if (self->data == NULL) {
+		piglit_ktx_error("%s", "out of memory");
+		piglit_ktx_destroy(self);
+		return NULL;
+	}
+
 	self->info.size = size;
 	memcpy(self->data, bytes, size);
 
@@ -586,6 +663,24 @@ piglit_ktx_get_image(struct piglit_ktx *self,
 		return &self->images[miplevel];
 }
 
+/**
+ * \brief Return the pointer to pass as the 'data' argument of glTexImage().
+ *
+ * When the images are sourced from a pixel unpack buffer, this is the
+ * image's offset into the buffer.
+ */
+static const void *
+piglit_ktx_image_src(const struct piglit_ktx *self,
+		     const struct piglit_ktx_image *img)
+{
+	if (self->upload_from_pbo)
+		return (const void *)(uintptr_t)
+			((const uint8_t *) img->data -
+			 (const uint8_t *) self->data);
+	else
+		return img->data;
+}
+
 static bool
 piglit_ktx_load_cubeface(struct piglit_ktx *self,
                          int image,
@@ -605,7 +700,7 @@ piglit_ktx_load_cubeface(struct piglit_ktx *self,
 				       img->pixel_height,
 				       0 /*border*/,
 				       img->size,
-				       img->data);
+				       piglit_ktx_image_src(self, img));
 	else
 		glTexImage2D(face,
 			     level,
@@ -615,7 +710,7 @@ piglit_ktx_load_cubeface(struct piglit_ktx *self,
 			     0 /*border*/,
 			     info->gl_format,
 			     info->gl_type,
-			     img->data);
+			     piglit_ktx_image_src(self, img));
 
 	*gl_error = glGetError();
 	return *gl_error == 0;
@@ -644,7 +739,7 @@ piglit_ktx_load_noncubeface(struct piglit_ktx *self,
 					       img->pixel_width,
 					       0 /*border*/,
 					       img->size,
-					       img->data);
+					       piglit_ktx_image_src(self, img));
 		else
 			glTexImage1D(info->target,
 				     level,
@@ -653,7 +748,7 @@ piglit_ktx_load_noncubeface(struct piglit_ktx *self,
 				     0 /*border*/,
 				     info->gl_format,
 				     info->gl_type,
-				     img->data);
+				     piglit_ktx_image_src(self, img));
 		break;
 	case GL_TEXTURE_1D_ARRAY:
 	case GL_TEXTURE_2D:
@@ -666,7 +761,7 @@ piglit_ktx_load_noncubeface(struct piglit_ktx *self,
 					       img->pixel_height,
 					       0 /*border*/,
 					       img->size,
-					       img->data);
+					       piglit_ktx_image_src(self, img));
 		else
 			glTexImage2D(info->target,
 				     level,
@@ -676,7 +771,7 @@ piglit_ktx_load_noncubeface(struct piglit_ktx *self,
 				     0 /*border*/,
 				     info->gl_format,
 				     info->gl_type,
-				     img->data);
+				     piglit_ktx_image_src(self, img));
 		break;
 	case GL_TEXTURE_CUBE_MAP_ARRAY:
 		if (piglit_is_gles())
@@ -695,7 +790,7 @@ piglit_ktx_load_noncubeface(struct piglit_ktx *self,
 					       img->pixel_depth,
 					       0 /*border*/,
 					       img->size,
-					       img->data);
+					       piglit_ktx_image_src(self, img));
 		else
 			glTexImage3D(info->target,
 				     level,
@@ -706,7 +801,7 @@ piglit_ktx_load_noncubeface(struct piglit_ktx *self,
 				     0 /*border*/,
 				     info->gl_format,
 				     info->gl_type,
-				     img->data);
+				     piglit_ktx_image_src(self, img));
 		break;
 	default:
 		*gl_error = 0;
@@ -736,6 +831,19 @@ piglit_ktx_load_image(struct piglit_ktx *self,
 		return piglit_ktx_load_noncubeface(self, image, gl_error);
 }
 
+/**
+ * \brief Whether the context can source texture images from a buffer object.
+ */
+static bool
+piglit_ktx_can_use_pbo(void)
+{
+	if (piglit_is_gles())
+		return piglit_get_gl_version() >= 30;
+
+	return piglit_get_gl_version() >= 21 ||
+	       piglit_is_extension_supported("GL_ARB_pixel_buffer_object");
+}
+
 static GLuint
 target_to_texture_binding(GLuint target)
 {
@@ -789,6 +897,13 @@ piglit_ktx_load_texture(struct piglit_ktx *self,
 	 */
 	GLint old_unpack_alignment;
 
+	/*
+	 * The pixel unpack buffer bound before this function call, and the
+	 * buffer the images are uploaded from, if any.
+	 */
+	GLint old_unpack_buffer = 0;
+	GLuint pbo = 0;
+
 	bool made_texture = false;
 
 	bool ok = true;
@@ -804,6 +919,29 @@ piglit_ktx_load_texture(struct piglit_ktx *self,
 	while (glGetError())
 		;
 
+	/*
+	 * Copy the whole file data, which may be mmap'd, into a pixel unpack
+	 * buffer with a single glBufferData(), then source each glTexImage()
+	 * from its offset in the buffer. This replaces one transfer per
+	 * level from client memory by one bulk copy.
+	 */
+	if (piglit_ktx_can_use_pbo()) {
+		glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING,
+			      &old_unpack_buffer);
+		glGenBuffers(1, &pbo);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, info->size, self->data,
+			     GL_STREAM_DRAW);
+
+		if (glGetError() == GL_NO_ERROR) {
+			self->upload_from_pbo = true;
+		} else {
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, old_unpack_buffer);
+			glDeleteBuffers(1, &pbo);
+			pbo = 0;
+		}
+	}
+
 	if (*tex_name == 0) {
 		glGenTextures(1, tex_name);
 		made_texture = true;
@@ -842,6 +980,12 @@ cleanup:
 	while (glGetError())
 		;;
 
+	if (pbo != 0) {
+		self->upload_from_pbo = false;
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, old_unpack_buffer);
+		glDeleteBuffers(1, &pbo);
+	}
+
 	glBindTexture(info->target, old_bound_tex);
 	glPixelStorei(GL_UNPACK_ALIGNMENT, old_unpack_alignment);
 	return ok;
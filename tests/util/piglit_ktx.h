@@ -191,7 +191,9 @@ piglit_ktx_destroy(struct piglit_ktx *self);
 /**
  * \brief Read KTX data from a file.
  *
- * The file is read until EOF.
+ * The file is read until EOF. Where supported, the file is mapped rather
+ * than copied to the heap, so it must not be modified while the returned
+ * object is alive.
  *
  * Return null on error, including I/O error and invalid data.
  */
@@ -257,6 +259,10 @@ piglit_ktx_get_image(struct piglit_ktx *self,
  * glTexImage().  If \a *tex_name is 0, then a new texture is first created.
  * The new texture name is returned \a tex_name.
  *
+ * If the context supports pixel buffer objects, the images are sourced from a
+ * temporary GL_PIXEL_UNPACK_BUFFER. The previous unpack buffer binding is
+ * restored before returning.
+ *
  * Return false on failure. If failure is due to a GL error and \a gl_error is
  * not null, then the value of glGetError() is returned in \a gl_error.
  */
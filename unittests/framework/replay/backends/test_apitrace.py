@@ -37,6 +37,7 @@ from framework import core
 from framework import exceptions
 from framework.replay import backends
 from framework.replay.options import OPTIONS
+from framework.replay.trace_index import TraceIndex
 
 
 @pytest.yield_fixture
@@ -251,6 +252,41 @@ class TestAPITraceBackend(object):
         for call in calls.split(','):
             assert path.exists(snapshot_prefix + call.zfill(10) + '.png')
 
+    def test_dump_gl_indexed(self):
+        """Tests for the dump method: the last frame comes from the index.
+
+        Check that the trace is only scanned for its last frame the first
+        time it is dumped, and that the frame boundaries are stored.
+
+        """
+        calls = self.gl_trace_last_call
+        trace_path = self.gl_trace_path
+        self.tmpdir.join('db-path', 'glxgears').ensure(dir=True)
+        with open(trace_path, 'wb') as f:
+            f.write(b'trace content')
+        self.env['PIGLIT_REPLAY_INDEX_DIR'] = self.tmpdir.join(
+            'index').strpath
+        get_last_call = self.mocker.call(
+            [self.apitrace, 'dump', '--calls=frame', trace_path],
+            stdout=subprocess.PIPE, stderr=sys.stderr)
+
+        test = backends.apitrace.APITraceBackend(trace_path)
+        assert test.dump()
+        test = backends.apitrace.APITraceBackend(trace_path)
+        assert test.dump()
+        assert self.m_apitrace_subprocess_run.call_count == 3
+        assert self.m_apitrace_subprocess_run.call_args_list.count(
+            get_last_call) == 1
+        self.m_apitrace_subprocess_run.assert_called_with(
+            [self.eglretrace, '--headless',
+             '--snapshot=' + calls,
+             '--snapshot-prefix=' + trace_path + '-', trace_path],
+            env=None, stdout=subprocess.PIPE, stderr=sys.stderr)
+
+        index = TraceIndex.for_trace(trace_path)
+        assert index.get('frames') == [int(calls) - 50, int(calls)]
+        assert index.get('frame_count') == 2
+
     def test_dump_gl_calls(self):
         """Tests for the dump method: explicit valid calls.
 
@@ -27,15 +27,20 @@
 
 import pytest
 
+import gzip
+import hashlib
+import http.server
 import os
 import requests
 import requests_mock
+import threading
 from urllib.parse import urlparse
 
 from os import path
 
 from framework import exceptions
 from framework.replay import download_utils
+from framework.replay import trace_cache
 from framework.replay.options import OPTIONS
 
 ASSUME_ROLE_RESPONSE = '''<?xml version="1.0" encoding="UTF-8"?>
@@ -56,13 +61,16 @@ class TestDownloadUtils(object):
     """Tests for download_utils methods."""
 
     @pytest.fixture(autouse=True)
-    def setup(self, requests_mock, tmpdir):
+    def setup(self, requests_mock, tmpdir, mocker):
+        mocker.patch.dict('os.environ', {
+            'PIGLIT_REPLAY_CACHE_DIR': tmpdir.join('cache').strpath})
         self.url = 'https://unittest.piglit.org/'
         self.trace_path = 'KhronosGroup-Vulkan-Tools/amd/polaris10/vkcube.gfxr'
         self.full_url = self.url + self.trace_path
         self.trace_file = tmpdir.join(self.trace_path)
         OPTIONS.set_download_url(self.url)
         OPTIONS.download['force'] = False
+        OPTIONS.download['minio_host'] = ''
         OPTIONS.db_path = tmpdir.strpath
         requests_mock.get(self.full_url, text='remote')
 
@@ -141,3 +149,178 @@ class TestDownloadUtils(object):
         get_request = requests_mock.request_history[1]
         assert(get_request.method == 'GET')
         assert(requests_mock.request_history[1].headers['Authorization'].startswith('AWS Key'))
+
+    def test_ensure_file_cached(self, requests_mock):
+        """download_utils.ensure_file: Check a cached file isn't downloaded again"""
+
+        download_utils.ensure_file(self.trace_path)
+        self.trace_file.remove()
+        download_utils.ensure_file(self.trace_path)
+        TestDownloadUtils.check_same_file(self.trace_file, "remote")
+        assert requests_mock.call_count == 1
+
+    def test_ensure_file_no_cache(self, mocker, tmpdir):
+        """download_utils.ensure_file: Check downloading with the cache disabled leaves no partial files"""
+
+        mocker.patch.dict('os.environ', {'PIGLIT_REPLAY_CACHE_DIR': ''})
+        download_utils.ensure_file(self.trace_path)
+        TestDownloadUtils.check_same_file(self.trace_file, "remote")
+        assert os.listdir(path.dirname(self.trace_file)) == ['vkcube.gfxr']
+        assert not tmpdir.join('cache').check()
+
+    def test_ensure_file_etag_mismatch(self, requests_mock):
+        """download_utils.ensure_file: Check a download not matching its md5 ETag is rejected"""
+
+        etag = '"{}"'.format(hashlib.md5(b'other').hexdigest())
+        requests_mock.get(self.full_url, text='remote',
+                          headers={'ETag': etag})
+        with pytest.raises(exceptions.PiglitFatalError):
+            download_utils.ensure_file(self.trace_path)
+        assert not self.trace_file.check()
+
+    def test_ensure_file_incomplete(self, requests_mock):
+        """download_utils.ensure_file: Check a truncated download is rejected"""
+
+        requests_mock.get(self.full_url, text='remote',
+                          headers={'Content-Length': '100'})
+        with pytest.raises(exceptions.PiglitFatalError):
+            download_utils.ensure_file(self.trace_path)
+        assert not self.trace_file.check()
+
+    def test_ensure_file_content_encoding(self, requests_mock):
+        """download_utils.ensure_file: Check a body with a Content-Encoding is checked and stored as sent"""
+
+        body = gzip.compress(b'remote')
+        requests_mock.get(self.full_url, content=body,
+                          headers={'Content-Encoding': 'gzip',
+                                   'Content-Length': str(len(body)),
+                                   'ETag': '"{}"'.format(
+                                       hashlib.md5(body).hexdigest())})
+        download_utils.ensure_file(self.trace_path)
+        assert self.trace_file.read_binary() == body
+        assert requests_mock.last_request.headers['Accept-Encoding'] == \
+            'identity'
+
+    def test_ensure_file_empty_conf_no_cache(self, mocker, tmpdir):
+        """download_utils.ensure_file: Check an empty [replay]:cache_dir disables the cache"""
+
+        mocker.patch.dict('os.environ')
+        del os.environ['PIGLIT_REPLAY_CACHE_DIR']
+        mocker.patch('framework.core.PIGLIT_CONFIG.safe_get',
+                     mocker.Mock(return_value=''))
+        download_utils.ensure_file(self.trace_path)
+        TestDownloadUtils.check_same_file(self.trace_file, "remote")
+        assert not tmpdir.join('cache').check()
+
+
+class _RangeHandler(http.server.BaseHTTPRequestHandler):
+    """Serves the files of the server with Range and ETag support."""
+
+    def do_GET(self):
+        content = self.server.files.get(self.path)
+        self.server.requests.append(dict(self.headers))
+        if content is None:
+            self.send_error(404)
+            return
+
+        etag = '"{}"'.format(hashlib.md5(content).hexdigest())
+        start = 0
+        byte_range = self.headers.get('Range')
+        if byte_range and self.headers.get('If-Range', etag) == etag:
+            start = int(byte_range[len('bytes='):].split('-')[0])
+            self.send_response(206)
+            self.send_header('Content-Range', 'bytes {}-{}/{}'.format(
+                start, len(content) - 1, len(content)))
+        else:
+            self.send_response(200)
+        self.send_header('ETag', etag)
+        self.send_header('Content-Length', str(len(content) - start))
+        self.end_headers()
+        self.wfile.write(content[start:])
+
+    def log_message(self, *args):
+        pass
+
+
+class TestDownloadUtilsHTTPServer(object):
+    """Tests for download_utils against a local HTTP server."""
+
+    @pytest.fixture(autouse=True)
+    def setup(self, tmpdir, mocker):
+        self.cache_dir = tmpdir.join('cache').strpath
+        mocker.patch.dict('os.environ',
+                          {'PIGLIT_REPLAY_CACHE_DIR': self.cache_dir})
+        self.server = http.server.ThreadingHTTPServer(('127.0.0.1', 0),
+                                                      _RangeHandler)
+        self.server.files = {}
+        self.server.requests = []
+        thread = threading.Thread(target=self.server.serve_forever)
+        thread.start()
+
+        self.url = 'http://127.0.0.1:{}/'.format(self.server.server_port)
+        self.trace_path = 'pathfinder/demo.trace'
+        self.content = bytes(range(256)) * 64
+        self.server.files['/' + self.trace_path] = self.content
+        self.trace_file = tmpdir.join('db', self.trace_path)
+        OPTIONS.set_download_url(self.url)
+        OPTIONS.download['force'] = False
+        OPTIONS.download['minio_host'] = ''
+        OPTIONS.db_path = tmpdir.join('db').strpath
+
+        yield
+
+        self.server.shutdown()
+        self.server.server_close()
+        thread.join()
+
+    def test_download(self):
+        """download_utils.ensure_file: Check a file is downloaded into the cache"""
+
+        download_utils.ensure_file(self.trace_path)
+        assert self.trace_file.read_binary() == self.content
+        sha256 = hashlib.sha256(self.content).hexdigest()
+        cache = trace_cache.TraceCache(self.cache_dir)
+        assert os.path.exists(cache.blob_path(sha256))
+
+    def test_resume(self):
+        """download_utils.ensure_file: Check an interrupted download is resumed"""
+
+        cache = trace_cache.TraceCache(self.cache_dir)
+        part_file = cache.partial_file(self.url + self.trace_path)
+        with open(part_file, 'wb') as f:
+            f.write(self.content[:1000])
+        with open(part_file + '.json', 'w') as f:
+            f.write('{{"etag": "\\"{}\\""}}'.format(
+                hashlib.md5(self.content).hexdigest()))
+
+        download_utils.ensure_file(self.trace_path)
+        assert self.trace_file.read_binary() == self.content
+        assert self.server.requests[-1]['Range'] == 'bytes=1000-'
+        assert not os.path.exists(part_file)
+
+    def test_resume_changed(self):
+        """download_utils.ensure_file: Check a partial download of older content is discarded"""
+
+        cache = trace_cache.TraceCache(self.cache_dir)
+        part_file = cache.partial_file(self.url + self.trace_path)
+        with open(part_file, 'wb') as f:
+            f.write(b'stale' * 100)
+        with open(part_file + '.json', 'w') as f:
+            f.write('{"etag": "\\"0123\\""}')
+
+        download_utils.ensure_file(self.trace_path)
+        assert self.trace_file.read_binary() == self.content
+
+    def test_concurrent(self):
+        """download_utils.ensure_file: Check concurrent jobs download a file once"""
+
+        threads = [threading.Thread(target=download_utils.ensure_file,
+                                    args=(self.trace_path,))
+                   for _ in range(4)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+
+        assert self.trace_file.read_binary() == self.content
+        assert len(self.server.requests) == 1
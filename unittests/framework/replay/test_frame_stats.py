@@ -0,0 +1,146 @@
+# coding=utf-8
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+# OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+# ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+# OTHER DEALINGS IN THE SOFTWARE.
+#
+# SPDX-License-Identifier: MIT
+
+
+"""Tests for replayer's frame_stats module."""
+
+import json
+
+import pytest
+
+from framework import exceptions
+from framework import status
+from framework.replay import frame_stats
+
+# pylint: disable=no-self-use
+
+
+def _stats(median, mad=0.0, p99=None):
+    return {'median': median, 'mad': mad,
+            'p99': p99 if p99 is not None else median}
+
+
+class TestTrimWarmup(object):
+    """Tests for frame_stats.trim_warmup."""
+
+    def test_default(self, mocker):
+        """frame_stats.trim_warmup: drops 10% of the frames by default"""
+        mocker.patch('framework.replay.frame_stats.core.get_option',
+                     return_value=None)
+        assert frame_stats.trim_warmup(list(range(20))) == list(range(2, 20))
+
+    def test_explicit(self):
+        """frame_stats.trim_warmup: drops the given number of frames"""
+        assert frame_stats.trim_warmup([5, 4, 3, 2], 3) == [2]
+
+    def test_keeps_one(self):
+        """frame_stats.trim_warmup: always keeps at least one frame"""
+        assert frame_stats.trim_warmup([5, 4], 10) == [4]
+
+    def test_option(self, mocker):
+        """frame_stats.trim_warmup: PIGLIT_REPLAY_WARMUP_FRAMES is honoured"""
+        mocker.patch.dict('os.environ', {'PIGLIT_REPLAY_WARMUP_FRAMES': '1'})
+        assert frame_stats.trim_warmup([3, 2, 1]) == [2, 1]
+
+
+class TestSummarize(object):
+    """Tests for frame_stats.summarize."""
+
+    def test_empty(self):
+        """frame_stats.summarize: no stats without frames"""
+        assert frame_stats.summarize([]) is None
+
+    def test_values(self):
+        """frame_stats.summarize: percentiles and stutter"""
+        stats = frame_stats.summarize([10] * 98 + [30, 40])
+        assert stats['frames'] == 100
+        assert stats['median'] == 10
+        assert stats['p95'] == 10
+        assert stats['p99'] == pytest.approx(30.1)
+        assert stats['max'] == 40
+        assert stats['mad'] == 0
+        assert stats['stutter_frames'] == 2
+        assert stats['stutter_ratio'] == pytest.approx(0.02)
+
+
+class TestCompare(object):
+    """Tests for frame_stats.compare."""
+
+    @pytest.mark.parametrize('median, expected', [
+        (100, status.PASS),
+        (90, status.PASS),
+        (104, status.PASS),
+        (107, status.WARN),
+        (115, status.FAIL),
+    ])
+    def test_thresholds(self, median, expected):
+        """frame_stats.compare: relative thresholds without noise"""
+        result, _ = frame_stats.compare(_stats(median), _stats(100),
+                                        warn_threshold=5, fail_threshold=10)
+        assert result is expected
+
+    def test_noise(self):
+        """frame_stats.compare: changes within the noise don't fail"""
+        result, _ = frame_stats.compare(_stats(115, mad=5), _stats(100, mad=5),
+                                        warn_threshold=5, fail_threshold=10)
+        assert result is status.PASS
+        result, _ = frame_stats.compare(_stats(130, mad=5), _stats(100, mad=5),
+                                        warn_threshold=5, fail_threshold=10)
+        assert result is status.WARN
+
+    def test_stutter(self):
+        """frame_stats.compare: a p99 regression alone warns"""
+        result, message = frame_stats.compare(
+            _stats(100, p99=150), _stats(100, p99=120),
+            warn_threshold=5, fail_threshold=10)
+        assert result is status.WARN
+        assert message.startswith('More stutter')
+
+
+class TestBaseline(object):
+    """Tests for frame_stats.Baseline."""
+
+    def test_missing(self, tmpdir):
+        """frame_stats.Baseline: a missing file is an empty baseline"""
+        baseline = frame_stats.Baseline(tmpdir.join('b.json').strpath)
+        assert baseline.get('device', 'a.trace') is None
+
+    def test_corrupt(self, tmpdir):
+        """frame_stats.Baseline: a corrupt file is an error"""
+        f = tmpdir.join('b.json')
+        f.write('{')
+        with pytest.raises(exceptions.PiglitFatalError):
+            frame_stats.Baseline(f.strpath)
+
+    def test_update(self, tmpdir):
+        """frame_stats.Baseline: updates keep the entries of other runs"""
+        f = tmpdir.join('b.json')
+        first = frame_stats.Baseline(f.strpath)
+        second = frame_stats.Baseline(f.strpath)
+        first.update('device', {'a.trace': _stats(1)})
+        second.update('device', {'b.trace': _stats(2)})
+
+        data = json.loads(f.read())
+        assert data['version'] == 1
+        assert data['devices']['device'] == {'a.trace': _stats(1),
+                                             'b.trace': _stats(2)}
+        assert second.get('device', 'a.trace') == _stats(1)
@@ -30,11 +30,13 @@ import pytest
 
 import contextlib
 import io
+import json
 
 from os import path
 
 from framework import exceptions, status
 from framework.replay import backends
+from framework.replay import frame_stats
 from framework.replay import frame_times
 from framework.replay.options import OPTIONS
 
@@ -88,8 +90,11 @@ class TestFrameTimes(object):
         OPTIONS.device_name = 'test-device'
         OPTIONS.db_path = tmpdir.mkdir('db-path').strpath
         OPTIONS.results_path = tmpdir.mkdir('results').strpath
+        OPTIONS.baseline_path = None
+        OPTIONS.update_baseline = False
         self.trace_path = 'pathfinder/demo.trace'
         self.exp_frame_times = [0, 1, 2, 3, 4, 5, 6, 7, 8, 9]
+        self.exp_stats = frame_stats.summarize(self.exp_frame_times[1:])
         self.results_partial_path = path.join('results/trace',
                                               OPTIONS.device_name)
         self.m_qty_load_yaml = mocker.patch(
@@ -125,7 +130,11 @@ class TestFrameTimes(object):
         self.m_ensure_file.assert_called_once()
         self.m_profile.assert_called_once()
         s = f.getvalue()
-        assert s == ('[frame_times] ' + str(len(self.exp_frame_times)) + '\n')
+        assert s == ('[frame_times] ' + str(len(self.exp_frame_times)) + '\n'
+                     '[frame_times] ' +
+                     frame_stats.format_stats(self.exp_stats) + '\n'
+                     'PIGLIT: {"subtest": {"' + self.trace_path +
+                     '": "pass"}}\n')
 
     def test_from_yaml_two_traces(self):
         """frame_times.from_yaml: profile using a YAML with more than one trace path"""
@@ -138,7 +147,11 @@ class TestFrameTimes(object):
         assert self.m_ensure_file.call_count == 1
         assert self.m_profile.call_count == 1
         s = f.getvalue()
-        assert s == ('[frame_times] ' + str(len(self.exp_frame_times)) + '\n')
+        assert s == ('[frame_times] ' + str(len(self.exp_frame_times)) + '\n'
+                     '[frame_times] ' +
+                     frame_stats.format_stats(self.exp_stats) + '\n'
+                     'PIGLIT: {"subtest": {"' + self.trace_path +
+                     '": "pass"}}\n')
 
     def test_trace_success(self):
         """frame_times.trace: profile a trace successfully"""
@@ -154,7 +167,8 @@ class TestFrameTimes(object):
         assert s.endswith('PIGLIT: '
                           '{"images": [{'
                           '"image_desc": "' + self.trace_path + '", '
-                          '"frame_times": ' + str(self.exp_frame_times) +
+                          '"frame_times": ' + str(self.exp_frame_times) + ', '
+                          '"frame_time_stats": ' + json.dumps(self.exp_stats) +
                           '}], "result": "pass"}\n')
 
     def test_trace_fail(self):
@@ -174,3 +188,47 @@ class TestFrameTimes(object):
                           '"image_desc": "' + fail_trace_path + '", '
                           '"frame_times": null'
                           '}], "result": "crash"}\n')
+
+    def test_trace_baseline_regression(self):
+        """frame_times.trace: fail when the frame times regress against the baseline"""
+
+        self.m_profile.side_effect = None
+        self.m_profile.return_value = [20000000] * 10
+        reference = frame_stats.summarize([10000000] * 10)
+        baseline = self.tmpdir.join('baseline.json')
+        baseline.write(json.dumps(
+            {'version': 1,
+             'devices': {OPTIONS.device_name: {self.trace_path: reference}}}))
+        OPTIONS.baseline_path = baseline.strpath
+        f = io.StringIO()
+        with contextlib.redirect_stdout(f):
+            assert (frame_times.trace(self.trace_path)
+                    is status.FAIL)
+        s = f.getvalue()
+        assert '[frame_times] Regression: median +100.0%' in s
+        assert s.endswith('"result": "fail"}\n')
+
+    def test_trace_baseline_missing_entry(self):
+        """frame_times.trace: pass when the baseline has no entry for the trace"""
+
+        baseline = self.tmpdir.join('baseline.json')
+        baseline.write(json.dumps({'version': 1, 'devices': {}}))
+        OPTIONS.baseline_path = baseline.strpath
+        f = io.StringIO()
+        with contextlib.redirect_stdout(f):
+            assert (frame_times.trace(self.trace_path)
+                    is status.PASS)
+
+    def test_trace_update_baseline(self):
+        """frame_times.trace: store the frame times in the baseline"""
+
+        baseline = self.tmpdir.join('baseline.json')
+        OPTIONS.baseline_path = baseline.strpath
+        OPTIONS.update_baseline = True
+        f = io.StringIO()
+        with contextlib.redirect_stdout(f):
+            assert (frame_times.trace(self.trace_path)
+                    is status.PASS)
+        data = json.loads(baseline.read())
+        assert (data['devices'][OPTIONS.device_name][self.trace_path] ==
+                self.exp_stats)
@@ -0,0 +1,180 @@
+# coding=utf-8
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+# OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+# ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+# OTHER DEALINGS IN THE SOFTWARE.
+#
+# SPDX-License-Identifier: MIT
+
+
+"""Tests for replayer's scheduler module."""
+
+import contextlib
+import io
+import threading
+import time
+
+import pytest
+
+from framework.replay import scheduler
+
+# pylint: disable=no-self-use
+
+
+class _Tracker(object):
+    """Records the peak number of concurrent calls."""
+
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.current = 0
+        self.peak = 0
+        self.active = set()
+        self.overlaps = []
+
+    def __call__(self, item, delay=0.02):
+        with self.lock:
+            self.current += 1
+            self.peak = max(self.peak, self.current)
+            self.overlaps.append((item, set(self.active)))
+            self.active.add(item)
+        time.sleep(delay)
+        with self.lock:
+            self.current -= 1
+            self.active.discard(item)
+        return item
+
+
+class TestRun(object):
+    """Tests for scheduler.run."""
+
+    def test_empty(self):
+        """scheduler.run: nothing to do for an empty list"""
+        assert scheduler.run([], None, None, jobs=4) == []
+
+    def test_order(self):
+        """scheduler.run: results and output follow the input order"""
+
+        def replay(item):
+            # Make the first items the slowest ones.
+            time.sleep(0.01 * (5 - item))
+            print('replayed {}'.format(item))
+            return item * 10
+
+        f = io.StringIO()
+        with contextlib.redirect_stdout(f):
+            results = scheduler.run(range(5), lambda i: print('fetch {}'.format(i)),
+                                    replay, jobs=5)
+        assert results == [0, 10, 20, 30, 40]
+        assert f.getvalue() == ''.join(
+            'fetch {0}\nreplayed {0}\n'.format(i) for i in range(5))
+
+    @pytest.mark.parametrize('jobs', [1, 3])
+    def test_jobs(self, jobs):
+        """scheduler.run: no more than jobs replays run at once"""
+        tracker = _Tracker()
+        assert scheduler.run(range(8), lambda i: None, tracker,
+                             jobs=jobs) == list(range(8))
+        assert tracker.peak == jobs
+
+    def test_memory_budget(self):
+        """scheduler.run: the running replays fit in the memory budget"""
+        tracker = _Tracker()
+        scheduler.run(range(6), lambda i: None, tracker, jobs=6,
+                      memory_budget=250, cost=lambda i: 100)
+        assert tracker.peak == 2
+
+    def test_memory_budget_too_big(self):
+        """scheduler.run: an item over the whole budget replays alone"""
+        tracker = _Tracker()
+        assert scheduler.run(range(3), lambda i: None, tracker, jobs=3,
+                             memory_budget=50,
+                             cost=lambda i: 100) == [0, 1, 2]
+        assert tracker.peak == 1
+
+    def test_key(self):
+        """scheduler.run: items sharing a key don't replay at once"""
+        tracker = _Tracker()
+        scheduler.run(range(6), lambda i: None, tracker, jobs=6,
+                      key=lambda i: i % 2)
+        assert tracker.peak == 2
+        for item, overlap in tracker.overlaps:
+            assert all(i % 2 != item % 2 for i in overlap)
+
+    def test_fetch_overlaps_replay(self):
+        """scheduler.run: later items are fetched while earlier ones replay"""
+        fetched = []
+
+        def replay(item):
+            time.sleep(0.05)
+            return list(fetched)
+
+        results = scheduler.run(range(3), fetched.append, replay, jobs=1)
+        assert results[0] == [0, 1, 2]
+
+    def test_replay_error(self):
+        """scheduler.run: errors are raised once the other replays end"""
+        done = []
+
+        def replay(item):
+            if item == 0:
+                time.sleep(0.05)
+                raise RuntimeError('replay failed')
+            time.sleep(0.1)
+            done.append(item)
+
+        with pytest.raises(RuntimeError):
+            scheduler.run(range(2), lambda i: None, replay, jobs=2)
+        assert done == [1]
+
+    def test_fetch_error(self):
+        """scheduler.run: fetch errors are raised"""
+
+        def fetch(item):
+            raise OSError('download failed')
+
+        with pytest.raises(OSError):
+            scheduler.run(range(2), fetch, lambda i: i, jobs=2)
+
+
+class TestDefaults(object):
+    """Tests for the scheduler defaults."""
+
+    def test_jobs_env(self, mocker):
+        """scheduler.default_jobs: PIGLIT_REPLAY_JOBS is honoured"""
+        mocker.patch.dict('os.environ', {'PIGLIT_REPLAY_JOBS': '3'})
+        assert scheduler.default_jobs() == 3
+        assert scheduler.default_jobs(1) == 3
+
+    def test_jobs_fallback(self, mocker):
+        """scheduler.default_jobs: fallback is used when not configured"""
+        mocker.patch('framework.replay.scheduler.core.get_option',
+                     return_value=None)
+        assert scheduler.default_jobs(1) == 1
+        assert scheduler.default_jobs() >= 1
+
+    def test_memory_budget_env(self, mocker):
+        """scheduler.default_memory_budget: the value is in MiB"""
+        mocker.patch.dict('os.environ',
+                          {'PIGLIT_REPLAY_MEMORY_BUDGET': '2'})
+        assert scheduler.default_memory_budget() == 2 << 20
+
+    def test_file_cost(self, tmpdir):
+        """scheduler.file_cost: the size of the file, 0 if missing"""
+        f = tmpdir.join('trace')
+        f.write('x' * 10)
+        assert scheduler.file_cost(f.strpath) == 10
+        assert scheduler.file_cost(tmpdir.join('missing').strpath) == 0
@@ -0,0 +1,132 @@
+# coding=utf-8
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+# OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+# ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+# OTHER DEALINGS IN THE SOFTWARE.
+#
+# SPDX-License-Identifier: MIT
+
+
+"""Tests for replayer's trace_cache module."""
+
+import hashlib
+import os
+
+import pytest
+
+from framework import core
+from framework.replay import trace_cache
+
+# pylint: disable=no-self-use
+
+
+def _add(cache, tmpdir, url, content, mtime=None):
+    part = tmpdir.join('download.part')
+    part.write(content)
+    sha256 = hashlib.sha256(content.encode()).hexdigest()
+    blob = cache.add(url, part.strpath, sha256)
+    if mtime is not None:
+        os.utime(blob, (mtime, mtime))
+    return blob
+
+
+class TestTraceCache(object):
+    """Tests for trace_cache.TraceCache."""
+
+    @pytest.fixture(autouse=True)
+    def setup(self, tmpdir):
+        self.tmpdir = tmpdir
+        self.cache = trace_cache.TraceCache(tmpdir.join('cache').strpath)
+
+    def test_from_options_disabled(self, mocker):
+        """trace_cache.TraceCache.from_options: an empty directory disables it"""
+        mocker.patch.dict('os.environ', {'PIGLIT_REPLAY_CACHE_DIR': ''})
+        assert trace_cache.TraceCache.from_options() is None
+
+    def test_from_options(self, mocker):
+        """trace_cache.TraceCache.from_options: directory and size in MiB"""
+        mocker.patch.dict('os.environ', {
+            'PIGLIT_REPLAY_CACHE_DIR': self.tmpdir.strpath,
+            'PIGLIT_REPLAY_CACHE_SIZE': '3'})
+        cache = trace_cache.TraceCache.from_options()
+        assert cache.directory == self.tmpdir.strpath
+        assert cache.max_size == 3 << 20
+
+    def test_from_options_default_size(self, mocker):
+        """trace_cache.TraceCache.from_options: the size is bounded by default"""
+        mocker.patch.dict('os.environ', {
+            'PIGLIT_REPLAY_CACHE_DIR': self.tmpdir.strpath})
+        mocker.patch('framework.core.PIGLIT_CONFIG',
+                     core.PiglitConfig(allow_no_value=True))
+        cache = trace_cache.TraceCache.from_options()
+        assert cache.max_size == 20480 << 20
+
+    def test_from_options_unlimited(self, mocker):
+        """trace_cache.TraceCache.from_options: a size of 0 removes the limit"""
+        mocker.patch.dict('os.environ', {
+            'PIGLIT_REPLAY_CACHE_DIR': self.tmpdir.strpath,
+            'PIGLIT_REPLAY_CACHE_SIZE': '0'})
+        cache = trace_cache.TraceCache.from_options()
+        assert cache.max_size is None
+
+    def test_miss(self):
+        """trace_cache.TraceCache.install: nothing is placed for unknown URLs"""
+        dest = self.tmpdir.join('dest')
+        assert not self.cache.install('http://a/b.trace', dest.strpath)
+        assert not dest.check()
+
+    def test_add_install(self):
+        """trace_cache.TraceCache.install: places the content of a URL"""
+        blob = _add(self.cache, self.tmpdir, 'http://a/b.trace', 'content')
+        assert os.path.basename(blob) == hashlib.sha256(
+            b'content').hexdigest()
+        dest = self.tmpdir.join('dest')
+        assert self.cache.install('http://a/b.trace', dest.strpath)
+        assert dest.read() == 'content'
+
+    def test_same_content(self):
+        """trace_cache.TraceCache.add: URLs with the same content share a blob"""
+        first = _add(self.cache, self.tmpdir, 'http://a/b.trace', 'content')
+        second = _add(self.cache, self.tmpdir, 'http://c/d.trace', 'content')
+        assert first == second
+
+    def test_truncated_blob(self):
+        """trace_cache.TraceCache.install: a blob of the wrong size is a miss"""
+        blob = _add(self.cache, self.tmpdir, 'http://a/b.trace', 'content')
+        with open(blob, 'w') as f:
+            f.write('cont')
+        assert not self.cache.install('http://a/b.trace',
+                                      self.tmpdir.join('dest').strpath)
+
+    def test_evict_lru(self):
+        """trace_cache.TraceCache.evict: least recently used blobs go first"""
+        self.cache.max_size = 10
+        old = _add(self.cache, self.tmpdir, 'http://a/1', 'aaaa', mtime=100)
+        used = _add(self.cache, self.tmpdir, 'http://a/2', 'bbbb', mtime=200)
+        # Using a blob makes it the most recent one.
+        self.cache.install('http://a/1', self.tmpdir.join('dest').strpath)
+        new = _add(self.cache, self.tmpdir, 'http://a/3', 'cccc')
+
+        assert os.path.exists(old)
+        assert not os.path.exists(used)
+        assert os.path.exists(new)
+
+    def test_evict_keeps_new(self):
+        """trace_cache.TraceCache.add: a blob bigger than the budget is kept"""
+        self.cache.max_size = 2
+        blob = _add(self.cache, self.tmpdir, 'http://a/1', 'aaaa')
+        assert os.path.exists(blob)
@@ -0,0 +1,120 @@
+# coding=utf-8
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+# OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+# ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+# OTHER DEALINGS IN THE SOFTWARE.
+#
+# SPDX-License-Identifier: MIT
+
+
+"""Tests for replayer's trace_index module."""
+
+import hashlib
+import os
+
+import pytest
+
+from framework.replay import trace_index
+
+# pylint: disable=protected-access
+# pylint: disable=invalid-name
+# pylint: disable=no-self-use
+
+
+@pytest.fixture
+def index_dir(mocker, tmpdir):
+    mocker.patch.dict('os.environ')
+    directory = tmpdir.join('index').strpath
+    os.environ['PIGLIT_REPLAY_INDEX_DIR'] = directory
+    return directory
+
+
+class TestContentHash(object):
+    """Tests for the content_hash function."""
+
+    def test_sha256(self, tmpdir):
+        trace = tmpdir.join('a.trace')
+        trace.write_binary(b'trace content')
+        assert trace_index.content_hash(trace.strpath) == \
+            hashlib.sha256(b'trace content').hexdigest()
+
+    def test_missing(self, tmpdir):
+        assert trace_index.content_hash(tmpdir.join('nope').strpath) is None
+
+    def test_remembered(self, mocker, tmpdir, index_dir):
+        """The hash isn't recomputed while size and mtime are the same."""
+        trace = tmpdir.join('a.trace')
+        trace.write_binary(b'trace content')
+        first = trace_index.content_hash(trace.strpath, index_dir)
+
+        m = mocker.patch('framework.replay.trace_index._hash_file')
+        assert trace_index.content_hash(trace.strpath, index_dir) == first
+        assert not m.called
+
+    def test_modified(self, tmpdir, index_dir):
+        trace = tmpdir.join('a.trace')
+        trace.write_binary(b'trace content')
+        first = trace_index.content_hash(trace.strpath, index_dir)
+
+        trace.write_binary(b'other trace content')
+        assert trace_index.content_hash(trace.strpath, index_dir) != first
+
+
+class TestTraceIndex(object):
+    """Tests for the TraceIndex class."""
+
+    def test_disabled(self, mocker, tmpdir):
+        mocker.patch.dict('os.environ', {'PIGLIT_REPLAY_INDEX_DIR': ''})
+        trace = tmpdir.join('a.trace')
+        trace.write_binary(b'trace content')
+        assert trace_index.TraceIndex.for_trace(trace.strpath) is None
+
+    def test_missing_trace(self, tmpdir, index_dir):
+        assert trace_index.TraceIndex.for_trace(
+            tmpdir.join('nope').strpath) is None
+
+    def test_roundtrip(self, tmpdir, index_dir):
+        trace = tmpdir.join('a.trace')
+        trace.write_binary(b'trace content')
+        index = trace_index.TraceIndex.for_trace(trace.strpath)
+        assert index.get('last_frame_call') is None
+        index.update({'last_frame_call': 42, 'frames': [10, 42]})
+
+        index = trace_index.TraceIndex.for_trace(trace.strpath)
+        assert index.get('last_frame_call') == 42
+        assert index.get('frames') == [10, 42]
+
+    def test_keyed_by_content(self, tmpdir, index_dir):
+        """Copies of a trace share their index."""
+        a = tmpdir.join('a.trace')
+        b = tmpdir.join('sub', 'b.trace')
+        a.write_binary(b'trace content')
+        b.write_binary(b'trace content', ensure=True)
+        trace_index.TraceIndex.for_trace(a.strpath).update(
+            {'last_frame_call': 42})
+        assert trace_index.TraceIndex.for_trace(b.strpath).get(
+            'last_frame_call') == 42
+
+    def test_corrupt(self, tmpdir, index_dir):
+        trace = tmpdir.join('a.trace')
+        trace.write_binary(b'trace content')
+        index = trace_index.TraceIndex.for_trace(trace.strpath)
+        os.makedirs(os.path.dirname(index.filename))
+        with open(index.filename, 'w') as f:
+            f.write('{not json')
+        index = trace_index.TraceIndex.for_trace(trace.strpath)
+        assert index.get('last_frame_call') is None
@@ -254,6 +254,60 @@ class TestGetOptions(object):
                             required=True)
 
 
+class TestGetCacheDir(object):
+    """Tests for the get_cache_dir function."""
+
+    @pytest.fixture
+    def env(self, mocker):
+        """Create a mocked os.environ."""
+        return mocker.patch('framework.core.os.environ', {})
+
+    @pytest.fixture
+    def conf(self, mocker):
+        """Create an empty piglit.conf."""
+        conf = core.PiglitConfig(allow_no_value=True)
+        mocker.patch('framework.core.PIGLIT_CONFIG', conf)
+        return conf
+
+    def test_default(self, env, conf):
+        """core.get_cache_dir: defaults to a directory in XDG_CACHE_HOME."""
+        env['XDG_CACHE_HOME'] = '/cache'
+        assert core.get_cache_dir('TEST', ('foo', 'bar'), 'name') == \
+            os.path.join('/cache', 'piglit', 'name')
+
+    def test_default_home(self, env, conf):
+        """core.get_cache_dir: defaults to ~/.cache without XDG_CACHE_HOME."""
+        assert core.get_cache_dir('TEST', ('foo', 'bar'), 'name') == \
+            os.path.join(os.path.expanduser('~/.cache'), 'piglit', 'name')
+
+    def test_from_conf(self, env, conf):
+        """core.get_cache_dir: the value is taken from piglit.conf."""
+        conf.add_section('foo')
+        conf.set('foo', 'bar', '/conf')
+        assert core.get_cache_dir('TEST', ('foo', 'bar'), 'name') == '/conf'
+
+    def test_from_env(self, env, conf):
+        """core.get_cache_dir: the environment overrides piglit.conf."""
+        conf.add_section('foo')
+        conf.set('foo', 'bar', '/conf')
+        env['TEST'] = '/env'
+        assert core.get_cache_dir('TEST', ('foo', 'bar'), 'name') == '/env'
+
+    def test_empty_conf(self, env, conf):
+        """core.get_cache_dir: an empty piglit.conf value disables the
+        cache.
+        """
+        conf.read_string('[foo]\nbar=\n')
+        assert core.get_cache_dir('TEST', ('foo', 'bar'), 'name') is None
+
+    def test_empty_env(self, env, conf):
+        """core.get_cache_dir: an empty environment variable disables the
+        cache.
+        """
+        env['TEST'] = ''
+        assert core.get_cache_dir('TEST', ('foo', 'bar'), 'name') is None
+
+
 class TestCheckDir(object):
     """Tests for core.check_dir."""
 
@@ -26,6 +26,7 @@ import pytest
 from framework import exceptions
 from framework import grouptools
 from framework import profile
+from framework.test.base import DummyTest
 from . import utils
 
 # pylint: disable=invalid-name,no-self-use,protected-access
@@ -284,3 +285,61 @@ class TestRegexFilter(object):
             """Returns False when the test matches any regex."""
             test = profile.RegexFilter([r'fob', r'bar'], inverse=True)
             assert test('foobob', None)
+
+
+class TestIndexedProfile(object):
+    """Tests for the IndexedProfile class."""
+
+    @pytest.fixture
+    def inst(self, tmpdir):
+        from tests import serializer
+        from framework.test.piglit_test import PiglitGLTest
+
+        orig = profile.TestProfile()
+        orig.test_list['a'] = PiglitGLTest(
+            ['a', '-auto'], run_concurrent=True, env={'FOO': 'bar'},
+            require_platforms=['glx'])
+        orig.test_list['b'] = PiglitGLTest(
+            ['b'], exclude_platforms=['gbm', 'wayland'], cwd='/tmp')
+        orig.test_list['c'] = PiglitGLTest(['c'], run_concurrent=False)
+
+        filename = str(tmpdir.join('foo.pidx'))
+        serializer.index_serializer('foo', orig, filename)
+        return profile.IndexedProfile(filename)
+
+    def test_len(self, inst):
+        assert len(inst) == 3
+
+    def test_round_trip(self, inst):
+        tests = dict(inst.itertests())
+        assert sorted(tests) == ['a', 'b', 'c']
+        assert tests['a'].command[0].endswith('a')
+        assert tests['a'].run_concurrent is True
+        assert tests['a'].env == {'FOO': 'bar'}
+        assert tests['a'].require_platforms == ['glx']
+        assert tests['b'].exclude_platforms == ['gbm', 'wayland']
+        assert tests['b'].cwd == '/tmp'
+        assert tests['c'].run_concurrent is False
+
+    def test_forced_test_list(self, inst):
+        inst.forced_test_list = ['c', 'a']
+        assert [n for n, _ in inst.itertests()] == ['c', 'a']
+
+    def test_forced_test_list_missing(self, inst):
+        inst.forced_test_list = ['d']
+        with pytest.raises(KeyError):
+            list(inst.itertests())
+
+    def test_forced_test_list_ignore_missing(self, inst):
+        inst.forced_test_list = ['a', 'd']
+        inst.options['ignore_missing'] = True
+        tests = dict(inst.itertests())
+        assert isinstance(tests['d'], DummyTest)
+
+    def test_filters(self, inst):
+        inst.filters.append(profile.RegexFilter(['b']))
+        inst.forced_test_list = ['a', 'b']
+        inst.options['ignore_missing'] = True
+        tests = dict(inst.itertests())
+        assert isinstance(tests['a'], DummyTest)
+        assert not isinstance(tests['b'], DummyTest)
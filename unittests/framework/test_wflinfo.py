@@ -21,6 +21,7 @@
 
 """Test the wflinfo module."""
 
+import os
 import subprocess
 import textwrap
 try:
@@ -63,6 +64,8 @@ class TestWflInfo(object):
             # shared_state with a mock value so it's reset after each test
             with mock.patch.dict('framework.wflinfo.OPTIONS.env',
                                  {'PIGLIT_PLATFORM': 'foo'}), \
+                    mock.patch.dict('os.environ',
+                                    {'PIGLIT_WFLINFO_CACHE_DIR': ''}), \
                     mock.patch(
                         'framework.wflinfo.WflInfo._WflInfo__shared_state',
                         {}):
@@ -243,6 +246,8 @@ class TestWflInfo(object):
 
             with mock.patch.dict('framework.wflinfo.OPTIONS.env',
                                  {'PIGLIT_PLATFORM': 'foo'}), \
+                    mock.patch.dict('os.environ',
+                                    {'PIGLIT_WFLINFO_CACHE_DIR': ''}), \
                     mock.patch(
                         'framework.wflinfo.subprocess.check_output',
                         mock.Mock(return_value=rv)):
@@ -354,3 +359,118 @@ class TestWflInfo(object):
             gracefully.
             """
             assert inst.core.shader_version == 0.0
+
+
+class TestProfileCache(object):
+    """Tests for the on-disk wflinfo cache."""
+
+    RV = textwrap.dedent("""\
+        Waffle platform: gbm
+        Waffle api: gl
+        OpenGL vendor string: Intel Open Source Technology Center
+        OpenGL renderer string: Mesa DRI Intel(R) Haswell Mobile
+        OpenGL version string: 4.5 (Core Profile) Mesa 11.0.4
+        OpenGL context flags: 0x0
+        OpenGL shading language version string: 4.50
+        OpenGL extensions: GL_foobar GL_ham_sandwhich
+    """).encode('utf-8')
+
+    @pytest.fixture(autouse=True)
+    def patch(self, tmpdir):
+        """Point the cache at a temporary directory."""
+        with mock.patch.dict('framework.wflinfo.OPTIONS.env',
+                             {'PIGLIT_PLATFORM': 'foo'}), \
+                mock.patch.dict('os.environ',
+                                {'PIGLIT_WFLINFO_CACHE_DIR': str(tmpdir)}), \
+                mock.patch('framework.wflinfo.WflInfo._WflInfo__shared_state',
+                           {}):
+            yield
+
+    def test_round_trip(self, tmpdir):
+        """wflinfo.ProfileCache: values stored are read back by a new
+        instance.
+        """
+        identity = {'renderer': 'foo'}
+        cache = wflinfo.ProfileCache(str(tmpdir), identity)
+        cache.put('core', wflinfo.ProfileInfo(4.5, 4.6, {'GL_foo'}))
+
+        info = wflinfo.ProfileCache(str(tmpdir), identity).get('core')
+        assert info.shader_version == 4.5
+        assert info.api_version == 4.6
+        assert info.extensions == {'GL_foo'}
+
+    def test_identity(self, tmpdir):
+        """wflinfo.ProfileCache: a different identity doesn't hit."""
+        cache = wflinfo.ProfileCache(str(tmpdir), {'renderer': 'foo'})
+        cache.put('core', wflinfo.ProfileInfo(4.5, 4.6, {'GL_foo'}))
+
+        cache = wflinfo.ProfileCache(str(tmpdir), {'renderer': 'bar'})
+        assert cache.get('core') is None
+
+    def test_corrupt(self, tmpdir):
+        """wflinfo.ProfileCache: an unreadable file is treated as empty."""
+        cache = wflinfo.ProfileCache(str(tmpdir), {'renderer': 'foo'})
+        with open(cache.filename, 'w') as f:
+            f.write('{not json')
+
+        cache = wflinfo.ProfileCache(str(tmpdir), {'renderer': 'foo'})
+        assert cache.get('core') is None
+
+    def test_warm_run(self):
+        """wflinfo.WflInfo: a warm cache only needs the identity query."""
+        mocked = mock.Mock(return_value=self.RV)
+        with mock.patch('framework.wflinfo.subprocess.check_output', mocked):
+            assert wflinfo.WflInfo().core.api_version == 4.5
+        assert mocked.call_count == 2
+
+        mocked = mock.Mock(return_value=self.RV)
+        with mock.patch('framework.wflinfo.WflInfo._WflInfo__shared_state',
+                        {}), \
+                mock.patch('framework.wflinfo.subprocess.check_output',
+                           mocked):
+            info = wflinfo.WflInfo().core
+        assert mocked.call_count == 1
+        assert info.shader_version == 4.5
+        assert info.extensions == {'GL_foobar', 'GL_ham_sandwhich'}
+
+    def test_driver_override(self):
+        """wflinfo.WflInfo: a driver override env var doesn't hit a cache
+        written without it.
+        """
+        mocked = mock.Mock(return_value=self.RV)
+        with mock.patch('framework.wflinfo.subprocess.check_output', mocked):
+            assert wflinfo.WflInfo().core.api_version == 4.5
+
+        mocked = mock.Mock(return_value=self.RV)
+        with mock.patch('framework.wflinfo.WflInfo._WflInfo__shared_state',
+                        {}), \
+                mock.patch.dict('os.environ',
+                                {'MESA_EXTENSION_OVERRIDE': '-GL_foobar'}), \
+                mock.patch('framework.wflinfo.subprocess.check_output',
+                           mocked):
+            assert wflinfo.WflInfo().core.api_version == 4.5
+        assert mocked.call_count == 2
+
+    def test_gl_error_not_cached(self, tmpdir):
+        """wflinfo.WflInfo: a WFLINFO_GL_ERROR identity isn't cached."""
+        rv = self.RV.replace(b'4.5 (Core Profile) Mesa 11.0.4',
+                             b'WFLINFO_GL_ERROR')
+        mocked = mock.Mock(return_value=rv)
+        with mock.patch('framework.wflinfo.subprocess.check_output', mocked):
+            wflinfo.WflInfo().core
+        assert tmpdir.listdir() == []
+
+    def test_empty_conf_disables(self, mocker):
+        """wflinfo.WflInfo: an empty [wflinfo]:cache_dir disables the
+        cache.
+        """
+        conf = mocker.patch('framework.core.PIGLIT_CONFIG.safe_get',
+                            mocker.Mock(return_value=''))
+        mocker.patch.dict('os.environ')
+        del os.environ['PIGLIT_WFLINFO_CACHE_DIR']
+        mocked = mock.Mock(return_value=self.RV)
+        with mock.patch('framework.wflinfo.subprocess.check_output', mocked):
+            assert wflinfo.WflInfo().core.api_version == 4.5
+        # Only the profile probe, no identity query.
+        assert mocked.call_count == 1
+        conf.assert_called_with('wflinfo', 'cache_dir')
@@ -0,0 +1,82 @@
+# coding=utf-8
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+# OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+# ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+# OTHER DEALINGS IN THE SOFTWARE.
+#
+# SPDX-License-Identifier: MIT
+
+"""Tests for generated_tests/builtin_function.py"""
+
+import numpy as np
+
+# pylint can't figure out the sys.path manipulation.
+from generated_tests import builtin_function  # pylint: disable=import-error
+
+
+def _inputs(*columns):
+    return builtin_function.make_arguments(columns)
+
+
+def test_simulate_batch_rounding():
+    """builtin_function._simulate_batch: rounds like one call at a time"""
+    inputs = _inputs(np.linspace(-np.pi, np.pi, 7))
+    batch = builtin_function._simulate_batch(
+        inputs, np.sin, builtin_function._trig_tolerance)
+    assert len(batch) == len(inputs)
+    for (x,), vector in zip(inputs, batch):
+        expected = np.sin(np.float64(x))
+        assert vector.arguments == (x,)
+        assert isinstance(vector.result, np.float32)
+        assert vector.result == builtin_function.round_to_32_bits(expected)
+        assert vector.tolerance == builtin_function.round_to_32_bits(
+            builtin_function._trig_tolerance((x,), expected))
+
+
+def test_simulate_batch_undefined():
+    """builtin_function._simulate_batch: skips undefined results"""
+    inputs = _inputs([-1.0, 0.0, 2.0], [-1.0, 2.0])
+    batch = builtin_function._simulate_batch(
+        inputs, builtin_function._pow, builtin_function._strict_tolerance)
+    assert [v.arguments for v in batch] == \
+        [(0.0, 2.0), (2.0, -1.0), (2.0, 2.0)]
+    assert [v.result for v in batch] == [0.0, 0.5, 4.0]
+
+
+def test_simulate_batch_integer():
+    """builtin_function._simulate_batch: integer results have no tolerance
+    """
+    inputs = _inputs([np.int32(-5), np.int32(3)], [np.int32(1)])
+    batch = builtin_function._simulate_batch(
+        inputs, np.minimum, builtin_function._strict_tolerance)
+    assert [v.result for v in batch] == [-5, 1]
+    assert all(isinstance(v.result, np.int32) for v in batch)
+    assert all(v.tolerance == 0.0 for v in batch)
+
+
+def test_glsl_type_of_cache():
+    """builtin_function.glsl_type_of: distinguishes dtypes and shapes"""
+    assert builtin_function.glsl_type_of(np.float32(1.0)) == \
+        builtin_function.glsl_float
+    assert builtin_function.glsl_type_of(np.int32(1)) == \
+        builtin_function.glsl_int
+    assert builtin_function.glsl_type_of(np.zeros(3)) == \
+        builtin_function.glsl_vec3
+    assert builtin_function.glsl_type_of(np.zeros(3, dtype=np.uint32)) == \
+        builtin_function.glsl_uvec3
+    assert builtin_function.glsl_type_of(np.zeros((2, 3))) == \
+        builtin_function.glsl_mat3x2
@@ -0,0 +1,126 @@
+# coding=utf-8
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+# OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+# ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+# OTHER DEALINGS IN THE SOFTWARE.
+#
+# SPDX-License-Identifier: MIT
+
+"""Tests for generated_tests/modules/utils.py"""
+
+import os
+
+import pytest
+
+# pylint can't figure out the sys.path manipulation.
+from generated_tests.modules import utils  # pylint: disable=import-error
+
+
+def test_write_if_changed_new(tmpdir):
+    """modules.utils.write_if_changed: writes a new file"""
+    f = tmpdir.join('test')
+    assert utils.write_if_changed(f.strpath, 'content')
+    assert f.read() == 'content'
+
+
+def test_write_if_changed_same(tmpdir):
+    """modules.utils.write_if_changed: leaves an identical file alone"""
+    f = tmpdir.join('test')
+    f.write('content')
+    os.utime(f.strpath, (0, 0))
+    assert not utils.write_if_changed(f.strpath, 'content')
+    assert f.mtime() == 0
+
+
+def test_write_if_changed_different(tmpdir):
+    """modules.utils.write_if_changed: replaces a different file"""
+    f = tmpdir.join('test')
+    f.write('old')
+    assert utils.write_if_changed(f.strpath, 'new')
+    assert f.read() == 'new'
+    assert tmpdir.listdir() == [f]
+
+
+def test_open_if_changed(tmpdir):
+    """modules.utils.open_if_changed: writes when closed"""
+    f = tmpdir.join('test')
+    with utils.open_if_changed(f.strpath) as out:
+        out.write('con')
+        out.write('tent')
+        assert not f.check()
+    assert f.read() == 'content'
+
+
+def test_open_if_changed_exception(tmpdir):
+    """modules.utils.open_if_changed: an exception discards the content"""
+    f = tmpdir.join('t.txt')
+    f.write('old')
+    with pytest.raises(RuntimeError):
+        with utils.open_if_changed(f.strpath) as out:
+            out.write('partial')
+            raise RuntimeError
+    assert f.read() == 'old'
+    assert tmpdir.listdir() == [f]
+
+
+def test_frame_script():
+    """modules.utils.frame_script: prefixes the size in bytes and the name"""
+    assert (utils.frame_script('a/b.shader_test', 'caf\u00e9\n') ==
+            b'6 a/b.shader_test\ncaf\xc3\xa9\n')
+
+
+def test_open_if_changed_stream(tmpdir, mocker):
+    """modules.utils.open_if_changed: streams shader_test scripts"""
+    stream = tmpdir.join('stream')
+    mocker.patch.dict(os.environ,
+                      {'PIGLIT_GENERATOR_STREAM': stream.strpath})
+    mocker.patch.object(utils, '_stream', None)
+    for name in ('a.shader_test', 'b.shader_test', 'c.vert'):
+        with utils.open_if_changed(tmpdir.join(name).strpath) as out:
+            out.write(name)
+    utils._stream.close()
+
+    assert stream.read_binary() == (
+        utils.frame_script(tmpdir.join('a.shader_test').strpath,
+                           'a.shader_test') +
+        utils.frame_script(tmpdir.join('b.shader_test').strpath,
+                           'b.shader_test'))
+    assert not tmpdir.join('a.shader_test').check()
+    assert tmpdir.join('c.vert').read() == 'c.vert'
+
+
+def test_parallel_map():
+    """modules.utils.parallel_map: results keep the order of the items"""
+    offset = 10
+    assert (utils.parallel_map(lambda x: x + offset, range(100), jobs=4) ==
+            [x + offset for x in range(100)])
+
+
+def test_parallel_map_serial():
+    """modules.utils.parallel_map: a single job runs in this process"""
+    seen = []
+    assert utils.parallel_map(seen.append, range(3), jobs=1) == [None] * 3
+    assert seen == [0, 1, 2]
+
+
+def test_parallel_map_default_serial(mocker):
+    """modules.utils.parallel_map: runs in this process by default"""
+    mocker.patch.dict(os.environ)
+    os.environ.pop('PIGLIT_GENERATOR_JOBS', None)
+    seen = []
+    utils.parallel_map(seen.append, range(3))
+    assert seen == [0, 1, 2]